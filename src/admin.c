@@ -0,0 +1,680 @@
+/*
+ -- SOURCE FILE: admin.c
+ --
+ -- PROGRAM: Web Client Emulator
+ --
+ -- FUNCTIONS:
+ -- int adminStart(int port, const char *engine);
+ -- static void *adminLoop(void *data);
+ -- static void answerScrape(int socket, char *page);
+ -- static int describeMetrics(char *page, size_t length);
+ -- static void describeAdmission(char *page, size_t length, int *used);
+ -- static void describeLoops(char *page, size_t length, int *used,
+ --                           unsigned long long now);
+ -- static int loopTimes(const engineCounters *loop, unsigned long long now,
+ --                      unsigned long long *busy, unsigned long long *idle);
+ -- static void appendText(char *page, size_t length, int *used,
+ --                        const char *format, ...);
+ -- static void appendHeader(char *page, size_t length, int *used,
+ --                          const char *name, const char *type,
+ --                          const char *help);
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Added the admission control metrics.
+ -- October 18, 2026 - Added the connections closed on errors.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- NOTES:
+ -- An admin port for the servers. Each HTTP request to it is answered with a
+ -- snapshot of the engine statistics in the Prometheus text format:
+ --
+ --     open connections, and the connections accepted and rejected
+ --     connections closed on an error, by type
+ --     requests answered and bytes sent, with system calls and context
+ --     switches
+ --     accepts and requests per second since the last scrape
+ --     a histogram of the time taken to answer a request
+ --     the busy and idle time of every event loop, and its utilization since
+ --     the last scrape
+ --     the state of admission control, when it is on
+ --
+ -- The port is served by its own thread with its own epoll loop, so a scrape
+ -- never waits on a serving thread or the other way around. The counters are
+ -- read straight from the engine registry without a lock, see engineStats.c.
+ -- A scrape is answered in full and the connection closed, a scraper that
+ -- stops reading is given up on after ADMIN_SEND_TIMEOUT seconds.
+ */
+
+// Includes
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "admin.h"
+#include "admission.h"
+#include "engineStats.h"
+#include "network.h"
+#include "timing.h"
+
+static void *adminLoop(void *data);
+static void answerScrape(int socket, char *page);
+static int describeMetrics(char *page, size_t length);
+static void describeAdmission(char *page, size_t length, int *used);
+static void describeLoops(char *page, size_t length, int *used,
+                          unsigned long long now);
+static int loopTimes(const engineCounters *loop, unsigned long long now,
+                     unsigned long long *busy, unsigned long long *idle);
+static void appendText(char *page, size_t length, int *used,
+                       const char *format, ...);
+static void appendHeader(char *page, size_t length, int *used,
+                         const char *name, const char *type,
+                         const char *help);
+
+/* The engine being served and the counters as of the last scrape, only the
+ admin thread uses them */
+static const char *engineName = 0;
+static engineCounters previous;
+static unsigned long long previousTime = 0;
+static unsigned long long previousBusy[ADMIN_MAX_LOOPS];
+static unsigned long long previousIdle[ADMIN_MAX_LOOPS];
+
+/*
+ -- FUNCTION: adminStart
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int adminStart(int port, const char *engine);
+ --
+ -- RETURNS: 0 on success, -1 if the port could not be opened or the thread
+ --          started
+ --
+ -- NOTES:
+ -- Listens on the admin port and starts the thread that answers it. The
+ -- engine name is put in the server_info metric.
+ */
+int adminStart(int port, const char *engine)
+{
+    int *listenSocket = 0;
+    pthread_t thread = 0;
+    pthread_attr_t attr;
+    int result = 0;
+    
+    if ((listenSocket = malloc(sizeof(int))) == NULL)
+    {
+        return -1;
+    }
+    
+    if ((*listenSocket = tcpSocket()) == -1 ||
+        setReuse(listenSocket) == -1 ||
+        bindAddress(&port, listenSocket) == -1 ||
+        setListen(listenSocket) == -1 ||
+        makeSocketNonBlocking(listenSocket) == -1)
+    {
+        free(listenSocket);
+        return -1;
+    }
+    
+    engineName = engine;
+    memset(&previous, 0, sizeof(engineCounters));
+    previousTime = timingNow();
+    
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    result = pthread_create(&thread, &attr, adminLoop, listenSocket);
+    pthread_attr_destroy(&attr);
+    
+    return (result == 0) ? 0 : -1;
+}
+
+/*
+ -- FUNCTION: adminLoop
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void *adminLoop(void *data);
+ --
+ -- RETURNS: NULL, it never returns
+ --
+ -- NOTES:
+ -- The epoll loop of the admin thread. New connections are accepted and
+ -- watched, and each is answered and closed once its request arrives. The
+ -- thread never joins the engine registry, so its own system calls are not
+ -- counted as the server's.
+ */
+static void *adminLoop(void *data)
+{
+    int listenSocket = *(int *)data;
+    int epoll = 0;
+    int ready = 0;
+    int index = 0;
+    int client = 0;
+    char *page = 0;
+    struct timeval timeout;
+    struct epoll_event event;
+    struct epoll_event events[16];
+    
+    free(data);
+    
+    if ((page = malloc(ADMIN_PAGE_SIZE)) == NULL ||
+        (epoll = epoll_create1(0)) == -1)
+    {
+        perror("Admin port stopped");
+        return NULL;
+    }
+    
+    event.events = EPOLLIN;
+    event.data.fd = listenSocket;
+    if (epoll_ctl(epoll, EPOLL_CTL_ADD, listenSocket, &event) == -1)
+    {
+        perror("Admin port stopped");
+        return NULL;
+    }
+    
+    timeout.tv_sec = ADMIN_SEND_TIMEOUT;
+    timeout.tv_usec = 0;
+    
+    while (1)
+    {
+        if ((ready = epoll_wait(epoll, events, 16, -1)) == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("Admin port stopped");
+            return NULL;
+        }
+        
+        for (index = 0; index < ready; index++)
+        {
+            if (events[index].data.fd != listenSocket)
+            {
+                answerScrape(events[index].data.fd, page);
+                close(events[index].data.fd);
+                continue;
+            }
+            
+            while ((client = acceptConnection(&listenSocket)) != -1)
+            {
+                setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+                           sizeof(timeout));
+                event.events = EPOLLIN;
+                event.data.fd = client;
+                if (epoll_ctl(epoll, EPOLL_CTL_ADD, client, &event) == -1)
+                {
+                    close(client);
+                }
+            }
+        }
+    }
+    
+    return NULL;
+}
+
+/*
+ -- FUNCTION: answerScrape
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void answerScrape(int socket, char *page);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Reads the request and sends the metrics for a GET of / or /metrics, and a
+ -- 404 for anything else. Scrapers send the whole request at once, so only
+ -- the first read is looked at.
+ */
+static void answerScrape(int socket, char *page)
+{
+    int length = 0;
+    int headerLength = 0;
+    int sent = 0;
+    char request[ADMIN_REQUEST_SIZE];
+    char header[256];
+    
+    if ((length = recv(socket, request, sizeof(request) - 1, 0)) <= 0)
+    {
+        return;
+    }
+    request[length] = '\0';
+    
+    if (strncmp(request, "GET / ", 6) == 0 ||
+        strncmp(request, "GET /metrics ", 13) == 0 ||
+        strncmp(request, "GET /metrics?", 13) == 0)
+    {
+        length = describeMetrics(page, ADMIN_PAGE_SIZE);
+        headerLength = snprintf(header, sizeof(header),
+                                "HTTP/1.0 200 OK\r\n"
+                                "Content-Type: text/plain; version=0.0.4\r\n"
+                                "Content-Length: %d\r\n"
+                                "Connection: close\r\n\r\n", length);
+    }
+    else
+    {
+        length = snprintf(page, ADMIN_PAGE_SIZE, "Not found\n");
+        headerLength = snprintf(header, sizeof(header),
+                                "HTTP/1.0 404 Not Found\r\n"
+                                "Content-Type: text/plain\r\n"
+                                "Content-Length: %d\r\n"
+                                "Connection: close\r\n\r\n", length);
+    }
+    
+    if (send(socket, header, headerLength, MSG_NOSIGNAL | MSG_MORE) !=
+        headerLength)
+    {
+        return;
+    }
+    while (length > 0 &&
+           (sent = send(socket, page, length, MSG_NOSIGNAL)) > 0)
+    {
+        page += sent;
+        length -= sent;
+    }
+}
+
+/*
+ -- FUNCTION: describeMetrics
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Added the rejected connections and the
+ -- admission control state.
+ -- October 18, 2026 - Added the connection errors.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int describeMetrics(char *page, size_t length);
+ --
+ -- RETURNS: the length of the page
+ --
+ -- NOTES:
+ -- Writes every metric of the server to the page. The rates are over the
+ -- time since the last scrape, or since the admin port opened for the first.
+ -- Latency bucket counts are cumulative, as Prometheus expects.
+ */
+static int describeMetrics(char *page, size_t length)
+{
+    int used = 0;
+    unsigned int bucket = 0;
+    unsigned int type = 0;
+    unsigned long long now = timingNow();
+    unsigned long long below = 0;
+    double elapsed = 0;
+    engineCounters total;
+    
+    engineSum(&total);
+    elapsed = (now - previousTime) / 1e9;
+    if (elapsed <= 0)
+    {
+        elapsed = 1e-9;
+    }
+    
+    appendHeader(page, length, &used, "server_info", "gauge",
+                 "The engine serving requests.");
+    appendText(page, length, &used, "server_info{engine=\"%s\"} 1\n",
+               engineName);
+    
+    appendHeader(page, length, &used, "server_connections", "gauge",
+                 "Client connections open now.");
+    appendText(page, length, &used, "server_connections %llu\n",
+               total.accepts - total.closes);
+    
+    appendHeader(page, length, &used, "server_accepts_total", "counter",
+                 "Client connections accepted.");
+    appendText(page, length, &used, "server_accepts_total %llu\n",
+               total.accepts);
+    
+    appendHeader(page, length, &used, "server_rejected_total", "counter",
+                 "Client connections reset by admission control.");
+    appendText(page, length, &used, "server_rejected_total %llu\n",
+               total.rejected);
+    
+    appendHeader(page, length, &used, "server_connection_errors_total",
+                 "counter", "Client connections closed on an error, by type.");
+    for (type = 0; type < ENGINE_ERROR_TYPES; type++)
+    {
+        appendText(page, length, &used,
+                   "server_connection_errors_total{type=\"%s\"} %llu\n",
+                   engineErrorName(type), total.errors[type]);
+    }
+    
+    appendHeader(page, length, &used, "server_accepts_per_second", "gauge",
+                 "Connections accepted per second since the last scrape.");
+    appendText(page, length, &used, "server_accepts_per_second %.1f\n",
+               (total.accepts - previous.accepts) / elapsed);
+    
+    appendHeader(page, length, &used, "server_requests_total", "counter",
+                 "Requests answered.");
+    appendText(page, length, &used, "server_requests_total %llu\n",
+               total.requests);
+    
+    appendHeader(page, length, &used, "server_requests_per_second", "gauge",
+                 "Requests answered per second since the last scrape.");
+    appendText(page, length, &used, "server_requests_per_second %.1f\n",
+               (total.requests - previous.requests) / elapsed);
+    
+    appendHeader(page, length, &used, "server_sent_bytes_total", "counter",
+                 "Bytes sent to clients.");
+    appendText(page, length, &used, "server_sent_bytes_total %llu\n",
+               total.network.sent);
+    
+    appendHeader(page, length, &used, "server_syscalls_total", "counter",
+                 "System calls made serving clients.");
+    appendText(page, length, &used, "server_syscalls_total %llu\n",
+               total.network.syscalls);
+    
+    appendHeader(page, length, &used, "server_context_switches_total",
+                 "counter", "Context switches of the serving threads.");
+    appendText(page, length, &used,
+               "server_context_switches_total{kind=\"voluntary\"} %llu\n"
+               "server_context_switches_total{kind=\"involuntary\"} %llu\n",
+               total.voluntary, total.involuntary);
+    
+    appendHeader(page, length, &used, "server_request_duration_seconds",
+                 "histogram", "Time from reading a request to sending the "
+                 "last byte of its reply.");
+    for (bucket = 0; bucket < ENGINE_LATENCY_BUCKETS; bucket++)
+    {
+        below += total.latency[bucket];
+        if (engineBucketBound(bucket) != 0)
+        {
+            appendText(page, length, &used, "server_request_duration_seconds"
+                       "_bucket{le=\"%g\"} %llu\n",
+                       engineBucketBound(bucket) / 1e9, below);
+        }
+        else
+        {
+            appendText(page, length, &used, "server_request_duration_seconds"
+                       "_bucket{le=\"+Inf\"} %llu\n", below);
+        }
+    }
+    appendText(page, length, &used,
+               "server_request_duration_seconds_sum %.9f\n"
+               "server_request_duration_seconds_count %llu\n",
+               total.latencyTotal / 1e9, below);
+    
+    describeLoops(page, length, &used, now);
+    describeAdmission(page, length, &used);
+    
+    memcpy(&previous, &total, sizeof(engineCounters));
+    previousTime = now;
+    
+    return used;
+}
+
+/*
+ -- FUNCTION: describeAdmission
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void describeAdmission(char *page, size_t length,
+ --                                          int *used);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Writes the requests in flight and whether the server is shedding or has
+ -- stopped accepting, if admission control is on.
+ */
+static void describeAdmission(char *page, size_t length, int *used)
+{
+    admissionStatus status;
+    
+    if (!admissionEnabled())
+    {
+        return;
+    }
+    admissionState(&status);
+    
+    appendHeader(page, length, used, "server_in_flight", "gauge",
+                 "Requests read and not yet answered.");
+    appendText(page, length, used, "server_in_flight %u\n", status.inFlight);
+    
+    appendHeader(page, length, used, "server_shedding", "gauge",
+                 "1 while the queue delay is over target and connections "
+                 "are being shed.");
+    appendText(page, length, used, "server_shedding %d\n", status.shedding);
+    
+    appendHeader(page, length, used, "server_shed_count", "gauge",
+                 "Connections shed in the current spell of shedding.");
+    appendText(page, length, used, "server_shed_count %u\n",
+               status.shedding ? status.dropCount : 0);
+    
+    appendHeader(page, length, used, "server_accepting", "gauge",
+                 "0 while the server has stopped accepting connections.");
+    appendText(page, length, used, "server_accepting %d\n", !status.paused);
+}
+
+/*
+ -- FUNCTION: describeLoops
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void describeLoops(char *page, size_t length,
+ --                                      int *used, unsigned long long now);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Writes the busy and idle time of every thread that runs an event loop,
+ -- labelled by its place in the registry, and the busy share of the time
+ -- since the last scrape. The samples of each metric have to follow its
+ -- header, so the registry is walked once per metric.
+ */
+static void describeLoops(char *page, size_t length, int *used,
+                          unsigned long long now)
+{
+    unsigned long long busy = 0;
+    unsigned long long idle = 0;
+    unsigned long long spent = 0;
+    engineCounters *loop = 0;
+    
+    appendHeader(page, length, used, "server_loop_busy_seconds_total",
+                 "counter", "Time each event loop spent working.");
+    for (loop = engineThreads(); loop != NULL; loop = loop->next)
+    {
+        if (loopTimes(loop, now, &busy, &idle))
+        {
+            appendText(page, length, used,
+                       "server_loop_busy_seconds_total{loop=\"%u\"} %.6f\n",
+                       loop->index, busy / 1e9);
+        }
+    }
+    
+    appendHeader(page, length, used, "server_loop_idle_seconds_total",
+                 "counter", "Time each event loop spent waiting for events.");
+    for (loop = engineThreads(); loop != NULL; loop = loop->next)
+    {
+        if (loopTimes(loop, now, &busy, &idle))
+        {
+            appendText(page, length, used,
+                       "server_loop_idle_seconds_total{loop=\"%u\"} %.6f\n",
+                       loop->index, idle / 1e9);
+        }
+    }
+    
+    appendHeader(page, length, used, "server_loop_utilization", "gauge",
+                 "Share of the time since the last scrape each event loop "
+                 "spent working.");
+    for (loop = engineThreads(); loop != NULL; loop = loop->next)
+    {
+        if (!loopTimes(loop, now, &busy, &idle) ||
+            loop->index >= ADMIN_MAX_LOOPS)
+        {
+            continue;
+        }
+        spent = (busy - previousBusy[loop->index]) +
+                (idle - previousIdle[loop->index]);
+        appendText(page, length, used,
+                   "server_loop_utilization{loop=\"%u\"} %.4f\n",
+                   loop->index, spent ? (double)(busy -
+                   previousBusy[loop->index]) / spent : 0.0);
+        previousBusy[loop->index] = busy;
+        previousIdle[loop->index] = idle;
+    }
+}
+
+/*
+ -- FUNCTION: loopTimes
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int loopTimes(const engineCounters *loop,
+ --                                 unsigned long long now,
+ --                                 unsigned long long *busy,
+ --                                 unsigned long long *idle);
+ --
+ -- RETURNS: 1 if the thread runs an event loop, 0 if it does not
+ --
+ -- NOTES:
+ -- Gets the busy and idle time of a loop up to now. A loop is only timed when
+ -- it wakes or goes to wait, so the wait or the work it is in the middle of
+ -- is added on. A loop that has not woken since it started is all idle.
+ */
+static int loopTimes(const engineCounters *loop, unsigned long long now,
+                     unsigned long long *busy, unsigned long long *idle)
+{
+    unsigned long long waitStart = loop->waitStart;
+    unsigned long long wokeAt = loop->wokeAt;
+    
+    if (waitStart == 0 && wokeAt == 0)
+    {
+        return 0;
+    }
+    
+    *busy = loop->busy;
+    *idle = loop->idle;
+    if (waitStart > wokeAt && now > waitStart)
+    {
+        *idle += now - waitStart;
+    }
+    else if (wokeAt > waitStart && now > wokeAt)
+    {
+        *busy += now - wokeAt;
+    }
+    
+    return 1;
+}
+
+/*
+ -- FUNCTION: appendText
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void appendText(char *page, size_t length, int *used,
+ --                                   const char *format, ...);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Adds formatted text to the end of the page. Text that does not fit is
+ -- dropped, and the page is left at its full length.
+ */
+static void appendText(char *page, size_t length, int *used,
+                       const char *format, ...)
+{
+    int added = 0;
+    va_list arguments;
+    
+    if (*used >= (int)length - 1)
+    {
+        return;
+    }
+    
+    va_start(arguments, format);
+    added = vsnprintf(page + *used, length - *used, format, arguments);
+    va_end(arguments);
+    
+    if (added > 0)
+    {
+        *used += added;
+    }
+    if (*used > (int)length - 1)
+    {
+        *used = length - 1;
+    }
+}
+
+/*
+ -- FUNCTION: appendHeader
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void appendHeader(char *page, size_t length, int *used,
+ --                                     const char *name, const char *type,
+ --                                     const char *help);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Adds the HELP and TYPE lines that come before the samples of a metric.
+ */
+static void appendHeader(char *page, size_t length, int *used,
+                         const char *name, const char *type,
+                         const char *help)
+{
+    appendText(page, length, used, "# HELP %s %s\n# TYPE %s %s\n", name,
+               help, name, type);
+}
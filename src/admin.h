@@ -0,0 +1,18 @@
+#ifndef ADMIN_H
+#define ADMIN_H
+
+/* Defines */
+#define ADMIN_PAGE_SIZE 65536
+#define ADMIN_REQUEST_SIZE 1024
+#define ADMIN_MAX_LOOPS 1024
+#define ADMIN_SEND_TIMEOUT 1
+
+/* Function Prototypes */
+#ifdef __cplusplus
+extern "C" {
+#endif
+    int adminStart(int port, const char *engine);
+#ifdef __cplusplus
+}
+#endif
+#endif
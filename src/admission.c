@@ -0,0 +1,535 @@
+/*
+ -- SOURCE FILE: admission.c
+ --
+ -- PROGRAM: Web Client Emulator
+ --
+ -- FUNCTIONS:
+ -- int admissionConfigure(const char *text);
+ -- int admissionDescribe(char *text, size_t length);
+ -- int admitConnection();
+ -- void rejectConnection(int socket);
+ -- void admissionClosed();
+ -- int admissionPaused();
+ -- void admissionBegin(unsigned int count);
+ -- void admissionDone(unsigned int count, unsigned long long delay);
+ -- int admissionEnabled();
+ -- void admissionState(admissionStatus *status);
+ -- static int shedNow(unsigned long long now);
+ -- static unsigned long long controlLaw(unsigned long long time,
+ --                                      unsigned int count);
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- NOTES:
+ -- Admission control for the servers, so that past saturation they turn work
+ -- away quickly instead of letting every request get slower. Without it an
+ -- overloaded server shows up as SYN drops from a full accept queue and, in
+ -- the thread server, as a thread for every connection the kernel lets in.
+ --
+ -- There are three limits, all set with -L connections,inflight[,target,
+ -- interval]:
+ --
+ --     the most connections open at once. A connection over it is accepted
+ --     and reset straight away, which the client sees as a fast failure
+ --     the most requests read but not yet answered. Over it the servers stop
+ --     accepting, the event loops take the listening socket out of their
+ --     wait until requests have been answered
+ --     a CoDel controller on the time requests spend queued in the server.
+ --     When the least delay seen in an interval is over the target the
+ --     controller starts shedding, and resets new connections at a rate that
+ --     rises with the square root of the number shed, as CoDel drops
+ --     packets. It stops once an interval passes with a delay under target
+ --
+ -- The target is in microseconds and the interval in milliseconds, they
+ -- default to ADMISSION_TARGET and ADMISSION_INTERVAL. A limit of 0 is no
+ -- limit. Without -L every call returns straight away.
+ --
+ -- The serving threads only touch shared words here: the in flight count when
+ -- that limit is set, and the least delay of the current interval, which is
+ -- only written when a request beats it. The controller itself runs when a
+ -- connection is accepted, under a lock that only acceptors take.
+ */
+
+// Includes
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "admission.h"
+#include "timing.h"
+
+static int shedNow(unsigned long long now);
+static unsigned long long controlLaw(unsigned long long time,
+                                     unsigned int count);
+
+/* The limits, nothing is limited until enabled is set */
+static int enabled = 0;
+static unsigned int maxConnections = 0;
+static unsigned int maxInFlight = 0;
+static unsigned long long target = ADMISSION_TARGET;
+static unsigned long long interval = ADMISSION_INTERVAL;
+
+/* Shared with the serving threads */
+static unsigned int connections = 0;
+static unsigned int inFlight = 0;
+static unsigned long long windowLeast = ~0ULL;
+
+/* The CoDel state, kept under controlLock */
+static pthread_mutex_t controlLock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned long long windowStart = 0;
+static unsigned long long dropNext = 0;
+static unsigned int dropCount = 0;
+static int dropping = 0;
+
+/*
+ -- FUNCTION: admissionConfigure
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int admissionConfigure(const char *text);
+ --
+ -- RETURNS: 0 on success, -1 if the limits are not valid
+ --
+ -- NOTES:
+ -- Sets the limits from connections,inflight[,target,interval] and turns
+ -- admission control on. Must be called before any connections are served.
+ */
+int admissionConfigure(const char *text)
+{
+    char *end = 0;
+    unsigned long value = 0;
+    
+    maxConnections = strtoul(text, &end, 10);
+    if (end == text || (*end != ',' && *end != '\0'))
+    {
+        return -1;
+    }
+    if (*end == ',')
+    {
+        text = end + 1;
+        maxInFlight = strtoul(text, &end, 10);
+        if (end == text || (*end != ',' && *end != '\0'))
+        {
+            return -1;
+        }
+    }
+    if (*end == ',')
+    {
+        text = end + 1;
+        value = strtoul(text, &end, 10);
+        if (end == text || value == 0 || (*end != ',' && *end != '\0'))
+        {
+            return -1;
+        }
+        target = value * 1000ULL;
+    }
+    if (*end == ',')
+    {
+        text = end + 1;
+        value = strtoul(text, &end, 10);
+        if (end == text || value == 0 || *end != '\0')
+        {
+            return -1;
+        }
+        interval = value * 1000000ULL;
+    }
+    
+    windowStart = timingNow();
+    enabled = 1;
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: admissionDescribe
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int admissionDescribe(char *text, size_t length);
+ --
+ -- RETURNS: the length of the description, 0 if admission control is off
+ */
+int admissionDescribe(char *text, size_t length)
+{
+    if (!enabled)
+    {
+        text[0] = '\0';
+        return 0;
+    }
+    
+    return snprintf(text, length, "connections=%u inflight=%u "
+                    "target=%lluus interval=%llums", maxConnections,
+                    maxInFlight, target / 1000, interval / 1000000);
+}
+
+/*
+ -- FUNCTION: admitConnection
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Takes the connection's slot with a compare
+ -- and swap, so threads accepting at once cannot go over the limit.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int admitConnection();
+ --
+ -- RETURNS: 1 if the connection just accepted may be served, 0 if it should
+ --          be rejected
+ --
+ -- NOTES:
+ -- Checks the connection limit and runs the controller. An admitted
+ -- connection must be given back with admissionClosed. The slot is taken
+ -- before the controller runs and given back if it sheds the connection.
+ */
+int admitConnection()
+{
+    int shed = 0;
+    unsigned int count = 0;
+    
+    if (!enabled)
+    {
+        return 1;
+    }
+    
+    /* Only count the connection if the count has not moved since the check */
+    do
+    {
+        count = connections;
+        if (maxConnections != 0 && count >= maxConnections)
+        {
+            return 0;
+        }
+    } while (!__sync_bool_compare_and_swap(&connections, count, count + 1));
+    
+    pthread_mutex_lock(&controlLock);
+    shed = shedNow(timingNow());
+    pthread_mutex_unlock(&controlLock);
+    
+    if (shed)
+    {
+        __sync_sub_and_fetch(&connections, 1);
+        return 0;
+    }
+    
+    return 1;
+}
+
+/*
+ -- FUNCTION: rejectConnection
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void rejectConnection(int socket);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Closes a connection that was not admitted with a reset, which frees it at
+ -- once on both ends rather than leaving it in TIME_WAIT.
+ */
+void rejectConnection(int socket)
+{
+    struct linger linger;
+    
+    linger.l_onoff = 1;
+    linger.l_linger = 0;
+    setsockopt(socket, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger));
+    close(socket);
+}
+
+/*
+ -- FUNCTION: admissionClosed
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void admissionClosed();
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Gives back an admitted connection once it has closed.
+ */
+void admissionClosed()
+{
+    if (enabled)
+    {
+        __sync_sub_and_fetch(&connections, 1);
+    }
+}
+
+/*
+ -- FUNCTION: admissionPaused
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int admissionPaused();
+ --
+ -- RETURNS: 1 if the servers should stop accepting for now, 0 otherwise
+ --
+ -- NOTES:
+ -- Accepting stops while the in flight limit is reached. A server that stops
+ -- should look again within ADMISSION_RECHECK milliseconds.
+ */
+int admissionPaused()
+{
+    return enabled && maxInFlight != 0 && inFlight >= maxInFlight;
+}
+
+/*
+ -- FUNCTION: admissionBegin
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void admissionBegin(unsigned int count);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Counts requests that have been read and are being answered.
+ */
+void admissionBegin(unsigned int count)
+{
+    if (enabled && maxInFlight != 0)
+    {
+        __sync_add_and_fetch(&inFlight, count);
+    }
+}
+
+/*
+ -- FUNCTION: admissionDone
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void admissionDone(unsigned int count,
+ --                               unsigned long long delay);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Counts requests as answered, and gives the controller the time they spent
+ -- in the server. Only the least delay of each interval is kept, which is
+ -- nearly always a read and a compare.
+ */
+void admissionDone(unsigned int count, unsigned long long delay)
+{
+    unsigned long long least = 0;
+    
+    if (!enabled)
+    {
+        return;
+    }
+    
+    if (maxInFlight != 0)
+    {
+        __sync_sub_and_fetch(&inFlight, count);
+    }
+    
+    least = windowLeast;
+    while (delay < least &&
+           !__sync_bool_compare_and_swap(&windowLeast, least, delay))
+    {
+        least = windowLeast;
+    }
+}
+
+/*
+ -- FUNCTION: admissionEnabled
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int admissionEnabled();
+ --
+ -- RETURNS: 1 if admission control is on, 0 otherwise
+ */
+int admissionEnabled()
+{
+    return enabled;
+}
+
+/*
+ -- FUNCTION: admissionState
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void admissionState(admissionStatus *status);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Reads the counts and the controller state without the lock, for reports.
+ */
+void admissionState(admissionStatus *status)
+{
+    status->connections = connections;
+    status->inFlight = inFlight;
+    status->dropCount = dropCount;
+    status->shedding = dropping;
+    status->paused = admissionPaused();
+}
+
+/*
+ -- FUNCTION: shedNow
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int shedNow(unsigned long long now);
+ --
+ -- RETURNS: 1 if the connection being accepted should be shed, 0 otherwise
+ --
+ -- NOTES:
+ -- The CoDel controller, run under controlLock. Once an interval has passed
+ -- its least delay decides whether the server is above target, and a new
+ -- interval starts. An interval in which no request finished is taken as
+ -- being under target. While above target the controller sheds one
+ -- connection on entering the shedding state and then one each time the
+ -- control law says the next is due. Coming back soon after it stopped, it
+ -- picks up near the rate it left off at.
+ */
+static int shedNow(unsigned long long now)
+{
+    int above = 0;
+    
+    if (now - windowStart < interval)
+    {
+        above = dropping;
+    }
+    else
+    {
+        above = (windowLeast != ~0ULL && windowLeast > target);
+        windowLeast = ~0ULL;
+        windowStart = now;
+    }
+    
+    if (dropping)
+    {
+        if (!above)
+        {
+            dropping = 0;
+        }
+        else if (now >= dropNext)
+        {
+            dropCount++;
+            dropNext = controlLaw(dropNext, dropCount);
+            return 1;
+        }
+        return 0;
+    }
+    
+    if (above)
+    {
+        dropping = 1;
+        dropCount = (dropCount > 2 && now - dropNext < 16 * interval) ?
+                    dropCount - 2 : 1;
+        dropNext = controlLaw(now, dropCount);
+        return 1;
+    }
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: controlLaw
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static unsigned long long controlLaw(unsigned long long time,
+ --                                                 unsigned int count);
+ --
+ -- RETURNS: when the next connection should be shed
+ --
+ -- NOTES:
+ -- The CoDel control law, the interval divided by the square root of the
+ -- number shed so far. The root is found by Newton's method on integers.
+ */
+static unsigned long long controlLaw(unsigned long long time,
+                                     unsigned int count)
+{
+    unsigned long long root = count;
+    unsigned long long next = (root + 1) / 2;
+    
+    while (next < root)
+    {
+        root = next;
+        next = (root + count / root) / 2;
+    }
+    
+    return time + interval / (root ? root : 1);
+}
@@ -0,0 +1,38 @@
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include <stddef.h>
+
+/* Defines */
+#define ADMISSION_TARGET 5000000ULL
+#define ADMISSION_INTERVAL 100000000ULL
+#define ADMISSION_RECHECK 10
+
+/* The state of admission control, for reports */
+typedef struct
+{
+    unsigned int connections;
+    unsigned int inFlight;
+    unsigned int dropCount;
+    int shedding;
+    int paused;
+} admissionStatus;
+
+/* Function Prototypes */
+#ifdef __cplusplus
+extern "C" {
+#endif
+    int admissionConfigure(const char *text);
+    int admissionDescribe(char *text, size_t length);
+    int admitConnection();
+    void rejectConnection(int socket);
+    void admissionClosed();
+    int admissionPaused();
+    void admissionBegin(unsigned int count);
+    void admissionDone(unsigned int count, unsigned long long delay);
+    int admissionEnabled();
+    void admissionState(admissionStatus *status);
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,398 @@
+/*
+ -- SOURCE FILE: affinity.c
+ --
+ -- PROGRAM: Web Client Emulator
+ --
+ -- FUNCTIONS:
+ -- int parseCoreList(const char *text, coreList *list);
+ -- int describeCoreList(const coreList *list, char *text, size_t length);
+ -- int affinityCore(const coreList *list, unsigned int index);
+ -- int coreListHas(const coreList *list, int core);
+ -- int setAttrAffinity(pthread_attr_t *attr, int core);
+ -- int pinThread(int core);
+ -- void *localAlloc(size_t size);
+ -- void localFree(void *memory, size_t size);
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- NOTES:
+ -- This file places threads on cores for the client and the servers. A core
+ -- list is written the way taskset and the kernel write them:
+ --
+ --     0-3,8,10-11     the listed cores
+ --     all             every core the process is allowed to run on
+ --     ^0-3            every allowed core except the listed ones
+ --
+ -- Threads are handed the cores in the list round robin, so thread N runs on
+ -- core N modulo the length of the list. Running a loopback benchmark with
+ -- the server on "0-3" and the client on "^0-3" keeps the two on disjoint
+ -- cores.
+ --
+ -- Memory is placed on the NUMA node of the thread that first touches it, so
+ -- buffers that are allocated with localAlloc by a thread after it has been
+ -- pinned stay on that thread's node.
+ */
+
+// Includes
+#define _GNU_SOURCE
+#include <sched.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "affinity.h"
+
+/*
+ -- FUNCTION: parseCoreList
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int parseCoreList(const char *text, coreList *list);
+ --
+ -- RETURNS: 0 on success, -1 if the list is not valid or has no cores
+ --
+ -- NOTES:
+ -- Turns a core list into the cores in it, in increasing order. Cores the
+ -- process is not allowed to run on are dropped.
+ */
+int parseCoreList(const char *text, coreList *list)
+{
+    int first = 0;
+    int last = 0;
+    int core = 0;
+    int exclude = 0;
+    char *end = 0;
+    cpu_set_t allowed;
+    cpu_set_t wanted;
+    
+    list->count = 0;
+    
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &allowed) == -1)
+    {
+        return -1;
+    }
+    
+    if (*text == '^')
+    {
+        exclude = 1;
+        text++;
+    }
+    
+    CPU_ZERO(&wanted);
+    if (strcmp(text, "all") == 0)
+    {
+        CPU_OR(&wanted, &wanted, &allowed);
+    }
+    else
+    {
+        while (*text != '\0')
+        {
+            first = strtol(text, &end, 10);
+            if (end == text || first < 0)
+            {
+                return -1;
+            }
+            last = first;
+            if (*end == '-')
+            {
+                text = end + 1;
+                last = strtol(text, &end, 10);
+                if (end == text || last < first)
+                {
+                    return -1;
+                }
+            }
+            for (core = first; core <= last && core < CPU_SETSIZE; core++)
+            {
+                CPU_SET(core, &wanted);
+            }
+            if (*end == ',')
+            {
+                end++;
+            }
+            else if (*end != '\0')
+            {
+                return -1;
+            }
+            text = end;
+        }
+    }
+    
+    if (exclude)
+    {
+        CPU_XOR(&wanted, &wanted, &allowed);
+    }
+    CPU_AND(&wanted, &wanted, &allowed);
+    
+    for (core = 0; core < CPU_SETSIZE && list->count < AFFINITY_MAX_CORES;
+         core++)
+    {
+        if (CPU_ISSET(core, &wanted))
+        {
+            list->cores[list->count++] = core;
+        }
+    }
+    
+    return (list->count == 0) ? -1 : 0;
+}
+
+/*
+ -- FUNCTION: describeCoreList
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int describeCoreList(const coreList *list, char *text,
+ --                                 size_t length);
+ --
+ -- RETURNS: the length of the description
+ --
+ -- NOTES:
+ -- Writes the cores back out as a core list with ranges, for logging and for
+ -- passing on to another process.
+ */
+int describeCoreList(const coreList *list, char *text, size_t length)
+{
+    unsigned int index = 0;
+    unsigned int last = 0;
+    size_t used = 0;
+    
+    text[0] = '\0';
+    
+    for (index = 0; index < list->count && used < length; index = last + 1)
+    {
+        /* Find the end of the run of consecutive cores */
+        for (last = index; last + 1 < list->count &&
+             list->cores[last + 1] == list->cores[last] + 1; last++)
+        {
+        }
+        
+        if (last == index)
+        {
+            used += snprintf(text + used, length - used, "%s%d",
+                             index ? "," : "", list->cores[index]);
+        }
+        else
+        {
+            used += snprintf(text + used, length - used, "%s%d-%d",
+                             index ? "," : "", list->cores[index],
+                             list->cores[last]);
+        }
+    }
+    
+    return (used < length) ? (int)used : (int)length - 1;
+}
+
+/*
+ -- FUNCTION: affinityCore
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int affinityCore(const coreList *list, unsigned int index);
+ --
+ -- RETURNS: the core for the thread, or -1 if there is no list
+ --
+ -- NOTES:
+ -- Picks the core for thread number index, round robin over the list.
+ */
+int affinityCore(const coreList *list, unsigned int index)
+{
+    if (list == NULL || list->count == 0)
+    {
+        return -1;
+    }
+    
+    return list->cores[index % list->count];
+}
+
+/*
+ -- FUNCTION: coreListHas
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int coreListHas(const coreList *list, int core);
+ --
+ -- RETURNS: 1 if the core is in the list, otherwise 0
+ --
+ -- NOTES:
+ -- An empty list stands for no restriction, so it has every core.
+ */
+int coreListHas(const coreList *list, int core)
+{
+    unsigned int index = 0;
+    
+    if (list->count == 0)
+    {
+        return core >= 0;
+    }
+    
+    for (index = 0; index < list->count; index++)
+    {
+        if (list->cores[index] == core)
+        {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: setAttrAffinity
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int setAttrAffinity(pthread_attr_t *attr, int core);
+ --
+ -- RETURNS: 0 on success, an error number on failure
+ --
+ -- NOTES:
+ -- Sets the thread attributes so that the next thread made with them starts
+ -- on the core. Starting the thread there, rather than moving it after it has
+ -- started, means its stack is touched first on the right node. A core of -1
+ -- leaves the thread free to run anywhere.
+ */
+int setAttrAffinity(pthread_attr_t *attr, int core)
+{
+    cpu_set_t set;
+    
+    if (core < 0)
+    {
+        if (sched_getaffinity(0, sizeof(cpu_set_t), &set) == -1)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+    }
+    
+    return pthread_attr_setaffinity_np(attr, sizeof(cpu_set_t), &set);
+}
+
+/*
+ -- FUNCTION: pinThread
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int pinThread(int core);
+ --
+ -- RETURNS: 0 on success, an error number on failure
+ --
+ -- NOTES:
+ -- Moves the calling thread onto the core.
+ */
+int pinThread(int core)
+{
+    cpu_set_t set;
+    
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+}
+
+/*
+ -- FUNCTION: localAlloc
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void *localAlloc(size_t size);
+ --
+ -- RETURNS: zeroed memory, or NULL on failure
+ --
+ -- NOTES:
+ -- Allocates whole pages and touches them from the calling thread, so they
+ -- are placed on the NUMA node the thread is running on rather than wherever
+ -- the heap happened to get its pages from.
+ */
+void *localAlloc(size_t size)
+{
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    
+    if (memory == MAP_FAILED)
+    {
+        return NULL;
+    }
+    
+    memset(memory, 0, size);
+    
+    return memory;
+}
+
+/*
+ -- FUNCTION: localFree
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void localFree(void *memory, size_t size);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Frees memory from localAlloc.
+ */
+void localFree(void *memory, size_t size)
+{
+    if (memory != NULL)
+    {
+        munmap(memory, size);
+    }
+}
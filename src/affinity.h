@@ -0,0 +1,32 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+/* Defines */
+#define AFFINITY_MAX_CORES 1024
+
+/* The cores threads are placed on, in the order they are handed out */
+typedef struct
+{
+    unsigned int count;
+    int cores[AFFINITY_MAX_CORES];
+} coreList;
+
+/* Function Prototypes */
+#ifdef __cplusplus
+extern "C" {
+#endif
+    int parseCoreList(const char *text, coreList *list);
+    int describeCoreList(const coreList *list, char *text, size_t length);
+    int affinityCore(const coreList *list, unsigned int index);
+    int coreListHas(const coreList *list, int core);
+    int setAttrAffinity(pthread_attr_t *attr, int core);
+    int pinThread(int core);
+    void *localAlloc(size_t size);
+    void localFree(void *memory, size_t size);
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -4,16 +4,96 @@
  --	PROGRAM:		Web Client Emulator
  --
  --	FUNCTIONS:		
+ --                 int main(int argc, char **argv);
+ --                 static int parseOptions(int argc, char **argv,
+ --                                         clientOptions *options);
+ --                 static void runClients(clientOptions *options);
  --                 void *client(void* information);
- --                 void dataCollector(int socket, int clients);
- --                 void createClients(threadData data, int threads);
+ --                 static int runTask(threadData *data, clientState *state,
+ --                                    connectionTask *task);
+ --                 static int takeTask(workPool *pool, int worker,
+ --                                     unsigned long long now,
+ --                                     unsigned long long *wait);
+ --                 static void putTask(workPool *pool, int worker, int task);
+ --                 static int churnConnection(threadData *data,
+ --                                            clientState *state,
+ --                                            unsigned long long *think);
+ --                 static int timedRequest(threadData *data, clientState *state,
+ --                                         int *socket,
+ --                                         unsigned int connectionClass,
+ --                                         unsigned long long *think);
+ --                 static int misbehave(threadData *data, clientState *state,
+ --                                      int *socket);
+ --                 static int readFileReply(int *socket, clientState *state);
+ --                 static unsigned int pickClass(threadData *data,
+ --                                               clientState *state);
+ --                 static void pace(unsigned long long elapsed,
+ --                                  unsigned long long due);
+ --                 void dataCollector(int socket, int clients, const char *path,
+ --                                    const char *config,
+ --                                    unsigned int interval);
+ --                 static void collectInterval(resultsWriter *writer,
+ --                                             clientResults *previous,
+ --                                             clientResults *current,
+ --                                             histogram *latency,
+ --                                             unsigned long long elapsed,
+ --                                             unsigned long long duration);
+ --                 static void describeRun(threadData *data, int threads,
+ --                                         const char *profilePath,
+ --                                         const char *sourceText,
+ --                                         char *config, size_t length);
+ --                 static void runWorker(int port, int notify);
+ --                 static int coordinate(clientOptions *options);
+ --                 static int spawnWorker();
+ --                 static void describeArguments(clientOptions *options,
+ --                                               char *line, size_t length);
+ --                 static unsigned long long wallClock();
+ --                 void createClients(threadData data, int threads,
+ --                                    const coreList *cores);
  --                 void stopClients();
  --                 void stopCollecting();
  --                 static void systemFatal(const char* message);
  --
  --	DATE:			February 8, 2012
  --
- --	REVISIONS:		(Date and Description)
+ --	REVISIONS:		October 18, 2026 - Added the connection churn mode, where each
+ --                  connection is opened, used for a number of requests and
+ --                  then closed again. Connection setup time is reported
+ --                  separately from request time.
+ --                  October 18, 2026 - Added workload profiles, which give each
+ --                  connection a class with its own request size and think
+ --                  time distributions.
+ --                  October 18, 2026 - The results are now collected in binary
+ --                  form and appended to a results file, see results.c.
+ --                  October 18, 2026 - The threads keep their counters in
+ --                  shared memory, and the collector reports them every
+ --                  interval while the run is going.
+ --                  October 18, 2026 - Added the coordinator and worker modes,
+ --                  so one run can be spread over many client processes or
+ --                  machines and reported as one.
+ --                  October 18, 2026 - Added thread placement. With -a the
+ --                  client threads are pinned to cores round robin and their
+ --                  buffers are allocated on their own NUMA node.
+ --                  October 18, 2026 - Added -T for a socket tuning profile,
+ --                  which is logged with the run.
+ --                  October 18, 2026 - Added -g to request a file from a
+ --                  server with a document root instead of a number of bytes.
+ --                  October 18, 2026 - The threads count their system calls
+ --                  and context switches, which are reported per request with
+ --                  the throughput, see engineStats.c.
+ --                  October 18, 2026 - Requests and connections are timed with
+ --                  the calibrated monotonic clock in timing.c instead of
+ --                  gettimeofday, in nanoseconds.
+ --                  October 18, 2026 - Added -z, which has a share of the
+ --                  connections misbehave to test that a server only closes
+ --                  the connections that fail.
+ --                  October 18, 2026 - The client threads are a pool of
+ --                  workers sharing the connections as tasks, with idle
+ --                  workers stealing from busy ones.
+ --                  October 18, 2026 - -i also takes the path of a UNIX
+ --                  domain socket, for a server started with -u.
+ --                  October 18, 2026 - -i also takes an IPv6 address, and -I
+ --                  spreads the connections over a list of source addresses.
  --
  --	DESIGNERS:      Luke Queenan
  --
@@ -30,44 +110,219 @@
  --        respond
  --
  -- This program will also allow the user to specify the number of above
- -- clients to spawn via threads. A process is also created that will collect
- -- any statistical data and save it to a file. This is done using UNIX domain
- -- sockets.
+ -- clients to spawn via threads. The -t threads are a pool of workers, and
+ -- the -n clients of each thread are tasks that any worker may run a request
+ -- of. Each worker keeps a queue of tasks, and a worker with nothing due
+ -- takes from the others, so the load stays even when some connections are
+ -- slower than others or some workers run out early. A process is also
+ -- created that will collect any statistical data and save it to a file. The
+ -- threads keep their counters in memory shared with that process, which
+ -- reads them every interval, and each thread tells it when it is done over
+ -- a UNIX domain socket.
+ --
+ -- A client started with -W port waits for a coordinator instead of running.
+ -- A client started with -C host:port,... or -C local:N is a coordinator. It
+ -- sends its own options to every worker, starts them all at the same time and
+ -- merges the runs they send back into one report.
+ --
+ -- Given a path starting with a slash instead of an address, -i connects to
+ -- a server listening on that UNIX domain socket with -u, which leaves the
+ -- TCP stack out of a run where the client and server share a host. An IPv6
+ -- address works as well as an IPv4 one.
+ --
+ -- A host only has about 28000 ephemeral ports to connect to one server
+ -- address and port from. With -I address,... the connections are bound to
+ -- each source address in turn, and each gets its own ports, so a run of
+ -- 100000 connections needs four or more. The addresses have to be
+ -- configured on the host, and the ones not of the server's family are
+ -- skipped.
+ --
+ -- The client threads are placed with -a cores, using a core list such as
+ -- 0-3,8 or ^0-3 for every core but those, see affinity.c. Giving the server
+ -- and client disjoint lists keeps them from fighting over cores on loopback.
+ --
+ -- With -z percent, that share of the requests is replaced by a misbehaving
+ -- connection: a request that is too large, a line that is not a number, a
+ -- request followed by a reset before the reply is read, or half a line and
+ -- a close. The connection is then thrown away and a persistent one is made
+ -- again. A server should close each of these and go on serving the others.
  ----------------------------------------------------------------------------*/
 
 /* System includes */
+#include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
 #include <pthread.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
-#include <sys/time.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <time.h>
 #include <unistd.h>
 
 /* User includes */
+#include "affinity.h"
+#include "engineStats.h"
 #include "network.h"
+#include "results.h"
+#include "summary.h"
+#include "timing.h"
+#include "workload.h"
+
+/* Most workers a coordinator will drive */
+#define COORDINATOR_MAX_WORKERS 64
+
+/* How far ahead of now the workers are told to start, in nanoseconds */
+#define COORDINATOR_LEAD 1000000000ULL
+
+/* Longest a client worker sleeps when no task is due, in nanoseconds */
+#define TASK_IDLE_WAIT 100000ULL
 
 /* Client data struct define */
 typedef struct
 {
-    char ip[16];
+    char ip[NETWORK_ADDRESS_SIZE];
     int request;
     char port[8];
     int comm;
     int clients;
     unsigned int pause;
     unsigned long long maxRequests;
+    unsigned int churn;
+    unsigned int rate;
+    workloadProfile *profile;
+    const char *path;
+    unsigned int fuzz;
 } threadData;
 
+/* Per thread results struct define */
+typedef struct clientResults
+{
+    unsigned long long requests;
+    unsigned long long dataReceived;
+    unsigned long long connections;
+    unsigned long long connectTime;
+    unsigned long long errors;
+    unsigned long long misbehaved;
+    engineCounters engine;
+    histogram latency;
+} clientResults;
+
+/* Per thread working state struct define */
+typedef struct
+{
+    char *buffer;
+    char request[NETWORK_BUFFER_SIZE];
+    unsigned long long seed;
+    clientResults *results;
+} clientState;
+
+/* One client connection, made a pass at a time by whichever worker has it */
+typedef struct
+{
+    int socket;
+    int next;
+    unsigned int connectionClass;
+    unsigned long long passes;
+    unsigned long long due;
+} connectionTask;
+
+/* A worker's queue of tasks, which the other workers may steal from */
+typedef struct
+{
+    pthread_mutex_t lock;
+    volatile int head;
+    int tail;
+} taskQueue;
+
+/* The connection tasks of a run and the queues of the workers running them */
+typedef struct
+{
+    connectionTask *tasks;
+    taskQueue *queues;
+    int workers;
+    volatile int remaining;
+} workPool;
+
+/* What each worker is started with */
+typedef struct
+{
+    threadData *data;
+    clientResults *results;
+    workPool *pool;
+    int index;
+} workerData;
+
+/* Memory shared between the client threads and the collector process */
+typedef struct
+{
+    volatile sig_atomic_t stop;
+    int threads;
+    clientResults slot[];
+} sharedResults;
+
+/* Command line options struct define */
+typedef struct
+{
+    threadData data;
+    int threads;
+    unsigned int interval;
+    const char *profilePath;
+    const char *resultsPath;
+    unsigned long long startTime;
+    int workerPort;
+    const char *workers;
+    const char *coreText;
+    const char *tuningPath;
+    const char *sourceText;
+    coreList cores;
+    workloadProfile profile;
+} clientOptions;
+
+/* Shared results, set up before the collector is forked */
+static sharedResults *shared = 0;
+
+/* Cleared when the collector is told to stop */
+static volatile sig_atomic_t collecting = 1;
+
 /* Function Protypes */
+int main(int argc, char **argv);
+static int parseOptions(int argc, char **argv, clientOptions *options);
+static void runClients(clientOptions *options);
 void *client(void* information);
-void dataCollector(int socket, int clients);
-void createClients(threadData data, int threads);
+static int runTask(threadData *data, clientState *state, connectionTask *task);
+static int takeTask(workPool *pool, int worker, unsigned long long now,
+                    unsigned long long *wait);
+static void putTask(workPool *pool, int worker, int task);
+static int churnConnection(threadData *data, clientState *state,
+                           unsigned long long *think);
+static int timedRequest(threadData *data, clientState *state, int *socket,
+                        unsigned int connectionClass,
+                        unsigned long long *think);
+static int misbehave(threadData *data, clientState *state, int *socket);
+static int readFileReply(int *socket, clientState *state);
+static unsigned int pickClass(threadData *data, clientState *state);
+static void pace(unsigned long long elapsed, unsigned long long due);
+void dataCollector(int socket, int clients, const char *path,
+                   const char *config, unsigned int interval);
+static void collectInterval(resultsWriter *writer, clientResults *previous,
+                            clientResults *current, histogram *latency,
+                            unsigned long long elapsed,
+                            unsigned long long duration);
+static void describeRun(threadData *data, int threads, const char *profilePath,
+                        const char *sourceText, char *config, size_t length);
+static void runWorker(int port, int notify);
+static int coordinate(clientOptions *options);
+static int spawnWorker();
+static void describeArguments(clientOptions *options, char *line,
+                              size_t length);
+static unsigned long long wallClock();
+void createClients(threadData data, int threads, const coreList *cores);
 void stopClients();
 void stopCollecting();
 static void systemFatal(const char* message);
@@ -77,7 +332,7 @@ static void systemFatal(const char* message);
  --
  -- DATE: Feb 20, 2011
  --
- -- REVISIONS: (Date and Description)
+ -- REVISIONS: October 18, 2026 - Calibrates the request clock first.
  --
  -- DESIGNER: Luke Queenan
  --
@@ -91,16 +346,85 @@ static void systemFatal(const char* message);
  -- This is the main entry point for the client program
  */
 int main(int argc, char **argv)
+{
+    clientOptions *options = 0;
+    
+    if ((options = malloc(sizeof(clientOptions))) == NULL)
+    {
+        systemFatal("Could not allocate option memory");
+    }
+    
+    /* Get all the arguments */
+    if (parseOptions(argc, argv, options) == -1)
+    {
+        return 1;
+    }
+    
+    /* Calibrate the request clock before any thread reads it */
+    timingInit();
+    
+    /* Serve a coordinator, coordinate workers or just run the clients */
+    if (options->workerPort != -1)
+    {
+        runWorker(options->workerPort, -1);
+    }
+    else if (options->workers != 0)
+    {
+        return coordinate(options);
+    }
+    else
+    {
+        runClients(options);
+    }
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: parseOptions
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Added -z.
+ -- October 18, 2026 - -i may be the path of a UNIX domain socket.
+ -- October 18, 2026 - Added -I, which sets the source addresses.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int parseOptions(int argc, char **argv,
+ --                                    clientOptions *options)
+ --
+ -- RETURNS: 0 on success, -1 if the options are not usable
+ --
+ -- NOTES:
+ -- Fills in the options with the defaults and then the command line. This
+ -- used to be the top of main, and is now also used by workers to read the
+ -- options sent by the coordinator.
+ */
+static int parseOptions(int argc, char **argv, clientOptions *options)
 {
     /* Create variables and assign default data */
     int option = 0;
-    int comms[2];
-    int threads = 10;
-    /* POSITIONS ------------IP--------BYTES---PORT-COMM-#C--P--REQUESTS---*/
-    threadData data = {"192.168.0.175", 1024, "8989", 0, 10, 1, 100};
+    char error[NETWORK_BUFFER_SIZE];
+    /* POSITIONS ------------IP--------BYTES---PORT-COMM-#C--P--REQUESTS-K--R--F--G--Z*/
+    threadData data = {"192.168.0.175", 1024, "8989", 0, 10, 1, 100, 0, 0, 0, 0, 0};
     
-    /* Get all the arguments */
-    while ((option = getopt(argc, argv, "p:i:r:m:w:n:t:")) != -1)
+    memset(options, 0, sizeof(clientOptions));
+    options->threads = 10;
+    options->interval = 1000;
+    options->workerPort = -1;
+    options->resultsPath = "clientData.dat";
+    options->profilePath = "";
+    options->coreText = "";
+    options->tuningPath = "";
+    options->sourceText = "";
+    
+    /* Start from the first argument, even if getopt has been used before */
+    optind = 0;
+    
+    while ((option = getopt(argc, argv, "p:i:r:m:w:n:t:k:R:f:o:s:W:C:a:T:g:z:I:")) != -1)
     {
         switch (option) {
             case 'p':
@@ -122,7 +446,61 @@ int main(int argc, char **argv)
                 data.clients = atoi(optarg);
                 break;
             case 't':
-                threads = atoi(optarg);
+                options->threads = atoi(optarg);
+                break;
+            case 'k':
+                data.churn = atoi(optarg);
+                break;
+            case 'R':
+                data.rate = atoi(optarg);
+                break;
+            case 'f':
+                if (loadWorkloadProfile(optarg, &options->profile,
+                                        NETWORK_BUFFER_SIZE, error,
+                                        sizeof(error)) == -1)
+                {
+                    fprintf(stderr, "Workload profile: %s\n", error);
+                    return -1;
+                }
+                data.profile = &options->profile;
+                options->profilePath = optarg;
+                break;
+            case 'o':
+                options->resultsPath = optarg;
+                break;
+            case 's':
+                options->interval = atoi(optarg);
+                break;
+            case 'W':
+                options->workerPort = atoi(optarg);
+                break;
+            case 'C':
+                options->workers = optarg;
+                break;
+            case 'a':
+                if (parseCoreList(optarg, &options->cores) == -1)
+                {
+                    fprintf(stderr, "No usable cores in %s\n", optarg);
+                    return -1;
+                }
+                options->coreText = optarg;
+                break;
+            case 'g':
+                data.path = optarg;
+                break;
+            case 'z':
+                data.fuzz = atoi(optarg);
+                break;
+            case 'I':
+                options->sourceText = optarg;
+                break;
+            case 'T':
+                if (loadSocketTuning(optarg, error, sizeof(error)) == -1)
+                {
+                    fprintf(stderr, "Socket tuning: %s\n", error);
+                    return -1;
+                }
+                options->tuningPath = optarg;
                 break;
             default:
                 fprintf(stderr, "Usage: %s NEED TO DO USAGE\n", argv[0]);
@@ -130,30 +508,99 @@ int main(int argc, char **argv)
         }
     }
     
+    memcpy(&options->data, &data, sizeof(threadData));
+    
+    /* Set every time, so a worker's last run does not leave its sources */
+    if (setSourceAddresses(options->sourceText) == -1)
+    {
+        fprintf(stderr, "Source addresses: %s is not valid\n",
+                options->sourceText);
+        return -1;
+    }
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: runClients
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Waits for its own data processing process
+ -- once the client threads are joined.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void runClients(clientOptions *options)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Sets up the data collection process and the client threads and waits for
+ -- the run to finish. If the options carry a start time the run is held back
+ -- until then, which is how the workers of a coordinator start together.
+ */
+static void runClients(clientOptions *options)
+{
+    int comms[2];
+    char config[RESULTS_CONFIG_SIZE];
+    pid_t collector = 0;
+    struct timespec start;
+    
     /* Create the socket pair for sending data for collection */
     if (socketpair(AF_UNIX, SOCK_STREAM, 0, comms) == -1)
     {
         systemFatal("Unable to create socket pair");
     }
     
+    /* Create the counters shared with the data processing process */
+    shared = mmap(NULL, sizeof(sharedResults) + sizeof(clientResults) *
+                  options->threads, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED)
+    {
+        systemFatal("Unable to create shared results");
+    }
+    shared->threads = options->threads;
+    
+    /* Wait for the agreed start time */
+    if (options->startTime != 0)
+    {
+        start.tv_sec = options->startTime / 1000000000ULL;
+        start.tv_nsec = options->startTime % 1000000000ULL;
+        while (clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &start,
+                               NULL) == EINTR)
+        {
+        }
+    }
+    
     /* Create the data processing process and send it the other socket */
-    if (!fork())
+    if ((collector = fork()) == 0)
     {
-        dataCollector(comms[1], threads);
-        return 0;
+        describeRun(&options->data, options->threads, options->profilePath,
+                    options->sourceText, config, sizeof(config));
+        dataCollector(comms[1], options->threads, options->resultsPath,
+                      config, options->interval);
     }
     
     /* Catch the SIGINT so we can shut down the data process */
     signal(SIGINT, stopClients);
     
     /* Assign the other socket to the thread data */
-    data.comm = comms[0];
+    options->data.comm = comms[0];
     
-    /* Create the clients */
-    createClients(data, threads);
+    describeSocketTuning(config, sizeof(config));
+    printf("Socket tuning: %s\n", config);
     
-    return 0;
+    /* Create the clients */
+    createClients(options->data, options->threads, &options->cores);
     
+    /* The run is over once the data processing process has written it */
+    while (waitpid(collector, NULL, 0) == -1 && errno == EINTR)
+    {
+    }
 }
 
 /*
@@ -161,65 +608,125 @@ int main(int argc, char **argv)
  --
  -- DATE: Feb 20, 2011
  --
- -- REVISIONS: (Date and Description)
+ -- REVISIONS: October 18, 2026 - Threads are started on the cores in the core
+ -- list, round robin, when there is one.
+ -- October 18, 2026 - The threads are a pool of workers that share the
+ -- connections as tasks. They are joined, rather than waiting on the data
+ -- processing process, and the thread data is no longer a stack array.
  --
  -- DESIGNER: Luke Queenan
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: int createClients(threadData, int)
+ -- INTERFACE: void createClients(threadData, int, const coreList *)
  --
  -- RETURNS: void
  --
  -- NOTES:
- -- This function creates all the client threads and then waits for a signal
- -- from the data collection process
+ -- This function makes a task for every client of every thread and deals
+ -- them out to the workers' queues, each worker starting with the clients
+ -- its thread used to own. It then starts the workers and waits for them all
+ -- to finish. Connections left open by a stopped run are closed here.
  */
-void createClients(threadData clientData, int threads)
+void createClients(threadData clientData, int threads, const coreList *cores)
 {
     /* Create local variables and assign default values */
     int count = 0;
-    threadData data[threads];
-    pthread_t thread = 0;
+    int tasks = threads * clientData.clients;
+    char placement[NETWORK_BUFFER_SIZE];
+    pthread_t *thread = 0;
     pthread_attr_t attr;
+    workPool pool;
+    workerData *workers = 0;
     
     /* Create the reusable thread attributes */
     pthread_attr_init(&attr);
     
-    /* Set the thread to non joinable (detached) */
-    if (pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) != 0)
-    {
-        systemFatal("Unable to set thread attributes to detached");
-    }
-    
     /* Set the thread for kernel management. This means that system calls will
      not block all threads in the process and that individual threads can be
-     assigned to indiviudal processors in the system. */
+     scheduled on any processor in the system. They are only pinned to one
+     when a core list is given. */
     if (pthread_attr_setscope(&attr, PTHREAD_SCOPE_SYSTEM) != 0)
     {
         systemFatal("Unable to set thread to system scope");
     }
     
-    /* Create individual client data */
+    /* Create the tasks, the queues and each worker's own data */
+    memset(&pool, 0, sizeof(workPool));
+    pool.workers = threads;
+    pool.remaining = tasks;
+    if ((pool.tasks = malloc(sizeof(connectionTask) * tasks)) == NULL ||
+        (pool.queues = calloc(threads, sizeof(taskQueue))) == NULL ||
+        (workers = malloc(sizeof(workerData) * threads)) == NULL ||
+        (thread = malloc(sizeof(pthread_t) * threads)) == NULL)
+    {
+        systemFatal("Could not allocate the worker pool");
+    }
     for (count = 0; count < threads; count++)
     {
-        memcpy(&data[count], &clientData, sizeof(threadData));
+        pthread_mutex_init(&pool.queues[count].lock, NULL);
+        pool.queues[count].head = -1;
+        pool.queues[count].tail = -1;
+        workers[count].data = &clientData;
+        workers[count].results = &shared->slot[count];
+        workers[count].pool = &pool;
+        workers[count].index = count;
+    }
+    for (count = 0; count < tasks; count++)
+    {
+        memset(&pool.tasks[count], 0, sizeof(connectionTask));
+        pool.tasks[count].socket = -1;
+        putTask(&pool, count / clientData.clients, count);
     }
     
-    /* Create each thread */
+    if (cores->count != 0)
+    {
+        describeCoreList(cores, placement, sizeof(placement));
+        printf("Placing %d threads on cores %s\n", threads, placement);
+    }
+    
+    /* Create each thread, on its core if there is a core list */
     for (count = 0; count < threads; count++)
     {
-        if (pthread_create(&thread, &attr, client, (void *) &data[count]) != 0)
+        if (cores->count != 0 &&
+            setAttrAffinity(&attr, affinityCore(cores, count)) != 0)
+        {
+            systemFatal("Unable to set thread affinity");
+        }
+        
+        if (pthread_create(&thread[count], &attr, client,
+                           (void *) &workers[count]) != 0)
         {
             systemFatal("Unable to make thread");
         }
     }
- 
+    
     /* Destroy thread attributes */
     pthread_attr_destroy(&attr);
     
-    /* Wait for a signal from the data processing process */
-    wait(&count);
+    /* Wait for the tasks to run out or the client to be stopped */
+    for (count = 0; count < threads; count++)
+    {
+        pthread_join(thread[count], NULL);
+    }
+    
+    /* Close the connections of the tasks a stop cut short */
+    for (count = 0; count < tasks; count++)
+    {
+        if (pool.tasks[count].socket != -1)
+        {
+            closeSocket(&pool.tasks[count].socket);
+        }
+    }
+    for (count = 0; count < threads; count++)
+    {
+        pthread_mutex_destroy(&pool.queues[count].lock);
+    }
+    
+    free(thread);
+    free(workers);
+    free(pool.queues);
+    free(pool.tasks);
 }
 
 /*
@@ -227,7 +734,19 @@ void createClients(threadData clientData, int threads)
  --
  -- DATE: Feb 20, 2011
  --
- -- REVISIONS: (Date and Description)
+ -- REVISIONS: October 18, 2026 - Added the churn mode. When churn is set, each
+ -- iteration opens, uses and closes the connections instead of reusing them.
+ -- October 18, 2026 - Each connection is given a class from the workload
+ -- profile, if there is one.
+ -- October 18, 2026 - The receive buffer is allocated on the thread's own
+ -- NUMA node.
+ -- October 18, 2026 - Counts the thread's system calls and context switches
+ -- in its shared slot.
+ -- October 18, 2026 - Times connections and pacing with timingNow.
+ -- October 18, 2026 - A persistent connection that misbehaved is made again.
+ -- October 18, 2026 - Runs as a worker of the pool, taking connection tasks
+ -- from its own queue or from the other workers'. The passes over the
+ -- connections are now made by runTask.
  --
  -- DESIGNER: Luke Queenan
  --
@@ -238,125 +757,196 @@ void createClients(threadData clientData, int threads)
  -- RETURNS: void
  --
  -- NOTES:
- -- The client thread, loops through the created sockets and sends and receives
- -- data. Once the total number of requests is met, the data is sent to the data
- -- processing function. The thread exits.
+ -- The client worker, takes a connection task, makes a pass over it and puts
+ -- it back on its own queue until the task is done. When it has nothing due
+ -- of its own it takes the tasks of the other workers, so a worker that
+ -- finishes early helps the busy ones instead of sitting idle. Once every
+ -- task is done, or the client is stopped, the data processing function is
+ -- told and the thread exits. The results are kept in the worker's shared
+ -- slot as they are made.
  */
 void *client(void *information)
 {
     /* Create local variables and assign defualt values */
-    int read = 0;
-    int result = 0;
-    int *sockets = 0;
-    register int index = 0;
-    unsigned long long count = 0;
-    unsigned long long dataReceived = 0;
-    unsigned long long requestTime = 0;
-    char *buffer = 0;
-    char request[NETWORK_BUFFER_SIZE];
-    struct timeval startTime;
-    struct timeval endTime;
-    threadData *data = (threadData *)information;
+    int task = 0;
+    unsigned long long runs = 0;
+    unsigned long long attempts = 0;
+    unsigned long long startTime = 0;
+    unsigned long long now = 0;
+    unsigned long long wait = 0;
+    clientState state;
+    workerData *worker = (workerData *)information;
+    threadData *data = worker->data;
+    workPool *pool = worker->pool;
+    
+    memset(&state, 0, sizeof(clientState));
+    state.results = worker->results;
+    engineAttach(&state.results->engine);
     
-    /* Allocate memory and other setup */
-    if ((buffer = malloc(sizeof(char) * NETWORK_BUFFER_SIZE)) == NULL)
+    /* Allocate memory and other setup, the buffer is touched by this thread
+     so that it lands on the node the thread was placed on */
+    if ((state.buffer = localAlloc(sizeof(char) * NETWORK_BUFFER_SIZE)) == NULL)
     {
         systemFatal("Could not allocate buffer memory");
     }
-    if ((sockets = malloc(sizeof(int) * data->clients)) == NULL)
+    
+    /* Convert the request size or file to a new line terminated string */
+    if (data->path != 0)
+    {
+        snprintf(state.request, sizeof(state.request), "%s\n", data->path);
+    }
+    else
     {
-        systemFatal("Could not allocate socket memory");
+        snprintf(state.request, sizeof(state.request), "%d\n", data->request);
     }
     
-    /* Convert the request size to a new line terminated string */
-    snprintf(request, sizeof(request), "%d\n", data->request);
+    /* Every thread draws from its own random sequence */
+    startTime = wallClock();
+    state.seed = (startTime << 32) ^ (startTime >> 32) ^
+                 (unsigned long long)(unsigned long)worker;
+    state.seed |= 1;
+    
+    /* Start the pacing clock for the connection rate */
+    startTime = timingNow();
     
-    for (index = 0; index < data->clients; index++)
-    {      
-        /* Create a socket and connect to the server */
-        result = connectToServer(data->port, &sockets[index], data->ip);
+    /* Run tasks until they are all done or the user stops the client */
+    while (pool->remaining > 0 && !shared->stop)
+    {
+        now = timingNow();
+        if ((task = takeTask(pool, worker->index, now, &wait)) == -1)
+        {
+            /* Everything is pausing or being run by another worker */
+            usleep(wait / 1000);
+            continue;
+        }
         
-        /* Set the socket to reuse for improper shutdowns */
-        if ((result == -1) || (setReuse(&sockets[index]) == -1))
+        /* Hold back until the next connection is due */
+        if (data->churn != 0 && data->rate != 0)
         {
-            break;
+            pace((now - startTime) / 1000, attempts * 1000000ULL / data->rate);
+            attempts++;
+        }
+        
+        if (runTask(data, &state, &pool->tasks[task]))
+        {
+            __sync_sub_and_fetch(&pool->remaining, 1);
+        }
+        else
+        {
+            putTask(pool, worker->index, task);
+        }
+        
+        /* Bring the context switches up to date every so often */
+        if (++runs % ENGINE_SAMPLE_EVERY == 0)
+        {
+            engineSample(&state.results->engine);
         }
     }
     
-    /* Ensure that we connected to the server */
-    if (result != -1)
+    /* Tell the comms process that this thread is done */
+    engineSample(&state.results->engine);
+    setNetworkCounters(NULL);
+    if (sendData(&data->comm, "D", 1) == -1)
     {
-        /* Enter a loop and communicate with the server */
-        while (1)
-        {
-            count++;
-            
-            for (index = 0; index < data->clients; index++)
-            {
-                /* Get time before sending data */
-                gettimeofday(&startTime, NULL);
-                
-                /* Send data */
-                if (sendData(&sockets[index], request, strlen(request)) == -1)
-                {
-                    continue;
-                }
-
-                /* Receive data from the server */
-                if ((read = readData(&sockets[index], buffer, data->request)) == -1)
-                {
-                    continue;
-                }
-                
-                /* Get time after receiving response */
-                gettimeofday(&endTime, NULL);
-                
-                /* Save data */
-                dataReceived += read;
-                requestTime += (endTime.tv_sec * 1000000 + endTime.tv_usec) -
-                               (startTime.tv_sec * 1000000 + startTime.tv_usec);
-            }
+        systemFatal("Unable to send result data");
+    }
+    
+    localFree(state.buffer, sizeof(char) * NETWORK_BUFFER_SIZE);
+    
+    pthread_exit(NULL);
+}
 
-            /* Increment count and check to see if we are done */
-            if (count >= data->maxRequests)
+/*
+ -- FUNCTION: runTask
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Waits out the think time of the profile
+ -- the way it waits out a pause, instead of the request sleeping.
+ -- October 19, 2026 - Every pass sets the due time, so the queues can be
+ -- kept in order of it.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int runTask(threadData *data, clientState *state,
+ --                               connectionTask *task)
+ --
+ -- RETURNS: 1 if the task is done, 0 if it has passes left
+ --
+ -- NOTES:
+ -- Makes one pass of a connection task. In churn mode a pass is a whole
+ -- connection. Otherwise it is one request on the task's own connection,
+ -- which is made on the first pass and again after a misbehaving request
+ -- threw it away. A task whose connection cannot be made is done. The task
+ -- is not due again until the think time drawn for its requests and the
+ -- pause are over, so the worker runs other tasks in the meantime.
+ */
+static int runTask(threadData *data, clientState *state, connectionTask *task)
+{
+    unsigned long long startTime = 0;
+    unsigned long long think = 0;
+    
+    if (data->churn != 0)
+    {
+        churnConnection(data, state, &think);
+    }
+    else
+    {
+        if (task->socket == -1)
+        {
+            /* Create a socket and connect to the server */
+            startTime = timingNow();
+            if (connectToServer(data->port, &task->socket, data->ip) == -1)
             {
-                break;
+                state->results->errors++;
+                task->socket = -1;
+                return 1;
             }
+            state->results->connections++;
+            state->results->connectTime += timingNow() - startTime;
             
-            /* Wait the specified amount of time between requests */
-            if (data->pause != 0)
+            /* Set the socket to reuse for improper shutdowns */
+            setReuse(&task->socket);
+            
+            /* The class stays with the task when it connects again */
+            if (task->passes == 0)
             {
-                sleep(data->pause);
+                task->connectionClass = pickClass(data, state);
             }
         }
+        
+        if (!misbehave(data, state, &task->socket))
+        {
+            timedRequest(data, state, &task->socket, task->connectionClass,
+                         &think);
+        }
     }
     
-    /* Clean up */
-    for (index = 0; index < data->clients; index++)
-    {
-        closeSocket(&sockets[index]);
-    }
-    
-    /* Create and format data for output */
-    snprintf(request, sizeof(request), "Clients: %d, Requests Each: %llu, "
-    "Total Request Time: %llu, Total Data Received: %llu\n", data->clients,
-    count, requestTime, dataReceived);
-    
-    /* Send data to comms process */
-    if (sendData(&data->comm, request, strlen(request)) == -1)
+    /* A maximum of zero runs until the user stops the client */
+    task->passes++;
+    if (data->maxRequests != 0 && task->passes >= data->maxRequests)
     {
-        systemFatal("Unable to send result data");
+        if (task->socket != -1)
+        {
+            closeSocket(&task->socket);
+            task->socket = -1;
+        }
+        return 1;
     }
     
-    free(buffer);
+    /* Think, then wait the specified amount of time between requests. A
+     task with neither is due now, behind the tasks that came due before */
+    task->due = timingNow() + think * 1000 + data->pause * 1000000000ULL;
     
-    pthread_exit(NULL);
+    return 0;
 }
 
 /*
- -- FUNCTION: dataCollector
+ -- FUNCTION: takeTask
  --
- -- DATE: Feb 20, 2011
+ -- DATE: October 18, 2026
  --
  -- REVISIONS: (Date and Description)
  --
@@ -364,68 +954,1207 @@ void *client(void *information)
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: void dataCollector(int, int)
+ -- INTERFACE: static int takeTask(workPool *pool, int worker,
+ --                                unsigned long long now,
+ --                                unsigned long long *wait)
  --
- -- RETURNS: 0 on success
+ -- RETURNS: the task taken, or -1 if none is due
  --
  -- NOTES:
- -- The function blocks on a read from the local socket and processes the data
- -- when it is received. Once all the clients are completed, it exits.
+ -- Takes the oldest task of the worker's own queue if it is due, and
+ -- otherwise steals the oldest due task of another worker. Thieves start
+ -- with the worker after them, so they spread out over the queues, and an
+ -- empty queue is passed over without taking its lock. putTask keeps a
+ -- queue in order of due time, so its head is the one due soonest. When
+ -- nothing is due wait is set to how long the soonest task has left, or
+ -- TASK_IDLE_WAIT if all the tasks are being run.
  */
-void dataCollector(int socket, int clients)
+static int takeTask(workPool *pool, int worker, unsigned long long now,
+                    unsigned long long *wait)
 {
-    char *buffer;
-    int fd = 0;
     int count = 0;
-    int clientCount = 0;
-    
-    signal(SIGINT, stopCollecting);
-    
-    if ((buffer = malloc(sizeof(char) * LOCAL_BUFFER_SIZE)) == NULL)
-    {
-        systemFatal("Could not allocate buffer memory");
-    }
-    
-    if ((fd = open("clientData.txt", O_WRONLY | O_CREAT, 0666)) == -1)
-    {
-        systemFatal("Unable to create client data file");
-    }
+    int victim = worker;
+    int task = -1;
+    taskQueue *queue = 0;
+    connectionTask *head = 0;
     
-    while (1)
+    *wait = TASK_IDLE_WAIT;
+    for (count = 0; count < pool->workers && task == -1; count++)
     {
-        if ((count = readLine(&socket, buffer, LOCAL_BUFFER_SIZE)) == -1)
-        {
-            systemFatal("Error reading client data");
-        }
-        
-        if (write(fd, buffer, ++count) == -1)
+        queue = &pool->queues[victim];
+        victim = (victim + 1) % pool->workers;
+        if (queue->head == -1)
         {
-            systemFatal("Unable to write client data to file");
+            continue;
         }
         
-        if (++clientCount >= clients)
+        pthread_mutex_lock(&queue->lock);
+        if (queue->head != -1)
         {
-            break;
+            head = &pool->tasks[queue->head];
+            if (head->due <= now)
+            {
+                task = queue->head;
+                queue->head = head->next;
+                if (queue->head == -1)
+                {
+                    queue->tail = -1;
+                }
+            }
+            else if (head->due - now < *wait)
+            {
+                *wait = head->due - now;
+            }
         }
+        pthread_mutex_unlock(&queue->lock);
     }
     
-    close(fd);
-    close(socket);
-    exit(0);
+    return task;
 }
 
-void stopClients()
-{
-    printf("\nShutting down client process and threads\n");
-    exit(0);
+/*
+ -- FUNCTION: putTask
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ -- October 19, 2026 - Keeps the queue in order of due time
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void putTask(workPool *pool, int worker, int task)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Adds a task to a worker's queue, after every task due no later than it.
+ -- The queues are lists threaded through the tasks, so a queue holds any
+ -- number of them. Most tasks are due after everything already queued and
+ -- go on the back; only a shorter think time walks the list.
+ */
+static void putTask(workPool *pool, int worker, int task)
+{
+    taskQueue *queue = &pool->queues[worker];
+    connectionTask *tasks = pool->tasks;
+    unsigned long long due = tasks[task].due;
+    int previous = -1;
+    int current = 0;
+    
+    tasks[task].next = -1;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->tail == -1)
+    {
+        queue->head = task;
+        queue->tail = task;
+    }
+    else if (tasks[queue->tail].due <= due)
+    {
+        tasks[queue->tail].next = task;
+        queue->tail = task;
+    }
+    else
+    {
+        /* The tail is due later, so the walk stops before running off the end */
+        current = queue->head;
+        while (tasks[current].due <= due)
+        {
+            previous = current;
+            current = tasks[current].next;
+        }
+        tasks[task].next = current;
+        if (previous == -1)
+        {
+            queue->head = task;
+        }
+        else
+        {
+            tasks[previous].next = task;
+        }
+    }
+    pthread_mutex_unlock(&queue->lock);
 }
 
-void stopCollecting()
+/*
+ -- FUNCTION: churnConnection
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - A request may be replaced by a misbehaving
+ -- one, which ends the connection.
+ -- October 18, 2026 - Adds up the think time of its requests for the task
+ -- to wait out instead of sleeping.
+ -- October 19, 2026 - A connection that cannot be made is counted as an
+ -- error.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int churnConnection(threadData *data,
+ --                                       clientState *state,
+ --                                       unsigned long long *think)
+ --
+ -- RETURNS: 0 on success, -1 if the connection could not be made
+ --
+ -- NOTES:
+ -- Opens a single connection, sends the churn number of requests over it and
+ -- then closes it. The time taken by connect is recorded separately from the
+ -- request time so that the accept path of the server can be measured on its
+ -- own. A failed connect is counted as an error, so trouble on the accept
+ -- path shows up in the results. The requests go back to back, and the think
+ -- time drawn for them is added to think, in microseconds, for the task to
+ -- wait out once the connection is closed.
+ */
+static int churnConnection(threadData *data, clientState *state,
+                           unsigned long long *think)
+{
+    int socket = 0;
+    unsigned int count = 0;
+    unsigned int connectionClass = 0;
+    unsigned long long startTime = 0;
+    unsigned long long endTime = 0;
+    
+    /* Time the connection setup on its own */
+    startTime = timingNow();
+    if (connectToServer(data->port, &socket, data->ip) == -1)
+    {
+        state->results->errors++;
+        return -1;
+    }
+    endTime = timingNow();
+    
+    state->results->connections++;
+    state->results->connectTime += endTime - startTime;
+    connectionClass = pickClass(data, state);
+    
+    for (count = 0; count < data->churn; count++)
+    {
+        if (misbehave(data, state, &socket))
+        {
+            return 0;
+        }
+        if (timedRequest(data, state, &socket, connectionClass,
+                         think) == -1)
+        {
+            break;
+        }
+    }
+    
+    closeSocket(&socket);
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: timedRequest
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Added file requests.
+ -- October 18, 2026 - Timed with timingNow in nanoseconds.
+ -- October 18, 2026 - Hands the think time back instead of sleeping it.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int timedRequest(threadData *data, clientState *state,
+ --                                    int *socket,
+ --                                    unsigned int connectionClass,
+ --                                    unsigned long long *think)
+ --
+ -- RETURNS: the number of bytes received, -1 on failure
+ --
+ -- NOTES:
+ -- Sends a single request on the socket, waits for the reply and adds the
+ -- round trip time and received data to the results. With a workload profile
+ -- the request size is drawn from the connection's class, and the class think
+ -- time is added to think, in microseconds, for the caller to wait out
+ -- without holding up its worker. When a file is being requested the reply
+ -- is as long as the file.
+ */
+static int timedRequest(threadData *data, clientState *state, int *socket,
+                        unsigned int connectionClass,
+                        unsigned long long *think)
+{
+    int read = 0;
+    int bytes = data->request;
+    int length = 0;
+    char line[16];
+    const char *request = state->request;
+    const workloadClass *profileClass = 0;
+    unsigned long long startTime = 0;
+    unsigned long long endTime = 0;
+    
+    /* Draw the request size from the profile, away from the timed section */
+    if (data->profile != 0)
+    {
+        profileClass = &data->profile->classList[connectionClass];
+        bytes = sampleDistribution(&profileClass->size, &state->seed);
+        *think += sampleDistribution(&profileClass->think, &state->seed);
+    }
+    
+    /* A file request keeps its name, the size comes back with the reply */
+    if (profileClass != 0 && data->path == 0)
+    {
+        length = snprintf(line, sizeof(line), "%d\n", bytes);
+        request = line;
+    }
+    else
+    {
+        length = strlen(request);
+    }
+    
+    /* Get time before sending data */
+    startTime = timingNow();
+    
+    /* Send data */
+    if (sendData(socket, request, length) == -1)
+    {
+        state->results->errors++;
+        return -1;
+    }
+    
+    /* Receive data from the server */
+    if (data->path != 0)
+    {
+        read = readFileReply(socket, state);
+    }
+    else if ((read = readData(socket, state->buffer, bytes)) != bytes)
+    {
+        read = -1;
+    }
+    if (read == -1)
+    {
+        state->results->errors++;
+        return -1;
+    }
+    
+    /* Get time after receiving response */
+    endTime = timingNow();
+    
+    /* Save data */
+    state->results->requests++;
+    state->results->dataReceived += read;
+    histogramRecord(&state->results->latency, endTime - startTime);
+    
+    return read;
+}
+
+/*
+ -- FUNCTION: misbehave
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int misbehave(threadData *data, clientState *state,
+ --                                 int *socket)
+ --
+ -- RETURNS: 1 if the connection misbehaved and was closed, 0 otherwise
+ --
+ -- NOTES:
+ -- Decides, fuzz times in a hundred, to spend the connection on one of the
+ -- requests a server has to survive instead of a real one. The connection
+ -- is closed afterwards, and the caller makes a new one if it wants it. None
+ -- of it is timed or counted as a request.
+ */
+static int misbehave(threadData *data, clientState *state, int *socket)
+{
+    struct linger linger;
+    
+    if (data->fuzz == 0 || nextRandom(&state->seed) % 100 >= data->fuzz)
+    {
+        return 0;
+    }
+    
+    switch (nextRandom(&state->seed) % 4)
+    {
+        case 0:
+            /* More bytes than any server will send */
+            sendData(socket, "999999\n", 7);
+            break;
+        case 1:
+            /* Not a number */
+            sendData(socket, "fuzz\n", 5);
+            break;
+        case 2:
+            /* Reset the connection while the reply is on its way */
+            sendData(socket, state->request, strlen(state->request));
+            linger.l_onoff = 1;
+            linger.l_linger = 0;
+            setsockopt(*socket, SOL_SOCKET, SO_LINGER, &linger,
+                       sizeof(linger));
+            break;
+        default:
+            /* Half a request and then nothing */
+            sendData(socket, "12", 2);
+            break;
+    }
+    
+    state->results->misbehaved++;
+    closeSocket(socket);
+    *socket = -1;
+    
+    return 1;
+}
+
+/*
+ -- FUNCTION: readFileReply
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int readFileReply(int *socket, clientState *state)
+ --
+ -- RETURNS: the size of the file, -1 on failure
+ --
+ -- NOTES:
+ -- Reads the reply to a file request, which is the size of the file on a line
+ -- of its own followed by the file. The file is read through the thread's
+ -- buffer a piece at a time. A size of -1 means the server could not serve
+ -- the file.
+ */
+static int readFileReply(int *socket, clientState *state)
+{
+    int count = 0;
+    int chunk = 0;
+    long long size = 0;
+    long long remaining = 0;
+    char line[32];
+    
+    if ((count = readLine(socket, line, sizeof(line) - 1)) <= 0)
+    {
+        return -1;
+    }
+    line[count] = '\0';
+    
+    if ((size = atoll(line)) < 0 || size > INT_MAX)
+    {
+        return -1;
+    }
+    
+    for (remaining = size; remaining > 0; remaining -= chunk)
+    {
+        chunk = (remaining > NETWORK_BUFFER_SIZE) ? NETWORK_BUFFER_SIZE :
+                remaining;
+        if (readData(socket, state->buffer, chunk) != chunk)
+        {
+            return -1;
+        }
+    }
+    
+    return size;
+}
+
+/*
+ -- FUNCTION: pickClass
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static unsigned int pickClass(threadData *data,
+ --                                          clientState *state)
+ --
+ -- RETURNS: the workload class for a new connection
+ --
+ -- NOTES:
+ -- Draws a class from the profile mix. Without a profile every connection is
+ -- in class zero.
+ */
+static unsigned int pickClass(threadData *data, clientState *state)
 {
-    printf("\nClient data collection process is shutting down\n"); 
+    if (data->profile == 0)
+    {
+        return 0;
+    }
+    
+    return sampleDistribution(&data->profile->mix, &state->seed);
+}
+
+/*
+ -- FUNCTION: pace
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void pace(unsigned long long elapsed,
+ --                             unsigned long long due)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Sleeps until the due time, in microseconds since the pacing clock started.
+ -- If the thread is already behind schedule it returns straight away so that
+ -- the target rate is caught up on rather than lost.
+ */
+static void pace(unsigned long long elapsed, unsigned long long due)
+{
+    if (due > elapsed)
+    {
+        usleep(due - elapsed);
+    }
+}
+
+/*
+ -- FUNCTION: dataCollector
+ --
+ -- DATE: Feb 20, 2011
+ --
+ -- REVISIONS: October 18, 2026 - The thread results arrive in binary form and
+ -- are merged into a run in the binary results file. The file is appended to
+ -- rather than overwritten, so earlier runs are kept.
+ -- October 18, 2026 - The thread counters are read from shared memory every
+ -- interval and each interval is printed and written out as it ends. SIGINT
+ -- now ends the run with a final summary instead of losing it.
+ -- October 18, 2026 - The summary is followed by the cost of the run per
+ -- request.
+ -- October 18, 2026 - Reports the misbehaving connections.
+ -- October 19, 2026 - The summary gives the connections made, their rate
+ -- and the mean time to connect again.
+ -- October 19, 2026 - Intervals and rates are timed with timingNow, the
+ -- wall clock only stamps the run's records.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void dataCollector(int socket, int clients, const char *path,
+ --                               const char *config, unsigned int interval)
+ --
+ -- RETURNS: 0 on success
+ --
+ -- NOTES:
+ -- The function waits on the local socket, where each client thread writes a
+ -- byte when it is done, and wakes up every interval milliseconds to take a
+ -- snapshot of the thread counters. The difference from the last snapshot is
+ -- reported as the interval. Once all the clients are completed, or the user
+ -- interrupts the run, the last interval and a summary of the run are
+ -- written and the process exits. Durations come from the monotonic clock,
+ -- so a step of the wall clock during the run does not skew the rates.
+ */
+void dataCollector(int socket, int clients, const char *path,
+                   const char *config, unsigned int interval)
+{
+    int clientCount = 0;
+    int result = 0;
+    int timeout = -1;
+    char done[64];
+    char cost[256];
+    unsigned long long startStamp = wallClock();
+    unsigned long long startTime = timingNow();
+    unsigned long long lastTime = startTime;
+    unsigned long long now = 0;
+    struct pollfd event;
+    engineCounters none;
+    resultsWriter *writer = 0;
+    clientResults *previous = 0;
+    clientResults *current = 0;
+    histogram *latency = 0;
+    
+    signal(SIGINT, stopCollecting);
+    
+    if ((writer = malloc(sizeof(resultsWriter))) == NULL ||
+        (previous = calloc(1, sizeof(clientResults))) == NULL ||
+        (current = malloc(sizeof(clientResults))) == NULL ||
+        (latency = malloc(sizeof(histogram))) == NULL)
+    {
+        systemFatal("Could not allocate buffer memory");
+    }
+    
+    if (openResults(writer, path) == -1 ||
+        writeRunHeader(writer, startStamp, config) == -1)
+    {
+        systemFatal("Unable to create client data file");
+    }
+    
+    event.fd = socket;
+    event.events = POLLIN;
+    
+    while (clientCount < clients && collecting)
+    {
+        /* Sleep until the end of the interval or a thread finishing */
+        if (interval != 0)
+        {
+            now = timingNow();
+            timeout = (lastTime + interval * 1000000ULL > now) ?
+                      (lastTime + interval * 1000000ULL - now) / 1000000 : 0;
+        }
+        
+        if ((result = poll(&event, 1, timeout)) > 0)
+        {
+            if ((result = read(socket, done, sizeof(done))) <= 0)
+            {
+                break;
+            }
+            clientCount += result;
+        }
+        else if (result == -1 && errno != EINTR)
+        {
+            systemFatal("Error reading client data");
+        }
+        
+        now = timingNow();
+        if (interval != 0 && now >= lastTime + interval * 1000000ULL)
+        {
+            collectInterval(writer, previous, current, latency,
+                            now - startTime, now - lastTime);
+            lastTime = now;
+        }
+    }
+    
+    if (!collecting)
+    {
+        printf("\nClient data collection process is shutting down\n");
+    }
+    
+    /* Whatever happened since the last interval is the final interval */
+    now = timingNow();
+    collectInterval(writer, previous, current, latency, now - startTime,
+                    now - lastTime);
+    
+    if (closeResults(writer, wallClock()) == -1)
+    {
+        systemFatal("Unable to write client data to file");
+    }
+    
+    printf("Requests: %llu (%.1f/s), Data Received: %llu, Errors: %llu, "
+           "Mean Latency: %lluus, 99th Percentile: %lluus\n",
+           previous->requests, previous->requests * 1e9 / (now - startTime),
+           previous->dataReceived, previous->errors, previous->requests ?
+           previous->latency.total / previous->requests / 1000 : 0,
+           histogramPercentile(&previous->latency, 99) / 1000);
+    printf("Connections: %llu (%.1f/s), Mean Connect Time: %lluus\n",
+           previous->connections,
+           previous->connections * 1e9 / (now - startTime),
+           previous->connections ?
+           previous->connectTime / previous->connections / 1000 : 0);
+    if (previous->misbehaved != 0)
+    {
+        printf("Misbehaving connections: %llu\n", previous->misbehaved);
+    }
+    
+    /* What the whole run cost per request */
+    memset(&none, 0, sizeof(engineCounters));
+    engineDescribe(&previous->engine, &none, cost, sizeof(cost));
+    printf("Client cost: %s\n", cost);
+    
+    free(latency);
+    free(current);
+    free(previous);
+    free(writer);
+    close(socket);
     exit(0);
 }
 
+/*
+ -- FUNCTION: collectInterval
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Adds up the engine counters and reports the
+ -- system calls per request.
+ -- October 18, 2026 - Adds up the misbehaving connections.
+ -- October 19, 2026 - Reports the connections made a second and their mean
+ -- connect time.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void collectInterval(resultsWriter *writer,
+ --                                        clientResults *previous,
+ --                                        clientResults *current,
+ --                                        histogram *latency,
+ --                                        unsigned long long elapsed,
+ --                                        unsigned long long duration)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Adds up the thread counters, reports the change since the previous
+ -- snapshot and makes the new snapshot the previous one. The threads keep
+ -- running while their counters are read, so an interval may be off by the
+ -- odd request at its edges, which the next interval makes up for.
+ */
+static void collectInterval(resultsWriter *writer, clientResults *previous,
+                            clientResults *current, histogram *latency,
+                            unsigned long long elapsed,
+                            unsigned long long duration)
+{
+    int index = 0;
+    resultsInterval interval;
+    
+    memset(current, 0, sizeof(clientResults));
+    for (index = 0; index < shared->threads; index++)
+    {
+        current->requests += shared->slot[index].requests;
+        current->dataReceived += shared->slot[index].dataReceived;
+        current->connections += shared->slot[index].connections;
+        current->connectTime += shared->slot[index].connectTime;
+        current->errors += shared->slot[index].errors;
+        current->misbehaved += shared->slot[index].misbehaved;
+        engineAdd(&current->engine, &shared->slot[index].engine);
+        histogramMerge(&current->latency, &shared->slot[index].latency);
+    }
+    current->engine.requests = current->requests;
+    
+    memset(&interval, 0, sizeof(resultsInterval));
+    interval.offset = elapsed - duration;
+    interval.duration = duration;
+    interval.requests = current->requests - previous->requests;
+    interval.bytes = current->dataReceived - previous->dataReceived;
+    interval.connections = current->connections - previous->connections;
+    interval.connectTime = current->connectTime - previous->connectTime;
+    interval.errors = current->errors - previous->errors;
+    histogramSubtract(latency, &current->latency, &previous->latency);
+    
+    printf("%8.2fs: %10.1f req/s, %8.2f MB/s, 50%% %6lluus, 99%% %6lluus, "
+           "%.1f conn/s, connect %lluus, errors %llu, %.2f syscalls/req\n",
+           elapsed / 1e9, duration ? interval.requests * 1e9 / duration : 0,
+           duration ? interval.bytes * 1e3 / duration : 0,
+           histogramPercentile(latency, 50) / 1000,
+           histogramPercentile(latency, 99) / 1000,
+           duration ? interval.connections * 1e9 / duration : 0,
+           interval.connections ? (unsigned long long)(interval.connectTime /
+                                  interval.connections / 1000) : 0ULL,
+           (unsigned long long)interval.errors,
+           interval.requests ? (double)(current->engine.network.syscalls -
+                                        previous->engine.network.syscalls) /
+                               interval.requests : 0);
+    fflush(stdout);
+    
+    if (writeInterval(writer, &interval, latency) == -1)
+    {
+        systemFatal("Unable to write client data to file");
+    }
+    
+    memcpy(previous, current, sizeof(clientResults));
+}
+
+/*
+ -- FUNCTION: runWorker
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void runWorker(int port, int notify)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Runs the client as a worker for a coordinator. The worker listens on the
+ -- port for a coordinator, which sends two lines:
+ --
+ --     RUN <client options>
+ --     START <start time in nanoseconds since the epoch>
+ --
+ -- The run is made in a child process that writes its results to a temporary
+ -- file, and once it finishes the worker answers with
+ --
+ --     RESULT <length>
+ --
+ -- followed by the records of the run in the binary results format, or with
+ -- an ERROR line. A worker started by the coordinator itself is given a pipe
+ -- in notify, listens on a free port on the loopback address, writes that
+ -- port to the pipe and serves one run only. Otherwise it serves runs until
+ -- it is killed.
+ */
+static void runWorker(int port, int notify)
+{
+    int listenSocket = 0;
+    int socket = 0;
+    int count = 0;
+    int argc = 0;
+    int status = 0;
+    char line[NETWORK_BUFFER_SIZE];
+    char arguments[NETWORK_BUFFER_SIZE];
+    char path[] = "/tmp/clientWorkerXXXXXX";
+    char *argv[64];
+    char *rest = 0;
+    unsigned long long startTime = 0;
+    pid_t child = 0;
+    size_t offset = 0;
+    size_t runOffset = 0;
+    const resultsRecord *record = 0;
+    resultsFile file;
+    clientOptions *options = 0;
+    
+    if ((listenSocket = tcpSocket()) == -1 ||
+        setReuse(&listenSocket) == -1 ||
+        (notify == -1 ? bindAddress(&port, &listenSocket) :
+         bindLoopback(&port, &listenSocket)) == -1 ||
+        setListen(&listenSocket) == -1)
+    {
+        systemFatal("Unable to listen for a coordinator");
+    }
+    
+    if (notify != -1)
+    {
+        if (write(notify, &port, sizeof(port)) != sizeof(port))
+        {
+            systemFatal("Unable to report worker port");
+        }
+        close(notify);
+    }
+    
+    do
+    {
+        if ((socket = acceptConnection(&listenSocket)) == -1)
+        {
+            systemFatal("Unable to accept coordinator");
+        }
+        
+        /* Read the options and the start time */
+        if ((count = readLine(&socket, arguments, sizeof(arguments) - 1)) <= 0 ||
+            strncmp(arguments, "RUN ", 4) != 0 ||
+            readLine(&socket, line, sizeof(line) - 1) <= 0 ||
+            sscanf(line, "START %llu", &startTime) != 1)
+        {
+            closeSocket(&socket);
+            continue;
+        }
+        arguments[count] = '\0';
+        
+        /* Split the options up the way the shell would have */
+        argv[0] = "client";
+        argc = 1;
+        for (argv[argc] = strtok_r(arguments + 4, " \n", &rest);
+             argv[argc] != NULL && argc < 63;
+             argv[argc] = strtok_r(NULL, " \n", &rest))
+        {
+            argc++;
+        }
+        argv[argc] = NULL;
+        
+        memcpy(path + sizeof(path) - 7, "XXXXXX", 6);
+        if ((count = mkstemp(path)) == -1)
+        {
+            systemFatal("Unable to create worker results file");
+        }
+        close(count);
+        
+        /* Make the run in a child so each run starts fresh */
+        if ((child = fork()) == 0)
+        {
+            closeSocket(&listenSocket);
+            closeSocket(&socket);
+            if ((options = malloc(sizeof(clientOptions))) == NULL ||
+                parseOptions(argc, argv, options) == -1)
+            {
+                exit(EXIT_FAILURE);
+            }
+            options->resultsPath = path;
+            options->startTime = startTime;
+            runClients(options);
+            exit(0);
+        }
+        
+        waitpid(child, &status, 0);
+        
+        /* The mapping outlives the file, so it can go straight away */
+        if (child == -1 || mapResults(path, &file) == -1)
+        {
+            file.size = 0;
+        }
+        unlink(path);
+        
+        /* Send back the last run in the file, which is the one just made */
+        if (file.size == 0)
+        {
+            sendData(&socket, "ERROR run failed\n", 17);
+        }
+        else
+        {
+            offset = 0;
+            runOffset = 0;
+            while ((record = nextRecord(&file, &offset)) != NULL)
+            {
+                if (record->type == RESULTS_RUN)
+                {
+                    runOffset = (const char *)record - file.data;
+                }
+            }
+            
+            count = snprintf(line, sizeof(line), "RESULT %lu\n",
+                             (unsigned long)(file.size - runOffset));
+            sendData(&socket, line, count);
+            sendData(&socket, file.data + runOffset, file.size - runOffset);
+            unmapResults(&file);
+        }
+        
+        closeSocket(&socket);
+    } while (notify == -1);
+    
+    closeSocket(&listenSocket);
+}
+
+/*
+ -- FUNCTION: coordinate
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Connects to the workers without the source
+ -- addresses, which are for the workers' connections to the server.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int coordinate(clientOptions *options)
+ --
+ -- RETURNS: 0 on success, 1 if any worker failed
+ --
+ -- NOTES:
+ -- Runs the client options on a set of workers at once. The workers are
+ -- either a comma separated list of host:port pairs, each running the client
+ -- with -W, or local:N to start N workers on this machine. Every worker is
+ -- sent the same options and a start time a little in the future, so the
+ -- workers start together as long as their clocks agree. The runs they send
+ -- back are merged interval by interval into one run, which is printed and
+ -- written to the results file.
+ */
+static int coordinate(clientOptions *options)
+{
+    int count = 0;
+    int index = 0;
+    int workers = 0;
+    int result = 0;
+    int local = 0;
+    int port = 0;
+    int sockets[COORDINATOR_MAX_WORKERS];
+    char *names[COORDINATOR_MAX_WORKERS];
+    char *buffers[COORDINATOR_MAX_WORKERS];
+    char list[NETWORK_BUFFER_SIZE];
+    char line[NETWORK_BUFFER_SIZE];
+    char config[RESULTS_CONFIG_SIZE];
+    char portText[8];
+    char *host = 0;
+    char *rest = 0;
+    char *colon = 0;
+    unsigned long length = 0;
+    unsigned long long startTime = 0;
+    resultsFile files[COORDINATOR_MAX_WORKERS];
+    runList runs;
+    runSummary merged;
+    resultsWriter *writer = 0;
+    
+    memset(&runs, 0, sizeof(runList));
+    memset(buffers, 0, sizeof(buffers));
+    snprintf(list, sizeof(list), "%s", options->workers);
+    setSourceAddresses(NULL);
+    
+    /* Start local workers, or connect to the listed ones */
+    if (sscanf(list, "local:%d", &local) == 1)
+    {
+        for (workers = 0; workers < local &&
+             workers < COORDINATOR_MAX_WORKERS; workers++)
+        {
+            port = spawnWorker();
+            snprintf(portText, sizeof(portText), "%d", port);
+            if (connectToServer(portText, &sockets[workers],
+                                "127.0.0.1") == -1)
+            {
+                systemFatal("Unable to connect to local worker");
+            }
+            snprintf(line, sizeof(line), "local:%d", port);
+            names[workers] = strdup(line);
+        }
+    }
+    else
+    {
+        for (host = strtok_r(list, ",", &rest);
+             host != NULL && workers < COORDINATOR_MAX_WORKERS;
+             host = strtok_r(NULL, ",", &rest))
+        {
+            if ((colon = strrchr(host, ':')) == NULL)
+            {
+                fprintf(stderr, "Worker %s needs a port\n", host);
+                return 1;
+            }
+            *colon = '\0';
+            if (connectToServer(colon + 1, &sockets[workers], host) == -1)
+            {
+                fprintf(stderr, "Unable to connect to worker %s\n", host);
+                return 1;
+            }
+            *colon = ':';
+            names[workers++] = strdup(host);
+        }
+    }
+    
+    /* Send everyone the same options and start time */
+    describeArguments(options, line, sizeof(line));
+    startTime = wallClock() + COORDINATOR_LEAD;
+    count = strlen(line);
+    count += snprintf(line + count, sizeof(line) - count, "START %llu\n",
+                      startTime);
+    for (index = 0; index < workers; index++)
+    {
+        if (sendData(&sockets[index], line, count) == -1)
+        {
+            systemFatal("Unable to start worker");
+        }
+    }
+    
+    printf("Started %d workers\n", workers);
+    
+    /* Collect the runs as the workers finish */
+    for (index = 0; index < workers; index++)
+    {
+        if ((count = readLine(&sockets[index], line, sizeof(line) - 1)) <= 0 ||
+            (line[count] = '\0', sscanf(line, "RESULT %lu", &length)) != 1 ||
+            (buffers[index] = malloc(length)) == NULL ||
+            readData(&sockets[index], buffers[index], length) !=
+            (int)length)
+        {
+            fprintf(stderr, "Worker %s failed\n", names[index]);
+            result = 1;
+            closeSocket(&sockets[index]);
+            continue;
+        }
+        
+        files[index].data = buffers[index];
+        files[index].size = length;
+        if (addRuns(&runs, &files[index], names[index], -1) == -1)
+        {
+            result = 1;
+        }
+        closeSocket(&sockets[index]);
+    }
+    
+    /* Report every worker and then the merged run */
+    for (index = 0; index < (int)runs.count; index++)
+    {
+        printRun(runs.runs[index]);
+    }
+    
+    count = snprintf(config, sizeof(config), "coordinated %u workers ",
+                     runs.count);
+    describeRun(&options->data, options->threads, options->profilePath,
+                options->sourceText, config + count, sizeof(config) - count);
+    memset(&merged, 0, sizeof(runSummary));
+    merged.name = config;
+    mergeRuns(&runs, &merged);
+    printRun(&merged);
+    
+    if ((writer = malloc(sizeof(resultsWriter))) == NULL ||
+        openResults(writer, options->resultsPath) == -1 ||
+        (writeMergedRun(&runs, writer, config) == -1) |
+        (closeResults(writer, merged.endTime) == -1))
+    {
+        fprintf(stderr, "Unable to write %s\n", options->resultsPath);
+        result = 1;
+    }
+    
+    /* Reap any local workers */
+    while (wait(&count) > 0)
+    {
+    }
+    
+    freeRuns(&runs);
+    for (index = 0; index < workers; index++)
+    {
+        free(buffers[index]);
+        free(names[index]);
+    }
+    free(writer);
+    
+    return result;
+}
+
+/*
+ -- FUNCTION: spawnWorker
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int spawnWorker()
+ --
+ -- RETURNS: the loopback port the new worker is listening on
+ --
+ -- NOTES:
+ -- Forks a worker process for a single run and waits for it to report the
+ -- port it is listening on.
+ */
+static int spawnWorker()
+{
+    int port = 0;
+    int notify[2];
+    
+    if (pipe(notify) == -1)
+    {
+        systemFatal("Unable to create worker pipe");
+    }
+    
+    if (!fork())
+    {
+        close(notify[0]);
+        runWorker(0, notify[1]);
+        exit(0);
+    }
+    
+    close(notify[1]);
+    if (read(notify[0], &port, sizeof(port)) != sizeof(port))
+    {
+        systemFatal("Worker did not start");
+    }
+    close(notify[0]);
+    
+    return port;
+}
+
+/*
+ -- FUNCTION: describeArguments
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Passes on -z.
+ -- October 18, 2026 - Passes on -I.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void describeArguments(clientOptions *options,
+ --                                          char *line, size_t length)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Writes the RUN line that gives a worker the same options as this client.
+ -- A workload profile is passed by path, so it has to be at the same place on
+ -- every worker.
+ */
+static void describeArguments(clientOptions *options, char *line,
+                              size_t length)
+{
+    threadData *data = &options->data;
+    
+    snprintf(line, length, "RUN -i %s -p %s -r %d -m %llu -w %u -n %d -t %d "
+             "-k %u -R %u -s %u -z %u%s%s%s%s%s%s%s%s%s%s\n", data->ip,
+             data->port, data->request, data->maxRequests, data->pause,
+             data->clients, options->threads, data->churn, data->rate,
+             options->interval, data->fuzz,
+             options->profilePath[0] ? " -f " : "", options->profilePath,
+             options->coreText[0] ? " -a " : "", options->coreText,
+             options->tuningPath[0] ? " -T " : "", options->tuningPath,
+             options->sourceText[0] ? " -I " : "", options->sourceText,
+             options->data.path ? " -g " : "",
+             options->data.path ? options->data.path : "");
+}
+
+/*
+ -- FUNCTION: describeRun
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Added the socket tuning.
+ -- October 18, 2026 - Added the clock requests are timed with.
+ -- October 18, 2026 - Added the fuzz percentage.
+ -- October 18, 2026 - Added the source addresses.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void describeRun(threadData *data, int threads,
+ --                                    const char *profilePath,
+ --                                    const char *sourceText, char *config,
+ --                                    size_t length)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Writes the options of the run as key=value pairs for the results header,
+ -- followed by the socket tuning in use.
+ */
+static void describeRun(threadData *data, int threads, const char *profilePath,
+                        const char *sourceText, char *config, size_t length)
+{
+    int used = 0;
+    
+    used = snprintf(config, length, "ip=%s port=%s request=%d requests=%llu "
+                    "pause=%u clients=%d threads=%d churn=%u rate=%u "
+                    "fuzz=%u profile=%s clock=%s %s%s%s%s%s%s", data->ip,
+                    data->port, data->request, data->maxRequests, data->pause,
+                    data->clients, threads, data->churn, data->rate,
+                    data->fuzz, profilePath, timingSource(),
+                    data->path ? "file=" : "", data->path ? data->path : "",
+                    data->path ? " " : "", sourceText[0] ? "sources=" : "",
+                    sourceText, sourceText[0] ? " " : "");
+    if (used < (int)length)
+    {
+        describeSocketTuning(config + used, length - used);
+    }
+}
+
+/*
+ -- FUNCTION: wallClock
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static unsigned long long wallClock()
+ --
+ -- RETURNS: the current time in nanoseconds since the epoch
+ */
+static unsigned long long wallClock()
+{
+    struct timespec now;
+    
+    clock_gettime(CLOCK_REALTIME, &now);
+    
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+void stopClients()
+{
+    printf("\nShutting down client process and threads\n");
+    shared->stop = 1;
+}
+
+void stopCollecting()
+{
+    collecting = 0;
+}
+
 /*
  -- FUNCTION: systemFatal
  --
@@ -0,0 +1,521 @@
+/*
+ -- SOURCE FILE: contentCache.c
+ --
+ -- PROGRAM: Web Client Emulator
+ --
+ -- FUNCTIONS:
+ -- int contentCacheInit(cacheOpener opener, unsigned int maxEntries,
+ --                      size_t maxBytes, size_t mapLimit);
+ -- cacheEntry *contentCacheAcquire(const char *key);
+ -- void contentCacheRelease(cacheEntry *entry);
+ -- void contentCacheStatistics(contentCacheStats *stats);
+ -- static cacheEntry *loadEntry(const char *key, unsigned int hash);
+ -- static void unlinkEntry(cacheShard *shard, cacheEntry *entry);
+ -- static void makeNewest(cacheShard *shard, cacheEntry *entry);
+ -- static void dropReference(cacheEntry *entry);
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- NOTES:
+ -- A concurrent least recently used cache of open files keyed by path, used
+ -- by the file serving code. Each entry holds the open descriptor and size
+ -- of a file, and files up to the map limit are also mapped in, so a hit
+ -- costs no file system calls at all.
+ --
+ -- The cache is split into shards by a hash of the key, each with its own
+ -- lock, hash table and recency list, so threads serving different files
+ -- rarely wait on each other. The entry and byte limits are split evenly
+ -- between the shards, and a shard that goes over either one evicts from the
+ -- old end of its list. Entries are reference counted: an evicted entry is
+ -- taken out of the cache straight away but is only closed and unmapped when
+ -- the last request using it releases it.
+ --
+ -- Files are opened outside the shard lock, so a slow open does not hold up
+ -- hits on the same shard. If two threads miss on the same key at once both
+ -- open it and the second one to finish uses the first one's entry.
+ --
+ -- The cache is meant for static content. A file that changes on disk keeps
+ -- its old size until it is evicted.
+ */
+
+// Includes
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "contentCache.h"
+
+/* Buckets in the hash table of each shard */
+#define SHARD_BUCKETS 1024
+
+/* One independently locked part of the cache */
+typedef struct
+{
+    pthread_mutex_t lock;
+    cacheEntry *buckets[SHARD_BUCKETS];
+    cacheEntry *newest;
+    cacheEntry *oldest;
+    unsigned int entries;
+    size_t bytes;
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+} cacheShard;
+
+static cacheEntry *loadEntry(const char *key, unsigned int hash);
+static void unlinkEntry(cacheShard *shard, cacheEntry *entry);
+static void makeNewest(cacheShard *shard, cacheEntry *entry);
+static void dropReference(cacheEntry *entry);
+
+static cacheShard *shards = 0;
+static cacheOpener openFile = 0;
+static unsigned int shardEntries = 0;
+static size_t shardBytes = 0;
+static size_t mapSize = 0;
+
+/*
+ -- FUNCTION: contentCacheInit
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int contentCacheInit(cacheOpener opener,
+ --                                 unsigned int maxEntries, size_t maxBytes,
+ --                                 size_t mapLimit);
+ --
+ -- RETURNS: 0 on success, -1 on failure
+ --
+ -- NOTES:
+ -- Sets up the cache. The opener is called on a miss to open the file for a
+ -- key. Files no bigger than mapLimit are mapped, and only mapped bytes count
+ -- towards maxBytes.
+ */
+int contentCacheInit(cacheOpener opener, unsigned int maxEntries,
+                     size_t maxBytes, size_t mapLimit)
+{
+    unsigned int index = 0;
+    
+    if ((shards = calloc(CONTENT_CACHE_SHARDS, sizeof(cacheShard))) == NULL)
+    {
+        return -1;
+    }
+    
+    for (index = 0; index < CONTENT_CACHE_SHARDS; index++)
+    {
+        pthread_mutex_init(&shards[index].lock, NULL);
+    }
+    
+    openFile = opener;
+    shardEntries = (maxEntries + CONTENT_CACHE_SHARDS - 1) /
+                   CONTENT_CACHE_SHARDS;
+    shardBytes = maxBytes / CONTENT_CACHE_SHARDS;
+    mapSize = mapLimit;
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: contentCacheAcquire
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: cacheEntry *contentCacheAcquire(const char *key);
+ --
+ -- RETURNS: the entry with a reference for the caller, or NULL if the file
+ --          could not be opened
+ --
+ -- NOTES:
+ -- Finds the entry for the key, loading it on a miss, and marks it as the
+ -- most recently used. The caller must release it when done.
+ */
+cacheEntry *contentCacheAcquire(const char *key)
+{
+    unsigned int hash = 2166136261U;
+    const char *character = 0;
+    cacheShard *shard = 0;
+    cacheEntry *entry = 0;
+    cacheEntry *loaded = 0;
+    cacheEntry *victim = 0;
+    
+    for (character = key; *character != '\0'; character++)
+    {
+        hash = (hash ^ (unsigned char)*character) * 16777619U;
+    }
+    shard = &shards[hash % CONTENT_CACHE_SHARDS];
+    
+    pthread_mutex_lock(&shard->lock);
+    for (entry = shard->buckets[(hash >> 4) % SHARD_BUCKETS]; entry != NULL;
+         entry = entry->hashNext)
+    {
+        if (entry->hash == hash && strcmp(entry->key, key) == 0)
+        {
+            break;
+        }
+    }
+    if (entry != NULL)
+    {
+        shard->hits++;
+        entry->references++;
+        makeNewest(shard, entry);
+        pthread_mutex_unlock(&shard->lock);
+        return entry;
+    }
+    shard->misses++;
+    pthread_mutex_unlock(&shard->lock);
+    
+    /* Open and map outside the lock */
+    if ((loaded = loadEntry(key, hash)) == NULL)
+    {
+        return NULL;
+    }
+    
+    pthread_mutex_lock(&shard->lock);
+    
+    /* Someone else may have loaded it in the meantime */
+    for (entry = shard->buckets[(hash >> 4) % SHARD_BUCKETS]; entry != NULL;
+         entry = entry->hashNext)
+    {
+        if (entry->hash == hash && strcmp(entry->key, key) == 0)
+        {
+            break;
+        }
+    }
+    if (entry != NULL)
+    {
+        entry->references++;
+        makeNewest(shard, entry);
+        pthread_mutex_unlock(&shard->lock);
+        dropReference(loaded);
+        return entry;
+    }
+    
+    /* One reference for the cache and one for the caller */
+    entry = loaded;
+    entry->references = 2;
+    entry->hashNext = shard->buckets[(hash >> 4) % SHARD_BUCKETS];
+    shard->buckets[(hash >> 4) % SHARD_BUCKETS] = entry;
+    makeNewest(shard, entry);
+    shard->entries++;
+    shard->bytes += entry->map ? entry->size : 0;
+    
+    /* Evict from the old end until the shard is back within its limits, the
+     new entry is never evicted here even if it is over the limit alone */
+    while (shard->oldest != entry && (shard->entries > shardEntries ||
+                                      shard->bytes > shardBytes))
+    {
+        victim = shard->oldest;
+        unlinkEntry(shard, victim);
+        shard->evictions++;
+        if (--victim->references == 0)
+        {
+            victim->newer = loaded;
+            loaded = victim;
+        }
+    }
+    pthread_mutex_unlock(&shard->lock);
+    
+    /* Close the evicted entries nobody was using, outside the lock */
+    while (loaded != entry)
+    {
+        victim = loaded;
+        loaded = victim->newer;
+        victim->references = 1;
+        dropReference(victim);
+    }
+    
+    return entry;
+}
+
+/*
+ -- FUNCTION: contentCacheRelease
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void contentCacheRelease(cacheEntry *entry);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Gives back a reference from contentCacheAcquire. The entry is freed if it
+ -- has been evicted and this was the last user.
+ */
+void contentCacheRelease(cacheEntry *entry)
+{
+    cacheShard *shard = &shards[entry->hash % CONTENT_CACHE_SHARDS];
+    unsigned int references = 0;
+    
+    pthread_mutex_lock(&shard->lock);
+    references = --entry->references;
+    pthread_mutex_unlock(&shard->lock);
+    
+    if (references == 0)
+    {
+        entry->references = 1;
+        dropReference(entry);
+    }
+}
+
+/*
+ -- FUNCTION: contentCacheStatistics
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void contentCacheStatistics(contentCacheStats *stats);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Adds up the counters of every shard.
+ */
+void contentCacheStatistics(contentCacheStats *stats)
+{
+    unsigned int index = 0;
+    
+    memset(stats, 0, sizeof(contentCacheStats));
+    if (shards == NULL)
+    {
+        return;
+    }
+    
+    for (index = 0; index < CONTENT_CACHE_SHARDS; index++)
+    {
+        pthread_mutex_lock(&shards[index].lock);
+        stats->hits += shards[index].hits;
+        stats->misses += shards[index].misses;
+        stats->evictions += shards[index].evictions;
+        stats->entries += shards[index].entries;
+        stats->bytes += shards[index].bytes;
+        pthread_mutex_unlock(&shards[index].lock);
+    }
+}
+
+/*
+ -- FUNCTION: loadEntry
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static cacheEntry *loadEntry(const char *key,
+ --                                         unsigned int hash);
+ --
+ -- RETURNS: a new entry, or NULL if the key is not a regular file
+ --
+ -- NOTES:
+ -- Opens the file for the key and maps it in if it is small enough.
+ */
+static cacheEntry *loadEntry(const char *key, unsigned int hash)
+{
+    int fd = 0;
+    struct stat status;
+    cacheEntry *entry = 0;
+    
+    if ((fd = openFile(key)) == -1)
+    {
+        return NULL;
+    }
+    
+    if (fstat(fd, &status) == -1 || !S_ISREG(status.st_mode) ||
+        (entry = calloc(1, sizeof(cacheEntry))) == NULL ||
+        (entry->key = strdup(key)) == NULL)
+    {
+        free(entry);
+        close(fd);
+        return NULL;
+    }
+    
+    entry->hash = hash;
+    entry->fd = fd;
+    entry->size = status.st_size;
+    entry->references = 1;
+    
+    if (status.st_size > 0 && (size_t)status.st_size <= mapSize)
+    {
+        entry->map = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED |
+                          MAP_POPULATE, fd, 0);
+        if (entry->map == MAP_FAILED)
+        {
+            entry->map = NULL;
+        }
+    }
+    else
+    {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    
+    return entry;
+}
+
+/*
+ -- FUNCTION: unlinkEntry
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void unlinkEntry(cacheShard *shard, cacheEntry *entry);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Takes the entry out of the shard's hash table and recency list. The shard
+ -- lock must be held.
+ */
+static void unlinkEntry(cacheShard *shard, cacheEntry *entry)
+{
+    cacheEntry **link = &shard->buckets[(entry->hash >> 4) % SHARD_BUCKETS];
+    
+    while (*link != entry)
+    {
+        link = &(*link)->hashNext;
+    }
+    *link = entry->hashNext;
+    
+    if (entry->older != NULL)
+    {
+        entry->older->newer = entry->newer;
+    }
+    else
+    {
+        shard->oldest = entry->newer;
+    }
+    if (entry->newer != NULL)
+    {
+        entry->newer->older = entry->older;
+    }
+    else
+    {
+        shard->newest = entry->older;
+    }
+    
+    shard->entries--;
+    shard->bytes -= entry->map ? entry->size : 0;
+}
+
+/*
+ -- FUNCTION: makeNewest
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void makeNewest(cacheShard *shard, cacheEntry *entry);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Moves the entry to the new end of the recency list, or puts it there if it
+ -- is not on the list yet. The shard lock must be held.
+ */
+static void makeNewest(cacheShard *shard, cacheEntry *entry)
+{
+    if (shard->newest == entry)
+    {
+        return;
+    }
+    
+    /* Take it out of its current place */
+    if (entry->older != NULL)
+    {
+        entry->older->newer = entry->newer;
+    }
+    else if (shard->oldest == entry)
+    {
+        shard->oldest = entry->newer;
+    }
+    if (entry->newer != NULL)
+    {
+        entry->newer->older = entry->older;
+    }
+    
+    entry->older = shard->newest;
+    entry->newer = NULL;
+    if (shard->newest != NULL)
+    {
+        shard->newest->newer = entry;
+    }
+    shard->newest = entry;
+    if (shard->oldest == NULL)
+    {
+        shard->oldest = entry;
+    }
+}
+
+/*
+ -- FUNCTION: dropReference
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void dropReference(cacheEntry *entry);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Drops a reference to an entry that is not in the cache, so no lock is
+ -- needed, and frees the entry when it was the last one.
+ */
+static void dropReference(cacheEntry *entry)
+{
+    if (--entry->references != 0)
+    {
+        return;
+    }
+    
+    if (entry->map != NULL)
+    {
+        munmap(entry->map, entry->size);
+    }
+    close(entry->fd);
+    free(entry->key);
+    free(entry);
+}
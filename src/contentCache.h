@@ -0,0 +1,50 @@
+#ifndef CONTENT_CACHE_H
+#define CONTENT_CACHE_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Defines */
+#define CONTENT_CACHE_SHARDS 16
+
+/* An open file, and its contents if they are small enough to map */
+typedef struct cacheEntry
+{
+    char *key;
+    unsigned int hash;
+    int fd;
+    off_t size;
+    void *map;
+    unsigned int references;
+    struct cacheEntry *hashNext;
+    struct cacheEntry *older;
+    struct cacheEntry *newer;
+} cacheEntry;
+
+/* Opens the file for a key, returning a descriptor or -1 */
+typedef int (*cacheOpener)(const char *key);
+
+/* Counters summed over every shard */
+typedef struct
+{
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+    unsigned long long entries;
+    unsigned long long bytes;
+} contentCacheStats;
+
+/* Function Prototypes */
+#ifdef __cplusplus
+extern "C" {
+#endif
+    int contentCacheInit(cacheOpener opener, unsigned int maxEntries,
+                         size_t maxBytes, size_t mapLimit);
+    cacheEntry *contentCacheAcquire(const char *key);
+    void contentCacheRelease(cacheEntry *entry);
+    void contentCacheStatistics(contentCacheStats *stats);
+#ifdef __cplusplus
+}
+#endif
+#endif
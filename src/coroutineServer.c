@@ -0,0 +1,1210 @@
+/*-----------------------------------------------------------------------------
+ --	SOURCE FILE:    coroutineServer.c - A server of coroutines on epoll
+ --
+ --	PROGRAM:		Web Client Emulator
+ --
+ --	FUNCTIONS:
+ --                 int main(int argc, char **argv);
+ --                 void server(int port, int schedulers,
+ --                             const coreList *cores,
+ --                             const networkAddress *addresses,
+ --                             const int *counts, int groups);
+ --                 void *runScheduler(void *data);
+ --                 static void acceptConnections(scheduler *self);
+ --                 static void resume(scheduler *self, coroutine *task);
+ --                 static void yield(coroutine *task);
+ --                 static void coroutineMain();
+ --                 static void processConnection(coroutine *task);
+ --                 static int yieldingReadLine(coroutine *task, char *buffer,
+ --                                             int maxBytesToRead);
+ --                 static int yieldingSendData(coroutine *task,
+ --                                             const char *buffer,
+ --                                             int bytesToSend);
+ --                 static int yieldingServeFile(coroutine *task,
+ --                                              const char *request);
+ --                 static coroutine *newCoroutine(scheduler *self, int socket);
+ --                 static void freeCoroutine(coroutine *task);
+ --                 void initializeServer(int *listenSocket, int *port,
+ --                                       int reusePort,
+ --                                       const networkAddress *address);
+ --                 void displayClientData(unsigned long long clients);
+ --                 static void systemFatal(const char *message);
+ --
+ --	DATE:			October 18, 2026
+ --
+ --	REVISIONS:		October 18, 2026 - Request sizes are checked by
+ --                  requestParser.c, and a malformed one only closes its
+ --                  connection.
+ --                  October 18, 2026 - A failure setting up a connection
+ --                  closes only that connection, errors are counted by type
+ --                  and SIGPIPE is ignored.
+ --                  October 18, 2026 - Added -u to serve a UNIX domain
+ --                  socket at a path instead of a TCP port. Every scheduler
+ --                  shares the one socket.
+ --                  October 18, 2026 - Added -l to listen on a list of IPv4
+ --                  and IPv6 addresses, each with its own schedulers.
+ --
+ --	DESIGNERS:      Luke Queenan
+ --
+ --	PROGRAMMERS:	Luke Queenan
+ --
+ --	NOTES:
+ -- The thread server's connection handler, run as coroutines on a few epoll
+ -- schedulers instead of a thread per connection.
+ --
+ -- Every connection gets a coroutine with its own small stack, and the
+ -- handler is written as straight line code the way the thread server's is:
+ -- read a line, answer it, repeat. Its reads and sends are made on a non
+ -- blocking socket, and where the thread server would block they swap back
+ -- to the scheduler instead. The scheduler is an epoll loop that resumes a
+ -- coroutine when its socket becomes readable or writable. A connection
+ -- then costs its stack and its buffer rather than a thread, and the
+ -- schedulers wake like the epoll server's reactors do.
+ --
+ -- With -r N there are N schedulers, each a thread with its own epoll object
+ -- and its own SO_REUSEPORT listening socket, and a coroutine stays on the
+ -- scheduler that accepted it. The schedulers are placed on the cores of the
+ -- core list like the epoll reactors. With -l ADDRESS[@SCHEDULERS],... each
+ -- address gets a group of its own schedulers, -r of them unless it says
+ -- otherwise, as the epoll server's addresses get reactors.
+ --
+ -- Coroutines switch with swapcontext, which saves and restores the signal
+ -- mask with a system call each way. The switches are counted with the
+ -- system calls, so the engine statistics show what the model costs.
+ -- Stacks are mapped with a guard page below them, so a handler that
+ -- overflows its stack faults instead of writing over the next one.
+ ----------------------------------------------------------------------------*/
+
+/* System includes */
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+/* User includes */
+#include "admin.h"
+#include "admission.h"
+#include "affinity.h"
+#include "engineStats.h"
+#include "fileServe.h"
+#include "network.h"
+#include "requestParser.h"
+#include "timing.h"
+#include "trace.h"
+
+#define MAX_EVENTS 10000
+#define MAX_SCHEDULERS 256
+
+/* Bytes of stack given to each coroutine, not counting the guard page */
+#define COROUTINE_STACK_SIZE 65536
+
+struct scheduler;
+
+/* A connection and the handler running for it */
+typedef struct coroutine
+{
+    ucontext_t context;
+    struct scheduler *owner;
+    char *stack;
+    int socket;
+    int finished;
+    int start;
+    int length;
+    unsigned int trace;
+    char input[NETWORK_BUFFER_SIZE];
+} coroutine;
+
+/* One epoll loop, the socket it accepts on and the coroutine it is running */
+typedef struct scheduler
+{
+    ucontext_t context;
+    int listenSocket;
+    int epoll;
+    int core;
+    int index;
+    int listening;
+    coroutine *current;
+    engineCounters *engine;
+} scheduler;
+
+int main(int argc, char **argv);
+void server(int port, int schedulers, const coreList *cores,
+            const networkAddress *addresses, const int *counts, int groups);
+void *runScheduler(void *data);
+static void acceptConnections(scheduler *self);
+static void resume(scheduler *self, coroutine *task);
+static void yield(coroutine *task);
+static void coroutineMain();
+static void processConnection(coroutine *task);
+static int yieldingReadLine(coroutine *task, char *buffer, int maxBytesToRead);
+static int yieldingSendData(coroutine *task, const char *buffer,
+                            int bytesToSend);
+static int yieldingServeFile(coroutine *task, const char *request);
+static coroutine *newCoroutine(scheduler *self, int socket);
+static void freeCoroutine(coroutine *task);
+void initializeServer(int *listenSocket, int *port, int reusePort,
+                      const networkAddress *address);
+void displayClientData(unsigned long long clients);
+static void systemFatal(const char *message);
+
+/* The scheduler running on this thread, for coroutineMain */
+static __thread scheduler *running = 0;
+
+/* Connections over all of the schedulers */
+static unsigned long long connections = 0;
+
+/* Every reply is made of these bytes */
+static char replyData[NETWORK_BUFFER_SIZE];
+
+/*
+ -- FUNCTION: main
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Ignores SIGPIPE, so a client that goes
+ -- away during a send only fails that send.
+ -- October 18, 2026 - Added the -u option to serve a UNIX domain socket path.
+ -- October 18, 2026 - Added the -l option for a list of listen addresses.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int main(argc, char **argv)
+ --
+ -- RETURNS: 0 on success
+ --
+ -- NOTES:
+ -- This is the main entry point for the coroutine server. It takes the same
+ -- options as the epoll server, with -r for the number of schedulers.
+ */
+int main(int argc, char **argv)
+{
+    /* Initialize port and give default option in case of no user input */
+    int port = DEFAULT_PORT;
+    int option = 0;
+    int schedulers = 1;
+    int adminPort = 0;
+    int groups = 0;
+    int group = 0;
+    int total = 0;
+    int counts[NETWORK_MAX_ADDRESSES];
+    unsigned int cacheEntries = FILE_CACHE_ENTRIES;
+    unsigned long cacheMegabytes = FILE_CACHE_MEGABYTES;
+    unsigned int traceEvery = 1;
+    char *root = 0;
+    char *tracePath = 0;
+    char *limits = 0;
+    char *listenList = 0;
+    char *end = 0;
+    char message[NETWORK_BUFFER_SIZE];
+    networkAddress addresses[NETWORK_MAX_ADDRESSES];
+    coreList cores;
+    
+    cores.count = 0;
+    
+    /* Parse command line parameters using getopt */
+    while ((option = getopt(argc, argv, "p:a:r:T:d:c:t:A:L:u:l:")) != -1)
+    {
+        switch (option)
+        {
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'a':
+                if (parseCoreList(optarg, &cores) == -1)
+                {
+                    fprintf(stderr, "No usable cores in %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'r':
+                schedulers = atoi(optarg);
+                break;
+            case 'd':
+                root = optarg;
+                break;
+            case 'c':
+                cacheEntries = strtoul(optarg, &end, 10);
+                if (*end == ',')
+                {
+                    cacheMegabytes = strtoul(end + 1, NULL, 10);
+                }
+                break;
+            case 't':
+                tracePath = optarg;
+                if ((end = strchr(optarg, ',')) != NULL)
+                {
+                    *end = '\0';
+                    traceEvery = strtoul(end + 1, NULL, 10);
+                }
+                break;
+            case 'A':
+                adminPort = atoi(optarg);
+                break;
+            case 'L':
+                limits = optarg;
+                break;
+            case 'l':
+                listenList = optarg;
+                break;
+            case 'u':
+                if (setUnixPath(optarg) == -1)
+                {
+                    fprintf(stderr, "Socket path too long: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'T':
+                if (loadSocketTuning(optarg, message, sizeof(message)) == -1)
+                {
+                    fprintf(stderr, "Socket tuning: %s\n", message);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr, "Usage: %s -p [port] -u [path] "
+                        "-l [address[@schedulers],...] -a [cores] -r [schedulers] "
+                        "-T [tuning] -d [root] -c [entries,megabytes] -t [trace,every] -A [admin port] "
+                        "-L [connections,inflight[,target us,interval ms]]\n", argv[0]);
+                return 0;
+        }
+    }
+    
+    /* A client gone mid send is an error on its connection, not a signal */
+    signal(SIGPIPE, SIG_IGN);
+    
+    /* Calibrate the clock requests are timed with before any threads start */
+    timingInit();
+    
+    if (limits != NULL)
+    {
+        if (admissionConfigure(limits) == -1)
+        {
+            fprintf(stderr, "Admission control: %s is not valid\n", limits);
+            return 1;
+        }
+        admissionDescribe(message, sizeof(message));
+        printf("Admission control: %s\n", message);
+    }
+    
+    if (schedulers < 1 || schedulers > MAX_SCHEDULERS)
+    {
+        fprintf(stderr, "Schedulers must be between 1 and %d\n",
+                MAX_SCHEDULERS);
+        return 1;
+    }
+    
+    if (listenList != NULL)
+    {
+        if (getUnixPath() != NULL)
+        {
+            fprintf(stderr, "Listen addresses cannot be used with a path\n");
+            return 1;
+        }
+        if ((groups = parseAddressList(listenList, addresses, counts,
+                                       NETWORK_MAX_ADDRESSES)) == -1)
+        {
+            fprintf(stderr, "Listen addresses: %s is not valid\n",
+                    listenList);
+            return 1;
+        }
+        
+        /* An address without a count gets the -r schedulers */
+        for (group = 0; group < groups; group++)
+        {
+            if (counts[group] == 0)
+            {
+                counts[group] = schedulers;
+            }
+            total += counts[group];
+        }
+        if (total > MAX_SCHEDULERS)
+        {
+            fprintf(stderr, "Schedulers must be between 1 and %d\n",
+                    MAX_SCHEDULERS);
+            return 1;
+        }
+        schedulers = total;
+    }
+    
+    describeSocketTuning(message, sizeof(message));
+    printf("Socket tuning: %s\n", message);
+    if (getUnixPath() != NULL)
+    {
+        printf("Listening on %s instead of a port\n", getUnixPath());
+    }
+    for (group = 0; group < groups; group++)
+    {
+        describeAddress(&addresses[group], message, sizeof(message));
+        printf("Listening on %s with %d schedulers\n", message,
+               counts[group]);
+    }
+    
+    if (root != NULL)
+    {
+        if (openDocumentRoot(root, cacheEntries,
+                             cacheMegabytes * 1024 * 1024) == -1)
+        {
+            perror(root);
+            return 1;
+        }
+        printf("Serving files from %s, caching up to %u files and %lu MB\n",
+               root, cacheEntries, cacheMegabytes);
+    }
+    
+    if (tracePath != NULL)
+    {
+        if (traceStart(tracePath, traceEvery) == -1)
+        {
+            perror(tracePath);
+            return 1;
+        }
+        printf("Tracing one connection in %u to %s\n",
+               traceEvery ? traceEvery : 1, tracePath);
+    }
+    
+    if (adminPort != 0)
+    {
+        if (adminStart(adminPort, "coroutine") == -1)
+        {
+            perror("Unable to open the admin port");
+            return 1;
+        }
+        printf("Serving metrics on port %d\n", adminPort);
+    }
+    
+    /* Several schedulers are spread over every core unless told otherwise */
+    if (schedulers > 1 && cores.count == 0 &&
+        parseCoreList("all", &cores) == -1)
+    {
+        systemFatal("Unable to get the usable cores");
+    }
+    
+    /* Start server */
+    server(port, schedulers, &cores, addresses, counts, groups);
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: server
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - The schedulers share one socket when serving a
+ -- path.
+ -- October 18, 2026 - Takes groups of schedulers, each listening on its own
+ -- address.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void server(int, int, const coreList *,
+ --                        const networkAddress *, const int *, int)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Sets up the schedulers and runs the first one itself. Every scheduler
+ -- binds its own socket to the port, sharing it with SO_REUSEPORT when there
+ -- is more than one, and scheduler N runs on the Nth core of the core list.
+ -- A UNIX domain path can only be bound once, so the schedulers then share
+ -- one socket and whichever is woken first accepts.
+ --
+ -- With groups of addresses, the first counts[0] schedulers listen on the
+ -- first address, the next counts[1] on the second and so on. Without, there
+ -- is one group of every scheduler on every IPv4 address, or on the path.
+ */
+void server(int port, int schedulers, const coreList *cores,
+            const networkAddress *addresses, const int *counts, int groups)
+{
+    int index = 0;
+    int group = 0;
+    int first = 0;
+    const networkAddress *address = 0;
+    scheduler *schedulerList = 0;
+    pthread_t thread = 0;
+    pthread_attr_t attr;
+    
+    if ((schedulerList = calloc(schedulers, sizeof(scheduler))) == NULL)
+    {
+        systemFatal("Unable to allocate schedulers");
+    }
+    
+    /* Ready the memory for sending to the clients */
+    memset(replyData, 'L', NETWORK_BUFFER_SIZE);
+    
+    /* One group of every scheduler when not given addresses */
+    if (groups == 0)
+    {
+        addresses = NULL;
+        counts = &schedulers;
+        groups = 1;
+    }
+    
+    for (group = 0; group < groups; first += counts[group++])
+    {
+        address = (addresses != NULL) ? &addresses[group] : NULL;
+        for (index = first; index < first + counts[group]; index++)
+        {
+            schedulerList[index].core = affinityCore(cores, index);
+            schedulerList[index].index = index;
+            if (index > first && getUnixPath() != NULL)
+            {
+                /* A path is bound once, the schedulers share the one socket */
+                if ((schedulerList[index].listenSocket =
+                     dup(schedulerList[first].listenSocket)) == -1)
+                {
+                    systemFatal("Cannot share the listen socket");
+                }
+                continue;
+            }
+            initializeServer(&schedulerList[index].listenSocket, &port,
+                             counts[group] > 1 && getUnixPath() == NULL,
+                             address);
+        }
+    }
+    
+    displayClientData(0);
+    
+    if (engineStartReporter("Coroutine server") == -1)
+    {
+        systemFatal("Unable to start the engine statistics reporter");
+    }
+    
+    /* Start the other schedulers on their cores */
+    pthread_attr_init(&attr);
+    if (pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) != 0)
+    {
+        systemFatal("Unable to set thread attributes to detached");
+    }
+    for (index = 1; index < schedulers; index++)
+    {
+        if (setAttrAffinity(&attr, schedulerList[index].core) != 0 ||
+            pthread_create(&thread, &attr, runScheduler,
+                           &schedulerList[index]) != 0)
+        {
+            systemFatal("Unable to start scheduler");
+        }
+    }
+    pthread_attr_destroy(&attr);
+    
+    /* This thread is the first scheduler */
+    if (schedulerList[0].core >= 0)
+    {
+        if (pinThread(schedulerList[0].core) != 0)
+        {
+            systemFatal("Unable to pin scheduler");
+        }
+        printf("Running %d schedulers from core %d\n", schedulers,
+               schedulerList[0].core);
+    }
+    runScheduler(&schedulerList[0]);
+}
+
+/*
+ -- FUNCTION: runScheduler
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void *runScheduler(void *data)
+ --
+ -- RETURNS: NULL
+ --
+ -- NOTES:
+ -- The epoll loop of one scheduler. Client sockets are registered edge
+ -- triggered for both reading and writing, with their coroutine in the epoll
+ -- data, and any event on one resumes its coroutine. A coroutine only waits
+ -- after a read or send would have blocked, so the next edge is always the
+ -- one it is waiting for. The listening socket carries NULL.
+ --
+ -- While admission control has paused accepting, the listening socket is
+ -- taken out of epoll and the wait is cut to ADMISSION_RECHECK milliseconds,
+ -- as in the epoll server.
+ */
+void *runScheduler(void *data)
+{
+    scheduler *self = (scheduler *)data;
+    register int ready = 0;
+    register int index = 0;
+    coroutine *task = 0;
+    
+    struct epoll_event event;
+    struct epoll_event *events = 0;
+    
+    if ((events = malloc(sizeof(struct epoll_event) * MAX_EVENTS)) == NULL)
+    {
+        systemFatal("Unable to allocate epoll events");
+    }
+    
+    if ((self->engine = engineJoin()) == NULL)
+    {
+        systemFatal("Unable to allocate engine statistics");
+    }
+    running = self;
+    
+    if ((self->epoll = epoll_create1(0)) == -1)
+    {
+        systemFatal("Unable to create epoll object");
+    }
+    
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    if (epoll_ctl(self->epoll, EPOLL_CTL_ADD, self->listenSocket,
+                  &event) == -1)
+    {
+        systemFatal("Unable to add listen socket to epoll");
+    }
+    self->listening = 1;
+    
+    while (1)
+    {
+        /* Stop or start accepting as the requests in flight cross the limit */
+        if (self->listening == admissionPaused())
+        {
+            self->listening = !self->listening;
+            event.events = EPOLLIN;
+            event.data.ptr = NULL;
+            countSyscall(0);
+            if (epoll_ctl(self->epoll,
+                          self->listening ? EPOLL_CTL_ADD : EPOLL_CTL_DEL,
+                          self->listenSocket, &event) == -1)
+            {
+                systemFatal("Cannot change the listen socket in epoll");
+            }
+        }
+        
+        engineWaiting(self->engine);
+        ready = epoll_wait(self->epoll, events, MAX_EVENTS,
+                           self->listening ? -1 : ADMISSION_RECHECK);
+        if (ready == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            systemFatal("Epoll wait error");
+        }
+        engineWakeup(self->engine, ready > 0);
+        
+        for (index = 0; index < ready; index++)
+        {
+            if (events[index].data.ptr == NULL)
+            {
+                acceptConnections(self);
+                continue;
+            }
+            
+            task = events[index].data.ptr;
+            TRACE(task->trace, TRACE_READABLE);
+            resume(self, task);
+        }
+    }
+    
+    engineLeave(self->engine);
+    close(self->listenSocket);
+    close(self->epoll);
+    free(events);
+    
+    return NULL;
+}
+
+/*
+ -- FUNCTION: acceptConnections
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - A socket that cannot be set up closes only
+ -- its connection.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void acceptConnections(scheduler *self)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Accepts every connection waiting on the scheduler's socket, and starts a
+ -- coroutine for each. The coroutine runs straight away, since the request
+ -- is often in with the connection. A socket that cannot be set up is
+ -- counted as an error and closed.
+ */
+static void acceptConnections(scheduler *self)
+{
+    int client = 0;
+    coroutine *task = 0;
+    struct epoll_event event;
+    
+    while ((client = acceptConnection(&self->listenSocket)) != -1)
+    {
+        if (!admitConnection())
+        {
+            self->engine->rejected++;
+            rejectConnection(client);
+            continue;
+        }
+        self->engine->accepts++;
+        displayClientData(__sync_add_and_fetch(&connections, 1));
+        
+        task = newCoroutine(self, client);
+        TRACE(task->trace, TRACE_ACCEPTED);
+        
+        event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        event.data.ptr = task;
+        if (makeSocketNonBlocking(&client) == -1 ||
+            epoll_ctl(self->epoll, EPOLL_CTL_ADD, client, &event) == -1)
+        {
+            /* Only this connection is lost */
+            engineError(self->engine, engineErrorType(errno));
+            freeCoroutine(task);
+            continue;
+        }
+        
+        resume(self, task);
+    }
+}
+
+/*
+ -- FUNCTION: resume
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void resume(scheduler *self, coroutine *task)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Runs a coroutine until it waits or finishes. A finished coroutine is
+ -- freed here, on the scheduler's stack rather than its own.
+ */
+static void resume(scheduler *self, coroutine *task)
+{
+    self->current = task;
+    countSyscall(0);
+    if (swapcontext(&self->context, &task->context) == -1)
+    {
+        systemFatal("Unable to resume coroutine");
+    }
+    self->current = NULL;
+    
+    if (task->finished)
+    {
+        freeCoroutine(task);
+    }
+}
+
+/*
+ -- FUNCTION: yield
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void yield(coroutine *task)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Swaps back to the scheduler until the coroutine's socket has an event.
+ */
+static void yield(coroutine *task)
+{
+    countSyscall(0);
+    if (swapcontext(&task->context, &task->owner->context) == -1)
+    {
+        systemFatal("Unable to yield coroutine");
+    }
+}
+
+/*
+ -- FUNCTION: coroutineMain
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void coroutineMain()
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Where every coroutine starts. It finds its connection through the
+ -- scheduler that resumed it, since makecontext only passes ints. Returning
+ -- goes back to the scheduler through the context's link.
+ */
+static void coroutineMain()
+{
+    coroutine *task = running->current;
+    
+    processConnection(task);
+    task->finished = 1;
+}
+
+/*
+ -- FUNCTION: processConnection
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - A malformed request closes the connection
+ -- instead of exiting.
+ -- October 18, 2026 - Counts the errors it closes the connection on.
+ -- October 18, 2026 - Files are sent with yieldingServeFile.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void processConnection(coroutine *task)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Service a client socket by reading a request and sending the data to the
+ -- client in a loop until the client closes the connection. This is the
+ -- thread server's handler, with the reads and sends that would block
+ -- yielding to the scheduler instead.
+ */
+static void processConnection(coroutine *task)
+{
+    int bytesToWrite = 0;
+    unsigned long long started = 0;
+    unsigned long long elapsed = 0;
+    char line[NETWORK_BUFFER_SIZE];
+    engineCounters *engine = task->owner->engine;
+    
+    /* Service the client while it is connected */
+    while (1)
+    {
+        /* Read the request from the client */
+        if ((bytesToWrite = yieldingReadLine(task, line,
+                                             NETWORK_BUFFER_SIZE - 1)) <= 0)
+        {
+            if (bytesToWrite == -1)
+            {
+                engineError(engine, engineErrorType(errno));
+            }
+            return;
+        }
+        line[bytesToWrite] = '\0';
+        TRACE(task->trace, TRACE_PARSED);
+        started = timingNow();
+        admissionBegin(1);
+        
+        if (++engine->requests % ENGINE_SAMPLE_EVERY == 0)
+        {
+            engineSample(engine);
+        }
+        
+        /* Stream a file if one was asked for */
+        if (isFileRequest(line))
+        {
+            if (yieldingServeFile(task, line) == -1)
+            {
+                engineError(engine, engineErrorType(errno));
+                admissionDone(1, timingNow() - started);
+                return;
+            }
+        }
+        else
+        {
+            /* Get the number of bytes to reply with, within our buffers */
+            if ((bytesToWrite = requestSize(line, NETWORK_BUFFER_SIZE)) == -1)
+            {
+                engineError(engine, ENGINE_ERROR_MALFORMED);
+                admissionDone(1, timingNow() - started);
+                return;
+            }
+            
+            /* Send the data back to the client */
+            TRACE(task->trace, TRACE_QUEUED);
+            if (yieldingSendData(task, replyData, bytesToWrite) == -1)
+            {
+                engineError(engine, engineErrorType(errno));
+                admissionDone(1, timingNow() - started);
+                return;
+            }
+        }
+        TRACE(task->trace, TRACE_SENT);
+        elapsed = timingNow() - started;
+        admissionDone(1, elapsed);
+        engineLatency(engine, elapsed, 1);
+    }
+}
+
+/*
+ -- FUNCTION: yieldingReadLine
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int yieldingReadLine(coroutine *task, char *buffer,
+ --                                        int maxBytesToRead)
+ --
+ -- RETURNS: the number of bytes in the line, 0 on EOF, -1 on failure
+ --
+ -- NOTES:
+ -- Reads a line the way readLine does, leaving the new line out of the
+ -- count, but without blocking. Whatever the socket has waiting is read into
+ -- the connection's buffer at once and lines are taken from there, so a
+ -- pipelined request costs no read of its own. When the buffer holds no
+ -- complete line and the socket has nothing, the coroutine yields until it
+ -- does. A full buffer counts as a line.
+ */
+static int yieldingReadLine(coroutine *task, char *buffer, int maxBytesToRead)
+{
+    int bytesRead = 0;
+    int count = 0;
+    char *newline = 0;
+    
+    while (1)
+    {
+        /* Take a line from the buffer if there is one */
+        newline = memchr(task->input + task->start, '\n',
+                         task->length - task->start);
+        count = newline ? newline - (task->input + task->start) :
+                task->length - task->start;
+        if (newline != NULL || count >= maxBytesToRead)
+        {
+            if (count > maxBytesToRead)
+            {
+                count = maxBytesToRead;
+            }
+            memcpy(buffer, task->input + task->start, count);
+            task->start += count + (newline != NULL &&
+                                    count < maxBytesToRead);
+            return count;
+        }
+        
+        /* Keep the partial line and read more after it */
+        memmove(task->input, task->input + task->start, count);
+        task->start = 0;
+        task->length = count;
+        
+        bytesRead = readAvailable(&task->socket, task->input + task->length,
+                                  NETWORK_BUFFER_SIZE - task->length);
+        if (bytesRead > 0)
+        {
+            task->length += bytesRead;
+        }
+        else if (bytesRead == 0)
+        {
+            /* EOF, the partial line is returned like readLine does */
+            memcpy(buffer, task->input, task->length);
+            count = task->length;
+            task->length = 0;
+            return count;
+        }
+        else if (errno == EAGAIN)
+        {
+            yield(task);
+        }
+        else if (errno != EINTR)
+        {
+            return -1;
+        }
+    }
+}
+
+/*
+ -- FUNCTION: yieldingSendData
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int yieldingSendData(coroutine *task,
+ --                                        const char *buffer,
+ --                                        int bytesToSend)
+ --
+ -- RETURNS: the number of bytes sent, -1 on failure
+ --
+ -- NOTES:
+ -- Sends all of the buffer the way sendData does, yielding whenever the
+ -- socket's send buffer is full.
+ */
+static int yieldingSendData(coroutine *task, const char *buffer,
+                            int bytesToSend)
+{
+    int sent = 0;
+    int sentTotal = 0;
+    
+    while (sentTotal < bytesToSend)
+    {
+        sent = send(task->socket, buffer + sentTotal, bytesToSend - sentTotal,
+                    MSG_NOSIGNAL);
+        countSent(sent);
+        if (sent > 0)
+        {
+            sentTotal += sent;
+        }
+        else if (sent == -1 && errno == EAGAIN)
+        {
+            yield(task);
+        }
+        else if (sent == 0 || errno != EINTR)
+        {
+            return -1;
+        }
+    }
+    
+    return sentTotal;
+}
+
+/*
+ -- FUNCTION: yieldingServeFile
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int yieldingServeFile(coroutine *task,
+ --                                         const char *request)
+ --
+ -- RETURNS: 0 if a reply was sent, -1 if the socket failed
+ --
+ -- NOTES:
+ -- Sends the file named by the request the way serveFile does, yielding
+ -- whenever the socket's send buffer is full.
+ */
+static int yieldingServeFile(coroutine *task, const char *request)
+{
+    int result = 0;
+    fileReply reply;
+    
+    startFile(&reply, request);
+    while ((result = sendFile(&task->socket, &reply)) == 1)
+    {
+        yield(task);
+    }
+    
+    return result;
+}
+
+/*
+ -- FUNCTION: newCoroutine
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static coroutine *newCoroutine(scheduler *self, int socket)
+ --
+ -- RETURNS: the coroutine, ready to be resumed
+ --
+ -- NOTES:
+ -- Makes the coroutine for a connection. The stack is mapped with a page
+ -- below it left inaccessible, and only the pages the handler touches are
+ -- ever given memory.
+ */
+static coroutine *newCoroutine(scheduler *self, int socket)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    coroutine *task = 0;
+    
+    if ((task = calloc(1, sizeof(coroutine))) == NULL)
+    {
+        systemFatal("Unable to allocate coroutine");
+    }
+    task->owner = self;
+    task->socket = socket;
+    task->trace = traceConnection();
+    
+    task->stack = mmap(NULL, COROUTINE_STACK_SIZE + page,
+                       PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (task->stack == MAP_FAILED ||
+        mprotect(task->stack, page, PROT_NONE) == -1)
+    {
+        systemFatal("Unable to map coroutine stack");
+    }
+    
+    if (getcontext(&task->context) == -1)
+    {
+        systemFatal("Unable to get coroutine context");
+    }
+    task->context.uc_stack.ss_sp = task->stack + page;
+    task->context.uc_stack.ss_size = COROUTINE_STACK_SIZE;
+    task->context.uc_link = &self->context;
+    makecontext(&task->context, coroutineMain, 0);
+    
+    return task;
+}
+
+/*
+ -- FUNCTION: freeCoroutine
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void freeCoroutine(coroutine *task)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Closes the connection of a finished coroutine, which also takes it out
+ -- of epoll, and frees the coroutine and its stack.
+ */
+static void freeCoroutine(coroutine *task)
+{
+    task->owner->engine->closes++;
+    admissionClosed();
+    close(task->socket);
+    munmap(task->stack, COROUTINE_STACK_SIZE + sysconf(_SC_PAGESIZE));
+    free(task);
+    displayClientData(__sync_sub_and_fetch(&connections, 1));
+}
+
+/*
+ -- FUNCTION: initializeServer
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Makes a UNIX domain socket when serving a
+ -- path.
+ -- October 18, 2026 - Binds to the given address, if there is one.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void initializeServer(int *listenSocket, int *port,
+ --                                  int reusePort,
+ --                                  const networkAddress *address);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- This function sets up the required server connections, such as creating a
+ -- socket, setting the socket to reuse mode, binding it to an address, and
+ -- setting it to listen. If an error occurs, the function calls "systemFatal"
+ -- with an error message.
+ */
+void initializeServer(int *listenSocket, int *port, int reusePort,
+                      const networkAddress *address)
+{
+    // Create a TCP socket for the address, or a UNIX domain one when serving
+    // a path
+    *listenSocket = (address != NULL) ? addressSocket(address) : streamSocket();
+    if (*listenSocket == -1)
+    {
+        systemFatal("Cannot Create Socket!");
+    }
+    
+    // Allow the socket to be reused immediately after exit
+    if (setReuse(listenSocket) == -1)
+    {
+        systemFatal("Cannot Set Socket To Reuse");
+    }
+    
+    // Share the port with the other schedulers
+    if (reusePort && setReusePort(listenSocket) == -1)
+    {
+        systemFatal("Cannot Set Socket To Reuse Port");
+    }
+    
+    // Bind an address to the socket
+    if ((address != NULL ? bindAddressTo(address, port, listenSocket) :
+         bindAddress(port, listenSocket)) == -1)
+    {
+        systemFatal("Cannot Bind Address To Socket");
+    }
+    
+    if (makeSocketNonBlocking(listenSocket) == -1)
+    {
+        systemFatal("Cannot Make Socket Non-Blocking");
+    }
+    
+    // Set the socket to listen for connections
+    if (setListen(listenSocket) == -1)
+    {
+        systemFatal("Cannot Listen On Socket");
+    }
+}
+
+void displayClientData(unsigned long long clients)
+{
+    char cache[NETWORK_BUFFER_SIZE];
+    
+    printf("Connected clients: %llu\n", clients);
+    if (describeFileCache(cache, sizeof(cache)) > 0)
+    {
+        printf("File cache: %s\n", cache);
+    }
+}
+
+/*
+ -- FUNCTION: systemFatal
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void systemFatal(const char* message);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- This function displays an error message and shuts down the program.
+ */
+static void systemFatal(const char* message)
+{
+    perror(message);
+    exit(EXIT_FAILURE);
+}
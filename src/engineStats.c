@@ -0,0 +1,703 @@
+/*
+ -- SOURCE FILE: engineStats.c
+ --
+ -- PROGRAM: Web Client Emulator
+ --
+ -- FUNCTIONS:
+ -- engineCounters *engineJoin();
+ -- void engineLeave(engineCounters *counters);
+ -- void engineAttach(engineCounters *counters);
+ -- void engineSample(engineCounters *counters);
+ -- void engineWaiting(engineCounters *counters);
+ -- void engineWakeup(engineCounters *counters, int worked);
+ -- void engineLatency(engineCounters *counters,
+ --                    unsigned long long nanoseconds, unsigned int count);
+ -- unsigned long long engineBucketBound(unsigned int bucket);
+ -- void engineError(engineCounters *counters, unsigned int type);
+ -- unsigned int engineErrorType(int error);
+ -- const char *engineErrorName(unsigned int type);
+ -- engineCounters *engineThreads();
+ -- void engineAdd(engineCounters *total, const engineCounters *counters);
+ -- void engineSum(engineCounters *total);
+ -- int engineDescribe(const engineCounters *later,
+ --                    const engineCounters *earlier, char *text,
+ --                    size_t length);
+ -- int engineStartReporter(const char *name);
+ -- static void *reporter(void *data);
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Added accepts, closes, bytes sent, loop busy
+ -- and idle time and a request latency histogram. The registry is now read
+ -- without a lock, and the counters of threads that leave are reused rather
+ -- than freed.
+ -- October 18, 2026 - Added the connections rejected by admission control.
+ -- October 18, 2026 - Added the connections closed on an error, by type.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- NOTES:
+ -- Counts the work each server engine and the client do, so that a difference
+ -- in throughput can be explained by what the engines cost rather than only
+ -- observed. Every thread that serves requests keeps an engineCounters of its
+ -- own, which only it writes:
+ --
+ --     system calls and bytes moved and sent, counted by the network wrappers
+ --     and by the engines for the calls they make directly, see
+ --     setNetworkCounters
+ --     requests answered or made, and connections accepted, closed and
+ --     rejected by admission control
+ --     connections closed on an error, by type: a malformed request, a reset
+ --     by the peer or any other failed read or send
+ --     wakeups of an event loop, and the ones that found nothing to do
+ --     time an event loop spent working and waiting, see engineWaiting
+ --     voluntary and involuntary context switches, from getrusage
+ --     server side request latency, in fixed buckets, see engineLatency
+ --
+ -- getrusage is itself a system call, so a thread only samples its context
+ -- switches every ENGINE_SAMPLE_EVERY wakeups or requests and when it leaves.
+ -- A thread that is blocked is therefore a little behind in the reports until
+ -- it runs again.
+ --
+ -- The servers join a registry with engineJoin, and a reporter thread prints
+ -- the totals over every thread every ENGINE_REPORT_INTERVAL seconds. The
+ -- registry is a list that only ever grows, so readers such as the reporter
+ -- and the admin endpoint walk it without a lock and never hold up a serving
+ -- thread. A thread that leaves only marks its counters free, and the next
+ -- thread to join carries on counting in them, so the totals never go
+ -- backwards and the list is as long as the most threads ever at once. The
+ -- counters are single aligned words written by one thread, so a reader sees
+ -- each one whole, if a moment out of date. The client keeps its counters in
+ -- its shared results instead and reports them with its own intervals.
+ */
+
+// Includes
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "engineStats.h"
+#include "timing.h"
+
+static void *reporter(void *data);
+
+/* Counters of every thread that has joined, in use or free */
+static engineCounters *threads = 0;
+static unsigned int slots = 0;
+
+/* Upper bounds of the latency buckets in nanoseconds, the last is unbounded */
+static const unsigned long long latencyBounds[ENGINE_LATENCY_BUCKETS] =
+{
+    10000ULL, 25000ULL, 50000ULL, 100000ULL, 250000ULL, 500000ULL,
+    1000000ULL, 2500000ULL, 5000000ULL, 10000000ULL, 25000000ULL,
+    50000000ULL, 100000000ULL, 250000000ULL, 500000000ULL, 1000000000ULL, 0
+};
+
+/* Names of the connection errors, by type */
+static const char *errorNames[ENGINE_ERROR_TYPES] =
+{
+    "malformed", "reset", "io"
+};
+
+/* Context switches of the calling thread when it attached */
+static __thread long baseVoluntary = 0;
+static __thread long baseInvoluntary = 0;
+
+/*
+ -- FUNCTION: engineJoin
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Takes over free counters before making new
+ -- ones, and adds new ones to the registry without a lock.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: engineCounters *engineJoin();
+ --
+ -- RETURNS: the counters of the calling thread, or NULL if out of memory
+ --
+ -- NOTES:
+ -- Gives the calling thread counters in the registry and attaches it to
+ -- them. Counters taken over from a thread that left keep its counts.
+ */
+engineCounters *engineJoin()
+{
+    engineCounters *counters = 0;
+    
+    for (counters = threads; counters != NULL; counters = counters->next)
+    {
+        if (!counters->active &&
+            __sync_bool_compare_and_swap(&counters->active, 0, 1))
+        {
+            break;
+        }
+    }
+    
+    if (counters == NULL)
+    {
+        if ((counters = calloc(1, sizeof(engineCounters))) == NULL)
+        {
+            return NULL;
+        }
+        counters->active = 1;
+        counters->index = __sync_fetch_and_add(&slots, 1);
+        do
+        {
+            counters->next = threads;
+        }
+        while (!__sync_bool_compare_and_swap(&threads, counters->next,
+                                             counters));
+    }
+    
+    counters->waitStart = 0;
+    counters->wokeAt = 0;
+    engineAttach(counters);
+    
+    return counters;
+}
+
+/*
+ -- FUNCTION: engineLeave
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Marks the counters free instead of folding
+ -- them into a retired total.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void engineLeave(engineCounters *counters);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Takes a last sample and leaves the counters, with the thread's work in
+ -- them, for the next thread to join. Must be called by the thread that
+ -- joined.
+ */
+void engineLeave(engineCounters *counters)
+{
+    if (counters == NULL)
+    {
+        return;
+    }
+    
+    engineSample(counters);
+    setNetworkCounters(NULL);
+    
+    __sync_lock_release(&counters->active);
+}
+
+/*
+ -- FUNCTION: engineAttach
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void engineAttach(engineCounters *counters);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Makes the counters the ones the calling thread's system calls are counted
+ -- in, and starts counting its context switches from now.
+ */
+void engineAttach(engineCounters *counters)
+{
+    struct rusage usage;
+    
+    getrusage(RUSAGE_THREAD, &usage);
+    baseVoluntary = usage.ru_nvcsw;
+    baseInvoluntary = usage.ru_nivcsw;
+    
+    setNetworkCounters(&counters->network);
+}
+
+/*
+ -- FUNCTION: engineSample
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Adds the switches since the last sample,
+ -- so counters taken over from another thread keep their counts.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void engineSample(engineCounters *counters);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Brings the context switch counts of the calling thread up to date.
+ */
+void engineSample(engineCounters *counters)
+{
+    struct rusage usage;
+    
+    getrusage(RUSAGE_THREAD, &usage);
+    counters->voluntary += usage.ru_nvcsw - baseVoluntary;
+    counters->involuntary += usage.ru_nivcsw - baseInvoluntary;
+    baseVoluntary = usage.ru_nvcsw;
+    baseInvoluntary = usage.ru_nivcsw;
+}
+
+/*
+ -- FUNCTION: engineWaiting
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void engineWaiting(engineCounters *counters);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Called by an event loop just before it waits for events. The time since
+ -- the last wakeup is counted as busy, and the wait is timed until the
+ -- wakeup that ends it.
+ */
+void engineWaiting(engineCounters *counters)
+{
+    unsigned long long now = timingNow();
+    
+    if (counters->wokeAt != 0)
+    {
+        counters->busy += now - counters->wokeAt;
+    }
+    counters->waitStart = now;
+}
+
+/*
+ -- FUNCTION: engineWakeup
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Counts the time since engineWaiting as idle.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void engineWakeup(engineCounters *counters, int worked);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Counts a return from select or epoll_wait, which is itself a system call,
+ -- and whether it found any work. Every so often the context switches are
+ -- sampled too.
+ */
+void engineWakeup(engineCounters *counters, int worked)
+{
+    counters->wokeAt = timingNow();
+    if (counters->waitStart != 0)
+    {
+        counters->idle += counters->wokeAt - counters->waitStart;
+    }
+    
+    counters->wakeups++;
+    counters->emptyWakeups += !worked;
+    countSyscall(0);
+    
+    if (counters->wakeups % ENGINE_SAMPLE_EVERY == 0)
+    {
+        engineSample(counters);
+    }
+}
+
+/*
+ -- FUNCTION: engineLatency
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void engineLatency(engineCounters *counters,
+ --                               unsigned long long nanoseconds,
+ --                               unsigned int count);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Counts a number of requests that all took the given time to answer, from
+ -- the server reading them to the last byte of the reply being sent.
+ */
+void engineLatency(engineCounters *counters, unsigned long long nanoseconds,
+                   unsigned int count)
+{
+    unsigned int bucket = 0;
+    
+    while (bucket < ENGINE_LATENCY_BUCKETS - 1 &&
+           nanoseconds > latencyBounds[bucket])
+    {
+        bucket++;
+    }
+    
+    counters->latency[bucket] += count;
+    counters->latencyTotal += nanoseconds * count;
+}
+
+/*
+ -- FUNCTION: engineBucketBound
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: unsigned long long engineBucketBound(unsigned int bucket);
+ --
+ -- RETURNS: the upper bound of a latency bucket in nanoseconds, 0 for the
+ --          last bucket, which has none
+ */
+unsigned long long engineBucketBound(unsigned int bucket)
+{
+    return (bucket < ENGINE_LATENCY_BUCKETS) ? latencyBounds[bucket] : 0;
+}
+
+/*
+ -- FUNCTION: engineError
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void engineError(engineCounters *counters, unsigned int type);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Counts a connection closed on an error of the given type. The counters
+ -- may be NULL, for a thread that could not get any.
+ */
+void engineError(engineCounters *counters, unsigned int type)
+{
+    if (counters != NULL && type < ENGINE_ERROR_TYPES)
+    {
+        counters->errors[type]++;
+    }
+}
+
+/*
+ -- FUNCTION: engineErrorType
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: unsigned int engineErrorType(int error);
+ --
+ -- RETURNS: the type of error for an errno value from a read or send
+ --
+ -- NOTES:
+ -- A peer that reset the connection, or closed it while a send was going
+ -- out, is a reset. Anything else is an IO error.
+ */
+unsigned int engineErrorType(int error)
+{
+    return (error == ECONNRESET || error == EPIPE) ? ENGINE_ERROR_RESET :
+           ENGINE_ERROR_IO;
+}
+
+/*
+ -- FUNCTION: engineErrorName
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: const char *engineErrorName(unsigned int type);
+ --
+ -- RETURNS: the name of an error type, for reports
+ */
+const char *engineErrorName(unsigned int type)
+{
+    return (type < ENGINE_ERROR_TYPES) ? errorNames[type] : "unknown";
+}
+
+/*
+ -- FUNCTION: engineThreads
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: engineCounters *engineThreads();
+ --
+ -- RETURNS: the first counters in the registry, follow next for the rest
+ --
+ -- NOTES:
+ -- The list can be walked at any time without a lock. Counters that are not
+ -- active belong to no thread at the moment.
+ */
+engineCounters *engineThreads()
+{
+    return threads;
+}
+
+/*
+ -- FUNCTION: engineAdd
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Adds the new counters.
+ -- October 18, 2026 - Adds the rejected connections.
+ -- October 18, 2026 - Adds the connection errors.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void engineAdd(engineCounters *total,
+ --                           const engineCounters *counters);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Adds one set of counters to a total.
+ */
+void engineAdd(engineCounters *total, const engineCounters *counters)
+{
+    unsigned int bucket = 0;
+    
+    total->network.syscalls += counters->network.syscalls;
+    total->network.bytes += counters->network.bytes;
+    total->network.sent += counters->network.sent;
+    total->requests += counters->requests;
+    total->accepts += counters->accepts;
+    total->closes += counters->closes;
+    total->rejected += counters->rejected;
+    for (bucket = 0; bucket < ENGINE_ERROR_TYPES; bucket++)
+    {
+        total->errors[bucket] += counters->errors[bucket];
+    }
+    total->wakeups += counters->wakeups;
+    total->emptyWakeups += counters->emptyWakeups;
+    total->voluntary += counters->voluntary;
+    total->involuntary += counters->involuntary;
+    total->busy += counters->busy;
+    total->idle += counters->idle;
+    for (bucket = 0; bucket < ENGINE_LATENCY_BUCKETS; bucket++)
+    {
+        total->latency[bucket] += counters->latency[bucket];
+    }
+    total->latencyTotal += counters->latencyTotal;
+}
+
+/*
+ -- FUNCTION: engineSum
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Reads the registry without a lock.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void engineSum(engineCounters *total);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Adds up the counters in the registry, which hold the work of every thread
+ -- that ever joined. The threads keep running while they are read, so a
+ -- total may be off by the odd request, which the next one makes up for.
+ */
+void engineSum(engineCounters *total)
+{
+    engineCounters *counters = 0;
+    
+    memset(total, 0, sizeof(engineCounters));
+    
+    for (counters = threads; counters != NULL; counters = counters->next)
+    {
+        engineAdd(total, counters);
+    }
+}
+
+/*
+ -- FUNCTION: engineDescribe
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int engineDescribe(const engineCounters *later,
+ --                               const engineCounters *earlier, char *text,
+ --                               size_t length);
+ --
+ -- RETURNS: the length of the description
+ --
+ -- NOTES:
+ -- Writes the work done between two totals per request: system calls, bytes
+ -- moved per system call, context switches and the share of wakeups that
+ -- found nothing to do. Engines without an event loop have no wakeups.
+ */
+int engineDescribe(const engineCounters *later,
+                   const engineCounters *earlier, char *text, size_t length)
+{
+    double requests = later->requests - earlier->requests;
+    double syscalls = later->network.syscalls - earlier->network.syscalls;
+    double wakeups = later->wakeups - earlier->wakeups;
+    
+    if (requests == 0)
+    {
+        requests = 1;
+    }
+    
+    return snprintf(text, length, "%.2f syscalls/req, %.0f bytes/syscall, "
+                    "%.3f voluntary and %.3f involuntary switches/req, "
+                    "%.0f wakeups (%.1f%% empty)", syscalls / requests,
+                    syscalls ? (later->network.bytes -
+                                earlier->network.bytes) / syscalls : 0,
+                    (later->voluntary - earlier->voluntary) / requests,
+                    (later->involuntary - earlier->involuntary) / requests,
+                    wakeups, wakeups ? (later->emptyWakeups -
+                                        earlier->emptyWakeups) * 100.0 /
+                                       wakeups : 0);
+}
+
+/*
+ -- FUNCTION: engineStartReporter
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int engineStartReporter(const char *name);
+ --
+ -- RETURNS: 0 on success, -1 if the thread could not be started
+ --
+ -- NOTES:
+ -- Starts a detached thread that prints the throughput and the cost per
+ -- request of the registry every ENGINE_REPORT_INTERVAL seconds, under the
+ -- given name. Intervals with no requests are not printed.
+ */
+int engineStartReporter(const char *name)
+{
+    pthread_t thread = 0;
+    pthread_attr_t attr;
+    int result = 0;
+    
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    result = pthread_create(&thread, &attr, reporter, (void *)name);
+    pthread_attr_destroy(&attr);
+    
+    return (result == 0) ? 0 : -1;
+}
+
+/*
+ -- FUNCTION: reporter
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Also prints the connection errors of an
+ -- interval that had any.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void *reporter(void *data);
+ --
+ -- RETURNS: NULL, it never returns
+ --
+ -- NOTES:
+ -- The reporter thread started by engineStartReporter.
+ */
+static void *reporter(void *data)
+{
+    const char *name = (const char *)data;
+    unsigned int type = 0;
+    char text[256];
+    engineCounters previous;
+    engineCounters current;
+    
+    memset(&previous, 0, sizeof(engineCounters));
+    
+    while (1)
+    {
+        sleep(ENGINE_REPORT_INTERVAL);
+        
+        engineSum(&current);
+        if (current.requests != previous.requests)
+        {
+            engineDescribe(&current, &previous, text, sizeof(text));
+            printf("%s: %.1f req/s, %s\n", name,
+                   (double)(current.requests - previous.requests) /
+                   ENGINE_REPORT_INTERVAL, text);
+            fflush(stdout);
+        }
+        if (memcmp(current.errors, previous.errors, sizeof(current.errors)))
+        {
+            printf("%s: connections closed on errors,", name);
+            for (type = 0; type < ENGINE_ERROR_TYPES; type++)
+            {
+                printf(" %llu %s", current.errors[type] -
+                       previous.errors[type], engineErrorName(type));
+            }
+            printf("\n");
+            fflush(stdout);
+        }
+        memcpy(&previous, &current, sizeof(engineCounters));
+    }
+    
+    return NULL;
+}
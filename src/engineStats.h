@@ -0,0 +1,69 @@
+#ifndef ENGINE_STATS_H
+#define ENGINE_STATS_H
+
+#include <stddef.h>
+
+#include "network.h"
+
+/* Defines */
+#define ENGINE_REPORT_INTERVAL 5
+#define ENGINE_SAMPLE_EVERY 64
+#define ENGINE_LATENCY_BUCKETS 17
+
+/* Ways a connection can fail, counted by type in engineCounters */
+#define ENGINE_ERROR_MALFORMED 0
+#define ENGINE_ERROR_RESET 1
+#define ENGINE_ERROR_IO 2
+#define ENGINE_ERROR_TYPES 3
+
+/* The work done by one thread of a server or client */
+typedef struct engineCounters
+{
+    networkCounters network;
+    unsigned long long requests;
+    unsigned long long accepts;
+    unsigned long long closes;
+    unsigned long long rejected;
+    unsigned long long errors[ENGINE_ERROR_TYPES];
+    unsigned long long wakeups;
+    unsigned long long emptyWakeups;
+    unsigned long long voluntary;
+    unsigned long long involuntary;
+    unsigned long long busy;
+    unsigned long long idle;
+    unsigned long long latency[ENGINE_LATENCY_BUCKETS];
+    unsigned long long latencyTotal;
+    unsigned long long waitStart;
+    unsigned long long wokeAt;
+    unsigned int index;
+    int active;
+    struct engineCounters *next;
+} engineCounters;
+
+/* Function Prototypes */
+#ifdef __cplusplus
+extern "C" {
+#endif
+    engineCounters *engineJoin();
+    void engineLeave(engineCounters *counters);
+    void engineAttach(engineCounters *counters);
+    void engineSample(engineCounters *counters);
+    void engineWaiting(engineCounters *counters);
+    void engineWakeup(engineCounters *counters, int worked);
+    void engineLatency(engineCounters *counters,
+                       unsigned long long nanoseconds, unsigned int count);
+    unsigned long long engineBucketBound(unsigned int bucket);
+    void engineError(engineCounters *counters, unsigned int type);
+    unsigned int engineErrorType(int error);
+    const char *engineErrorName(unsigned int type);
+    engineCounters *engineThreads();
+    void engineAdd(engineCounters *total, const engineCounters *counters);
+    void engineSum(engineCounters *total);
+    int engineDescribe(const engineCounters *later,
+                       const engineCounters *earlier, char *text,
+                       size_t length);
+    int engineStartReporter(const char *name);
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -5,42 +5,165 @@
  --
  --	FUNCTIONS:		
  --                 int main(int argc, char **argv);
- --                 void server(int port, int comm);
- --                 int processConnection(int socket, int comm);
- --                 void initializeServer(int *listenSocket, int *port);
+ --                 void server(int port, int comm, int reactors,
+ --                             const coreList *cores, int spin,
+ --                             long quantum, int handoff,
+ --                             const networkAddress *addresses,
+ --                             const int *counts, int groups);
+ --                 static void steerGroup(reactorData *group, int reactors);
+ --                 void *reactor(void *data);
+ --                 void *acceptor(void *data);
+ --                 static int leastLoaded(acceptorData *self);
+ --                 static void wakeReactors(acceptorData *self);
+ --                 static void addConnection(reactorData *self, int epoll,
+ --                                           int client,
+ --                                           engineCounters *engine,
+ --                                           int *busyPoll);
+ --                 static unsigned long long monotonicTime();
+ --                 static void reportPolling(reactorData *self,
+ --                                           pollStats *stats,
+ --                                           unsigned long long now);
+ --                 int processConnection(connection *client,
+ --                                       pollStats *stats, long quantum);
+ --                 int flushConnection(connection *client, pollStats *stats);
+ --                 static void closeConnection(connection *client);
+ --                 static void runLater(runQueue *queue, connection *client);
+ --                 void initializeServer(int *listenSocket, int *port,
+ --                                       int reusePort,
+ --                                       const networkAddress *address);
  --                 void displayClientData(unsigned long long clients);
  --                 static void systemFatal(const char *message);
  --
  --	DATE:			February 8, 2012
  --
- --	REVISIONS:		(Date and Description)
+ --	REVISIONS:		October 18, 2026 - Added -a to pin the server to a core.
+ --                  October 18, 2026 - Added -r to run several reactors, with
+ --                  connections steered to the reactor on their receive CPU.
+ --                  October 18, 2026 - Added the -b busy polling mode.
+ --                  October 18, 2026 - Added -d to serve files from a document
+ --                  root, see fileServe.c.
+ --                  October 18, 2026 - Added -c for the file cache limits, and
+ --                  the file cache counters are shown with the client count.
+ --                  October 18, 2026 - The reactors read every ready socket
+ --                  before sending any replies, see reactor.
+ --                  October 18, 2026 - The reactors count their system calls,
+ --                  context switches and empty wakeups, see engineStats.c.
+ --                  October 18, 2026 - Added -t to trace a sample of the
+ --                  connections, see trace.c.
+ --                  October 18, 2026 - Added -A to serve live counters on an
+ --                  admin port, see admin.c. The reactors time their waits
+ --                  and their replies for it.
+ --                  October 18, 2026 - Added -L for admission control, see
+ --                  admission.c.
+ --                  October 18, 2026 - Added -q to share the reactors between
+ --                  connections by deficit round robin, see reactor.
+ --                  October 18, 2026 - Added -H to accept on one thread and
+ --                  hand the connections to the reactors, see acceptor.
+ --                  October 18, 2026 - Requests are parsed in batches by
+ --                  requestParser.c.
+ --                  October 18, 2026 - Every failure on a connection closes
+ --                  only that connection and is counted by type, and SIGPIPE
+ --                  is ignored.
+ --                  October 18, 2026 - Added -u to serve a UNIX domain
+ --                  socket at a path instead of a TCP port. Every reactor
+ --                  shares the one socket.
+ --                  October 18, 2026 - Added -l to listen on a list of IPv4
+ --                  and IPv6 addresses, each with its own reactors.
  --
  --	DESIGNERS:      Luke Queenan
  --
  --	PROGRAMMERS:	Luke Queenan
  --
  --	NOTES:
- -- A simple epoll server
+ -- A simple epoll server. With -r N the server runs N reactor threads, each an
+ -- independent epoll loop on its own core with its own listening socket.
+ --
+ -- With -b MICROSECONDS the reactors busy poll: epoll_wait is called with a
+ -- zero timeout for as long as work keeps arriving, and a reactor only goes
+ -- back to a blocking wait after the given time without any events. Client
+ -- sockets are also given SO_BUSY_POLL, so a read that finds nothing spins on
+ -- the device queue for a moment instead of sleeping. Every reactor reports
+ -- its CPU use, the share of empty polls and the CPU time spent per event
+ -- every few seconds, in either mode, which is the cost side of the lower
+ -- latency measured by the client.
+ --
+ -- Each wakeup is handled in two phases. The first reads everything waiting
+ -- on every ready socket and parses the requests in it, which only queues the
+ -- replies. The second goes over the connections with replies queued and
+ -- sends all of a connection's replies with one sendmsg. Pipelined requests
+ -- therefore cost one read and one send between them, rather than the one
+ -- byte reads and a send per request of the old loop. A connection whose
+ -- send buffer fills keeps the rest queued and is watched for EPOLLOUT.
+ --
+ -- With -q BYTES a connection only has that many bytes of replies queued a
+ -- round. A client pipelining hundreds of requests then no longer holds up
+ -- every other connection on its reactor while they are parsed and sent.
+ --
+ -- With -H the reactors do not listen. A single acceptor thread owns the one
+ -- listening socket and hands each connection to the reactor with the fewest
+ -- open, over a lock free queue, see mpscQueue.c. SO_REUSEPORT spreads
+ -- connections by a hash of their addresses, which piles them onto a few
+ -- reactors when most come from a few NAT'd clients, and this spreads them by
+ -- load instead at the cost of a thread and a wakeup per batch.
+ --
+ -- With -l ADDRESS[@REACTORS],... the server listens on each address in the
+ -- list, IPv4 or IPv6, instead of every IPv4 address. Each address has its
+ -- own group of reactors, -r of them unless the address says otherwise, and
+ -- its own SO_REUSEPORT group steered by CPU, so the connections of one
+ -- interface are served by its own cores. With -H the acceptor listens on
+ -- every address and hands the connections to any reactor.
  ----------------------------------------------------------------------------*/
 
 /* System includes */
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/resource.h>
+#include <sys/uio.h>
+#include <time.h>
 #include <unistd.h>
 
 /* User includes */
+#include "admin.h"
+#include "admission.h"
+#include "affinity.h"
+#include "engineStats.h"
+#include "fileServe.h"
+#include "mpscQueue.h"
 #include "network.h"
+#include "requestParser.h"
+#include "timing.h"
+#include "trace.h"
 
 #define MAX_EVENTS 10000
+#define MAX_REACTORS 256
+
+/* Microseconds a blocking socket read busy polls the device queue for */
+#define BUSY_POLL_TIME 50
+
+/* Nanoseconds between polling reports */
+#define POLL_REPORT_INTERVAL 5000000000ULL
+
+/* Most reply buffers handed to one sendmsg */
+#define FLUSH_PARTS 64
+
+/* Most connections the acceptor takes before waking the reactors */
+#define HANDOFF_BATCH 64
 
 int main(int argc, char **argv);
-void server(int port, int comm);
-int processConnection(int socket, int comm);
-void initializeServer(int *listenSocket, int *port);
+void server(int port, int comm, int reactors, const coreList *cores,
+            int spin, long quantum, int handoff,
+            const networkAddress *addresses, const int *counts, int groups);
+void *reactor(void *data);
+void *acceptor(void *data);
+void initializeServer(int *listenSocket, int *port, int reusePort,
+                      const networkAddress *address);
 void displayClientData(unsigned long long clients);
 static void systemFatal(const char *message);
 
@@ -50,12 +173,114 @@ typedef struct
     int commSocket;
 } clientData;
 
+/* One epoll loop and the socket it accepts on */
+typedef struct
+{
+    int listenSocket;
+    int comm;
+    int core;
+    int index;
+    int spin;
+    long quantum;
+    mpscQueue *handoff;
+    volatile int load;
+} reactorData;
+
+/* The thread that accepts for every reactor, with -H */
+typedef struct
+{
+    int listenSockets[NETWORK_MAX_ADDRESSES];
+    int listeners;
+    int reactors;
+    int next;
+    int *touched;
+    reactorData *reactorList;
+} acceptorData;
+
+/* Polling counters for one reactor, reset at every report */
+typedef struct
+{
+    unsigned long long polls;
+    unsigned long long emptyPolls;
+    unsigned long long sleeps;
+    unsigned long long events;
+    unsigned long long reads;
+    unsigned long long sends;
+    unsigned long long lastReport;
+    unsigned long long lastCpu;
+} pollStats;
+
+/* A client socket and the requests read from it but not yet answered */
+typedef struct connection
+{
+    int socket;
+    int length;
+    int queued;
+    int watchingOut;
+    int runnable;
+    int listed;
+    int closed;
+    int closing;
+    long deficit;
+    unsigned int answering;
+    unsigned long long pending;
+    unsigned long long readyAt;
+    unsigned long long visited;
+    fileReply file;
+    engineCounters *engine;
+    volatile int *load;
+    unsigned int trace;
+    struct connection *nextRun;
+    char input[NETWORK_BUFFER_SIZE];
+} connection;
+
+/* The connections with input left over once their quantum was used */
+typedef struct
+{
+    connection *head;
+    connection *tail;
+} runQueue;
+
+int processConnection(connection *client, pollStats *stats, long quantum);
+int flushConnection(connection *client, pollStats *stats);
+static void closeConnection(connection *client);
+static void runLater(runQueue *queue, connection *client);
+static void steerGroup(reactorData *group, int reactors);
+static int leastLoaded(acceptorData *self);
+static void wakeReactors(acceptorData *self);
+static void addConnection(reactorData *self, int epoll, int client,
+                          engineCounters *engine, int *busyPoll);
+static unsigned long long monotonicTime();
+static void reportPolling(reactorData *self, pollStats *stats,
+                          unsigned long long now);
+
+/* Connections over all of the reactors */
+static unsigned long long connections = 0;
+
+/* Every reply is made of these bytes */
+static char replyData[NETWORK_BUFFER_SIZE];
+
 /*
  -- FUNCTION: main
  --
  -- DATE: Feb 20, 2011
  --
- -- REVISIONS: (Date and Description)
+ -- REVISIONS: October 18, 2026 - Added the -a option for a core list.
+ -- October 18, 2026 - Added the -r option for the number of reactors.
+ -- October 18, 2026 - Added the -b option for busy polling.
+ -- October 18, 2026 - Added the -T option for a socket tuning profile.
+ -- October 18, 2026 - Added the -d option for a document root.
+ -- October 18, 2026 - Added the -c option for the file cache limits.
+ -- October 18, 2026 - Added the -t option for request tracing.
+ -- October 18, 2026 - Added the -A option for an admin port.
+ -- October 18, 2026 - Added the -L option for admission control.
+ -- October 18, 2026 - Added the -q option for the bytes each connection is
+ -- served per round.
+ -- October 18, 2026 - Added the -H option for an acceptor thread.
+ -- October 18, 2026 - Ignores SIGPIPE, so a client that goes away during
+ -- a send only fails that send.
+ -- October 18, 2026 - Added the -u option to serve a UNIX domain socket path.
+ -- October 18, 2026 - Added the -l option for a list of listen addresses.
  --
  -- DESIGNER: Luke Queenan
  --
@@ -73,22 +298,227 @@ int main(int argc, char **argv)
     /* Initialize port and give default option in case of no user input */
     int port = DEFAULT_PORT;
     int option = 0;
+    int reactors = 1;
+    int spin = 0;
+    int adminPort = 0;
+    int handoff = 0;
+    int groups = 0;
+    int group = 0;
+    int total = 0;
     int comms[2];
+    int counts[NETWORK_MAX_ADDRESSES];
+    long quantum = 0;
+    unsigned int cacheEntries = FILE_CACHE_ENTRIES;
+    unsigned long cacheMegabytes = FILE_CACHE_MEGABYTES;
+    unsigned int traceEvery = 1;
+    char *root = 0;
+    char *tracePath = 0;
+    char *limits = 0;
+    char *listenList = 0;
+    char *end = 0;
+    char message[NETWORK_BUFFER_SIZE];
+    networkAddress addresses[NETWORK_MAX_ADDRESSES];
+    coreList cores;
+    
+    cores.count = 0;
     
     /* Parse command line parameters using getopt */
-    while ((option = getopt(argc, argv, "p:")) != -1)
+    while ((option = getopt(argc, argv, "p:a:r:b:T:d:c:t:A:L:q:Hu:l:")) != -1)
     {
         switch (option)
         {
             case 'p':
                 port = atoi(optarg);
                 break;
+            case 'a':
+                if (parseCoreList(optarg, &cores) == -1)
+                {
+                    fprintf(stderr, "No usable cores in %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'r':
+                reactors = atoi(optarg);
+                break;
+            case 'b':
+                spin = atoi(optarg);
+                break;
+            case 'd':
+                root = optarg;
+                break;
+            case 'c':
+                cacheEntries = strtoul(optarg, &end, 10);
+                if (*end == ',')
+                {
+                    cacheMegabytes = strtoul(end + 1, NULL, 10);
+                }
+                break;
+            case 't':
+                tracePath = optarg;
+                if ((end = strchr(optarg, ',')) != NULL)
+                {
+                    *end = '\0';
+                    traceEvery = strtoul(end + 1, NULL, 10);
+                }
+                break;
+            case 'A':
+                adminPort = atoi(optarg);
+                break;
+            case 'L':
+                limits = optarg;
+                break;
+            case 'q':
+                quantum = atol(optarg);
+                break;
+            case 'H':
+                handoff = 1;
+                break;
+            case 'l':
+                listenList = optarg;
+                break;
+            case 'u':
+                if (setUnixPath(optarg) == -1)
+                {
+                    fprintf(stderr, "Socket path too long: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'T':
+                if (loadSocketTuning(optarg, message, sizeof(message)) == -1)
+                {
+                    fprintf(stderr, "Socket tuning: %s\n", message);
+                    return 1;
+                }
+                break;
             default:
-                fprintf(stderr, "Usage: %s -p [port]\n", argv[0]);
+                fprintf(stderr, "Usage: %s -p [port] -u [path] "
+                        "-l [address[@reactors],...] -a [cores] -r [reactors] "
+                        "-b [spin microseconds] -T [tuning] -d [root] -c [entries,megabytes] -t [trace,every] -A [admin port] "
+                        "-L [connections,inflight[,target us,interval ms]] "
+                        "-q [quantum bytes] -H\n", argv[0]);
                 return 0;
         }
     }
     
+    /* A client gone mid send is an error on its connection, not a signal */
+    signal(SIGPIPE, SIG_IGN);
+    
+    /* Calibrate the clock requests are timed with before any threads start */
+    timingInit();
+    
+    if (limits != NULL)
+    {
+        if (admissionConfigure(limits) == -1)
+        {
+            fprintf(stderr, "Admission control: %s is not valid\n", limits);
+            return 1;
+        }
+        admissionDescribe(message, sizeof(message));
+        printf("Admission control: %s\n", message);
+    }
+    
+    if (reactors < 1 || reactors > MAX_REACTORS)
+    {
+        fprintf(stderr, "Reactors must be between 1 and %d\n", MAX_REACTORS);
+        return 1;
+    }
+    
+    if (listenList != NULL)
+    {
+        if (getUnixPath() != NULL)
+        {
+            fprintf(stderr, "Listen addresses cannot be used with a path\n");
+            return 1;
+        }
+        if ((groups = parseAddressList(listenList, addresses, counts,
+                                       NETWORK_MAX_ADDRESSES)) == -1)
+        {
+            fprintf(stderr, "Listen addresses: %s is not valid\n",
+                    listenList);
+            return 1;
+        }
+        
+        /* An address without a count gets the -r reactors */
+        for (group = 0; group < groups; group++)
+        {
+            if (counts[group] == 0)
+            {
+                counts[group] = reactors;
+            }
+            total += counts[group];
+        }
+        if (total > MAX_REACTORS)
+        {
+            fprintf(stderr, "Reactors must be between 1 and %d\n",
+                    MAX_REACTORS);
+            return 1;
+        }
+        reactors = total;
+    }
+    
+    describeSocketTuning(message, sizeof(message));
+    printf("Socket tuning: %s\n", message);
+    if (getUnixPath() != NULL)
+    {
+        printf("Listening on %s instead of a port\n", getUnixPath());
+    }
+    for (group = 0; group < groups; group++)
+    {
+        describeAddress(&addresses[group], message, sizeof(message));
+        printf("Listening on %s with %d reactors\n", message, counts[group]);
+    }
+    printf("Parsing requests with %s\n", requestParserName());
+    
+    if (root != NULL)
+    {
+        if (openDocumentRoot(root, cacheEntries,
+                             cacheMegabytes * 1024 * 1024) == -1)
+        {
+            perror(root);
+            return 1;
+        }
+        printf("Serving files from %s, caching up to %u files and %lu MB\n",
+               root, cacheEntries, cacheMegabytes);
+    }
+    
+    if (tracePath != NULL)
+    {
+        if (traceStart(tracePath, traceEvery) == -1)
+        {
+            perror(tracePath);
+            return 1;
+        }
+        printf("Tracing one connection in %u to %s\n",
+               traceEvery ? traceEvery : 1, tracePath);
+    }
+    
+    if (adminPort != 0)
+    {
+        if (adminStart(adminPort, "epoll") == -1)
+        {
+            perror("Unable to open the admin port");
+            return 1;
+        }
+        printf("Serving metrics on port %d\n", adminPort);
+    }
+    
+    if (quantum < 0)
+    {
+        fprintf(stderr, "The quantum cannot be negative\n");
+        return 1;
+    }
+    if (quantum != 0)
+    {
+        printf("Serving each connection %ld bytes of replies a round\n",
+               quantum);
+    }
+    
+    /* Several reactors are spread over every core unless told otherwise */
+    if (reactors > 1 && cores.count == 0 && parseCoreList("all", &cores) == -1)
+    {
+        systemFatal("Unable to get the usable cores");
+    }
+    
     /* Create the socket pair for sending data for collection */
     if (socketpair(AF_UNIX, SOCK_STREAM, 0, comms) == -1)
     {
@@ -98,7 +528,8 @@ int main(int argc, char **argv)
     /* Need to fork and create process to collect data */
     
     /* Start server */
-    server(port, comms[1]);
+    server(port, comms[1], reactors, &cores, spin, quantum, handoff,
+           addresses, counts, groups);
     
     return 0;
 }
@@ -108,103 +539,187 @@ int main(int argc, char **argv)
  --
  -- DATE: Feb 20, 2011
  --
- -- REVISIONS: (Date and Description)
+ -- REVISIONS: October 18, 2026 - The server now starts one or more reactors,
+ -- each with its own listening socket and epoll object, and steers each new
+ -- connection to the reactor on the CPU that received its packets. The epoll
+ -- loop itself moved to reactor.
+ -- October 18, 2026 - Passes the busy polling time on to the reactors.
+ -- October 18, 2026 - Starts the engine statistics reporter.
+ -- October 18, 2026 - Passes the quantum on to the reactors.
+ -- October 18, 2026 - With handoff set, binds a single listening socket for
+ -- an acceptor thread and gives each reactor a queue instead.
+ -- October 18, 2026 - The reactors share one socket, without steering, when
+ -- serving a path.
+ -- October 18, 2026 - Takes groups of reactors, each listening on its own
+ -- address and steered on its own. The steering moved to steerGroup.
  --
  -- DESIGNER: Luke Queenan
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: void server(int, int)
+ -- INTERFACE: void server(int, int, int, const coreList *, int, long, int,
+ --                        const networkAddress *, const int *, int)
  --
  -- RETURNS: void
  --
  -- NOTES:
- -- This function contains the server loop for epoll. It accept client
- -- connections and calls the process connection function when a socket is ready
- -- for reading.
+ -- This function sets up the reactors and runs the first one itself. With more
+ -- than one reactor every reactor binds its own SO_REUSEPORT socket to the
+ -- port, and a BPF program picks the socket by the CPU the connection came in
+ -- on. Reactor N runs on the Nth core of the core list, so a connection whose
+ -- packets are handled in softirq on a core is accepted and served on that
+ -- same core, and its socket stays warm in that core's cache. Cores without a
+ -- reactor are shared out between the reactors.
+ --
+ -- With handoff set no reactor listens. The acceptor thread runs on the core
+ -- after the reactors' and feeds them through their queues.
+ --
+ -- A UNIX domain path can only be bound once and has no receive CPU, so when
+ -- serving one the reactors share a single socket and are not steered.
+ --
+ -- With groups of addresses, the first counts[0] reactors listen on the
+ -- first address, the next counts[1] on the second and so on, and the
+ -- acceptor of handoff listens on them all. Without, there is one group of
+ -- every reactor on every IPv4 address, or on the path.
  */
-void server(int port, int comm)
+void server(int port, int comm, int reactors, const coreList *cores,
+            int spin, long quantum, int handoff,
+            const networkAddress *addresses, const int *counts, int groups)
 {
-    register int epoll = 0;
-    register int ready = 0;
-    register int index = 0;
-    int listenSocket = 0;
-    int client = 0;
+    int index = 0;
+    int group = 0;
+    int first = 0;
+    const networkAddress *address = 0;
+    reactorData *reactorList = 0;
+    acceptorData *accepting = 0;
+    pthread_t thread = 0;
+    pthread_attr_t attr;
     
-    struct epoll_event event;
-    struct epoll_event events[MAX_EVENTS];
-    unsigned long long connections = 0;
-    
-    /* Initialize the server */
-    initializeServer(&listenSocket, &port);
-    
-    /* Set up epoll variables */
-    if ((epoll = epoll_create1(0)) == -1)
+    if ((reactorList = calloc(reactors, sizeof(reactorData))) == NULL)
     {
-        systemFatal("Unable to create epoll object");
+        systemFatal("Unable to allocate reactors");
     }
     
-    event.events = EPOLLIN;
-    event.data.fd = listenSocket;
+    /* Ready the memory for sending to the clients */
+    memset(replyData, 'L', NETWORK_BUFFER_SIZE);
     
-    if (epoll_ctl(epoll, EPOLL_CTL_ADD, listenSocket, &event) == -1)
+    if (handoff)
     {
-        systemFatal("Unable to add listen socket to epoll");
+        if ((accepting = calloc(1, sizeof(acceptorData))) == NULL ||
+            (accepting->touched = calloc(reactors, sizeof(int))) == NULL)
+        {
+            systemFatal("Unable to allocate the acceptor");
+        }
+        accepting->reactors = reactors;
+        accepting->reactorList = reactorList;
     }
     
-    displayClientData(connections);
+    /* One group of every reactor when not given addresses */
+    if (groups == 0)
+    {
+        addresses = NULL;
+        counts = &reactors;
+        groups = 1;
+    }
     
-    while (1)
+    for (group = 0; group < groups; first += counts[group++])
     {
-        /* Wait for epoll to return with the maximum events specified */
-        ready = epoll_wait(epoll, events, MAX_EVENTS, -1);
-        if (ready == -1)
+        address = (addresses != NULL) ? &addresses[group] : NULL;
+        if (handoff)
         {
-            systemFatal("Epoll wait error");
+            initializeServer(&accepting->listenSockets[accepting->listeners++],
+                             &port, 0, address);
         }
         
-        /* Iterate through the returned sockets and deal with them */
-        for (index = 0; index < ready; index++)
+        /* Bind every socket before steering, the index of a socket in the
+         group is the order it was bound in */
+        for (index = first; index < first + counts[group]; index++)
         {
-            if (events[index].data.fd == listenSocket)
+            reactorList[index].comm = comm;
+            reactorList[index].core = affinityCore(cores, index);
+            reactorList[index].index = index;
+            reactorList[index].spin = spin;
+            reactorList[index].quantum = quantum;
+            if (handoff)
             {
-                /* Accept the new connections */
-                while ((client = acceptConnection(&listenSocket)) != -1)
+                reactorList[index].listenSocket = -1;
+                if ((reactorList[index].handoff = mpscCreate(MPSC_QUEUE_SIZE))
+                    == NULL)
                 {
-                    if (makeSocketNonBlocking(&client) == -1)
-                    {
-                        systemFatal("Cannot make client socket non-blocking");
-                    }
-                    event.events = EPOLLIN | EPOLLET;
-                    event.data.fd = client;
-                    if (epoll_ctl(epoll, EPOLL_CTL_ADD, client, &event) == -1)
-                    {
-                        systemFatal("Cannot add client socket to epoll");
-                    }
-                    connections++;
-                    displayClientData(connections);
+                    systemFatal("Unable to create a handoff queue");
                 }
+                continue;
             }
-            else
+            if (index > first && getUnixPath() != NULL)
             {
-                if (processConnection(events[index].data.fd, comm) == 0)
+                /* A path is bound once, the reactors share the one socket */
+                if ((reactorList[index].listenSocket =
+                     dup(reactorList[first].listenSocket)) == -1)
                 {
-                    close(events[index].data.fd);
-                    connections--;
-                    displayClientData(connections);
+                    systemFatal("Cannot share the listen socket");
                 }
+                continue;
             }
+            initializeServer(&reactorList[index].listenSocket, &port,
+                             counts[group] > 1 && getUnixPath() == NULL,
+                             address);
+        }
+        
+        if (!handoff && counts[group] > 1 && getUnixPath() == NULL)
+        {
+            steerGroup(&reactorList[first], counts[group]);
         }
     }
     
-    close(listenSocket);
-    close(epoll);
+    displayClientData(0);
+    
+    if (engineStartReporter("Epoll server") == -1)
+    {
+        systemFatal("Unable to start the engine statistics reporter");
+    }
+    
+    /* Start the other reactors on their cores */
+    pthread_attr_init(&attr);
+    if (pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) != 0)
+    {
+        systemFatal("Unable to set thread attributes to detached");
+    }
+    for (index = 1; index < reactors; index++)
+    {
+        if (setAttrAffinity(&attr, reactorList[index].core) != 0 ||
+            pthread_create(&thread, &attr, reactor, &reactorList[index]) != 0)
+        {
+            systemFatal("Unable to start reactor");
+        }
+    }
+    if (handoff)
+    {
+        if (setAttrAffinity(&attr, affinityCore(cores, reactors)) != 0 ||
+            pthread_create(&thread, &attr, acceptor, accepting) != 0)
+        {
+            systemFatal("Unable to start the acceptor");
+        }
+        printf("Accepting on one thread for %d reactors\n", reactors);
+    }
+    pthread_attr_destroy(&attr);
+    
+    /* This thread is the first reactor */
+    if (reactorList[0].core >= 0)
+    {
+        if (pinThread(reactorList[0].core) != 0)
+        {
+            systemFatal("Unable to pin reactor");
+        }
+        printf("Running %d reactors from core %d\n", reactors,
+               reactorList[0].core);
+    }
+    reactor(&reactorList[0]);
 }
 
 /*
- -- FUNCTION: processConnection
+ -- FUNCTION: steerGroup
  --
- -- DATE: Feb 20, 2011
+ -- DATE: October 18, 2026
  --
  -- REVISIONS: (Date and Description)
  --
@@ -212,107 +727,1221 @@ void server(int port, int comm)
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: int processConnection(int, int)
+ -- INTERFACE: static void steerGroup(reactorData *group, int reactors)
  --
- -- RETURNS: 1 on success
+ -- RETURNS: void
  --
  -- NOTES:
- -- Service a client socket by reading a request and sending the data to the
- -- client.
+ -- Steers the connections to one SO_REUSEPORT group of reactors by their
+ -- receive CPU. Each CPU a reactor of the group runs on maps to that
+ -- reactor, and the rest are shared out between them. A group that cannot
+ -- be steered falls back to the kernel's hash.
  */
-int processConnection(int socket, int comm)
+static void steerGroup(reactorData *group, int reactors)
 {
-    int bytesToWrite = 0;
-    char line[NETWORK_BUFFER_SIZE];
-    char result[NETWORK_BUFFER_SIZE];
+    int index = 0;
+    int cpu = 0;
+    int cpus = sysconf(_SC_NPROCESSORS_CONF);
+    unsigned int *indexOfCpu = 0;
     
-    /* Ready the memory for sending to the client */
-    memset(result, 'L', NETWORK_BUFFER_SIZE);
-    
-    /* Read the request from the client */
-    if (readLine(&socket, line, NETWORK_BUFFER_SIZE) <= 0)
+    /* Map each CPU to the reactor running on it */
+    if ((indexOfCpu = malloc(sizeof(unsigned int) * cpus)) == NULL)
     {
-        return 0;
+        systemFatal("Unable to allocate steering table");
     }
-    
-    /* Get the number of bytes to reply with */
-    bytesToWrite = atol(line);
-    
-    /* Ensure that the bytes requested are within our buffers */
-    if ((bytesToWrite <= 0) || (bytesToWrite > NETWORK_BUFFER_SIZE))
+    for (cpu = 0; cpu < cpus; cpu++)
     {
-        systemFatal("Client requested too large a file");
+        indexOfCpu[cpu] = cpu % reactors;
     }
-
-    /* Send the data back to the client */
-    if (sendData(&socket, result, bytesToWrite) == -1)
+    for (index = reactors - 1; index >= 0; index--)
     {
-        systemFatal("Send fail");
+        if (group[index].core >= 0 && group[index].core < cpus)
+        {
+            indexOfCpu[group[index].core] = index;
+        }
     }
-
-    /* Send the communication time to the data collection process */
-    
     
-    return 1;
+    if (steerByCpu(&group[0].listenSocket, indexOfCpu, cpus) == -1)
+    {
+        perror("Unable to steer connections by CPU, using the hash");
+    }
+    free(indexOfCpu);
 }
 
 /*
- -- FUNCTION: initializeServer
+ -- FUNCTION: reactor
  --
- -- DATE: March 12, 2011
+ -- DATE: October 18, 2026
  --
- -- REVISIONS: September 22, 2011 - Added some extra comments about failure and
- -- a function call to set the socket into non blocking mode.
+ -- REVISIONS: October 18, 2026 - Reads and parses every ready socket first,
+ -- then flushes the queued replies.
+ -- October 18, 2026 - Counts its work in the engine statistics.
+ -- October 18, 2026 - Times its waits and counts the accepted connections.
+ -- October 18, 2026 - Takes the listening socket out of epoll while
+ -- admission control has paused accepting, and resets the connections it
+ -- does not admit.
+ -- October 18, 2026 - Keeps a run queue of the connections that used up
+ -- their quantum, and serves it every round ahead of the new events.
+ -- October 18, 2026 - Takes its connections from its handoff queue when
+ -- there is an acceptor thread. Connections are set up by addConnection.
+ -- October 18, 2026 - A connection whose events cannot be changed is closed
+ -- instead of the server.
  --
  -- DESIGNER: Luke Queenan
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: void initializeServer(int *listenSocket, int *port);
+ -- INTERFACE: void *reactor(void *data)
  --
- -- RETURNS: void
+ -- RETURNS: NULL
  --
  -- NOTES:
- -- This function sets up the required server connections, such as creating a
- -- socket, setting the socket to reuse mode, binding it to an address, and
- -- setting it to listen. If an error occurs, the function calls "systemFatal"
- -- with an error message.
+ -- The epoll loop of one reactor. It accepts client connections on its own
+ -- listening socket and calls the process connection function when a socket
+ -- is ready for reading.
+ --
+ -- When spinning, the loop polls without blocking and notes the time of the
+ -- last poll that found work. Once the reactor has gone the spin time without
+ -- work it backs off to a blocking wait, and starts spinning again as soon as
+ -- that wait returns, so an idle server does not burn a core.
+ --
+ -- The events of a wakeup are handled in two passes. The first pass accepts
+ -- and reads, and puts every connection that now owes replies on the flush
+ -- list. The second pass sends them. Client sockets carry their connection
+ -- in the epoll data, the listening socket carries NULL.
+ --
+ -- While admission control has paused accepting, the listening socket is
+ -- taken out of epoll so new connections wait in the backlog, and a blocking
+ -- wait is cut to ADMISSION_RECHECK milliseconds to look again.
+ --
+ -- With a quantum the reactor is a deficit round robin scheduler. Each round
+ -- every connection with input gets the quantum in credit, see
+ -- processConnection. A connection that runs out of credit has input left
+ -- that the edge triggered epoll will not report again, so it goes on the
+ -- run queue. The queue is served at the start of the next round, which does
+ -- not block in epoll while the queue has anything on it. A connection
+ -- reported ready after its turn in a round waits for the next one. A
+ -- connection closed while queued, or closed by the queue before the events
+ -- of the round were seen, is only freed when the queue next reaches it.
+ --
+ -- With an acceptor thread the reactor has no listening socket. Its handoff
+ -- queue's eventfd is in epoll instead, carrying the reactor itself, and when
+ -- it is readable the reactor takes every connection waiting in the queue.
+ -- Admission control is then left to the acceptor.
  */
-void initializeServer(int *listenSocket, int *port)
+void *reactor(void *data)
 {
-    // Create a TCP socket
-    if ((*listenSocket = tcpSocket()) == -1)
+    reactorData *self = (reactorData *)data;
+    register int epoll = 0;
+    register int ready = 0;
+    register int index = 0;
+    int listenSocket = self->listenSocket;
+    int client = 0;
+    int flushes = 0;
+    int listening = 1;
+    int timeout = self->spin ? 0 : -1;
+    int wait = 0;
+    int busyPoll = BUSY_POLL_TIME;
+    unsigned long long now = 0;
+    unsigned long long lastWork = 0;
+    unsigned long long round = 0;
+    pollStats stats;
+    runQueue runs;
+    
+    connection *current = 0;
+    connection *next = 0;
+    connection *last = 0;
+    connection **flushList = 0;
+    engineCounters *engine = 0;
+    
+    struct epoll_event event;
+    struct epoll_event *events = 0;
+    
+    if ((events = malloc(sizeof(struct epoll_event) * MAX_EVENTS)) == NULL ||
+        (flushList = malloc(sizeof(connection *) * MAX_EVENTS * 2)) == NULL)
     {
-        systemFatal("Cannot Create Socket!");
+        systemFatal("Unable to allocate epoll events");
     }
     
-    // Allow the socket to be reused immediately after exit
-    if (setReuse(listenSocket) == -1)
+    if ((engine = engineJoin()) == NULL)
     {
-        systemFatal("Cannot Set Socket To Reuse");
+        systemFatal("Unable to allocate engine statistics");
     }
     
-    // Bind an address to the socket
-    if (bindAddress(port, listenSocket) == -1)
+    /* Set up epoll variables */
+    if ((epoll = epoll_create1(0)) == -1)
     {
-        systemFatal("Cannot Bind Address To Socket");
+        systemFatal("Unable to create epoll object");
     }
     
-    if (makeSocketNonBlocking(listenSocket) == -1)
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    
+    if (self->handoff != NULL)
     {
-        systemFatal("Cannot Make Socket Non-Blocking");
+        /* The acceptor does the listening */
+        listening = 0;
+        event.data.ptr = self;
+        if (epoll_ctl(epoll, EPOLL_CTL_ADD, self->handoff->wakeup,
+                      &event) == -1)
+        {
+            systemFatal("Unable to add the handoff queue to epoll");
+        }
     }
-    
-    // Set the socket to listen for connections
-    if (setListen(listenSocket) == -1)
+    else if (epoll_ctl(epoll, EPOLL_CTL_ADD, listenSocket, &event) == -1)
     {
-        systemFatal("Cannot Listen On Socket");
+        systemFatal("Unable to add listen socket to epoll");
+    }
+    
+    memset(&stats, 0, sizeof(pollStats));
+    memset(&runs, 0, sizeof(runQueue));
+    stats.lastReport = monotonicTime();
+    lastWork = stats.lastReport;
+    
+    while (1)
+    {
+        /* Stop or start accepting as the requests in flight cross the limit */
+        if (self->handoff == NULL && listening == admissionPaused())
+        {
+            listening = !listening;
+            event.events = EPOLLIN;
+            event.data.ptr = NULL;
+            countSyscall(0);
+            if (epoll_ctl(epoll, listening ? EPOLL_CTL_ADD : EPOLL_CTL_DEL,
+                          listenSocket, &event) == -1)
+            {
+                systemFatal("Cannot change the listen socket in epoll");
+            }
+        }
+        
+        /* Only poll while connections are waiting for their turn */
+        wait = timeout;
+        if (runs.head != NULL)
+        {
+            wait = 0;
+        }
+        else if (!listening && timeout == -1 && self->handoff == NULL)
+        {
+            wait = ADMISSION_RECHECK;
+        }
+        
+        /* Wait for epoll to return with the maximum events specified */
+        engineWaiting(engine);
+        ready = epoll_wait(epoll, events, MAX_EVENTS, wait);
+        if (ready == -1)
+        {
+            systemFatal("Epoll wait error");
+        }
+        engineWakeup(engine, ready > 0 || runs.head != NULL);
+        
+        stats.polls++;
+        stats.sleeps += (wait != 0);
+        stats.events += ready;
+        
+        /* Keep spinning while there is work, back off once there is none */
+        now = monotonicTime();
+        if (ready > 0 || runs.head != NULL)
+        {
+            lastWork = now;
+            timeout = self->spin ? 0 : -1;
+        }
+        else if (self->spin)
+        {
+            stats.emptyPolls++;
+            if (now - lastWork > self->spin * 1000ULL)
+            {
+                timeout = -1;
+            }
+        }
+        
+        /* Report in both modes so the cost of spinning can be compared */
+        if (now - stats.lastReport >= POLL_REPORT_INTERVAL)
+        {
+            reportPolling(self, &stats, now);
+        }
+        
+        /* Connections left over from the last round go first, as many as
+         there can be events so the flush list has room for both */
+        round++;
+        flushes = 0;
+        current = runs.head;
+        last = runs.tail;
+        memset(&runs, 0, sizeof(runQueue));
+        for (index = 0; current != NULL && index < MAX_EVENTS;
+             current = next, index++)
+        {
+            next = current->nextRun;
+            current->listed = 0;
+            if (current->closed)
+            {
+                free(current);
+                continue;
+            }
+            current->visited = round;
+            if (processConnection(current, &stats, self->quantum) == 0)
+            {
+                /* This wait may still hold an event for it, so it is kept on
+                 the queue to be freed next round */
+                runLater(&runs, current);
+                closeConnection(current);
+                continue;
+            }
+            if (current->runnable)
+            {
+                runLater(&runs, current);
+            }
+            if ((current->pending > 0 || current->file.total > 0) &&
+                !current->queued)
+            {
+                current->queued = 1;
+                flushList[flushes++] = current;
+            }
+        }
+        
+        /* Those not reached keep their place ahead of the ones just served */
+        if (current != NULL)
+        {
+            last->nextRun = runs.head;
+            runs.head = current;
+            if (runs.tail == NULL)
+            {
+                runs.tail = last;
+            }
+        }
+        
+        /* First pass, accept and read everything that is ready */
+        for (index = 0; index < ready; index++)
+        {
+            if (events[index].data.ptr == NULL)
+            {
+                /* Accept the new connections */
+                while ((client = acceptConnection(&listenSocket)) != -1)
+                {
+                    if (!admitConnection())
+                    {
+                        engine->rejected++;
+                        rejectConnection(client);
+                        continue;
+                    }
+                    addConnection(self, epoll, client, engine, &busyPoll);
+                }
+                continue;
+            }
+            if (events[index].data.ptr == self)
+            {
+                /* Take the connections handed over by the acceptor */
+                countSyscall(0);
+                mpscClearSignal(self->handoff);
+                while (mpscPop(self->handoff, &client))
+                {
+                    addConnection(self, epoll, client, engine, &busyPoll);
+                }
+                continue;
+            }
+            
+            current = events[index].data.ptr;
+            if (current->closed)
+            {
+                continue;
+            }
+            if (events[index].events & ~EPOLLOUT)
+            {
+                if (current->visited == round)
+                {
+                    /* It has had its turn, the new input waits a round */
+                    current->runnable = 1;
+                }
+                else if (processConnection(current, &stats,
+                                           self->quantum) == 0)
+                {
+                    closeConnection(current);
+                    continue;
+                }
+            }
+            if (current->runnable)
+            {
+                runLater(&runs, current);
+            }
+            if ((current->pending > 0 || current->file.total > 0) &&
+                !current->queued)
+            {
+                current->queued = 1;
+                flushList[flushes++] = current;
+            }
+        }
+        
+        /* Second pass, send the replies queued by the first */
+        for (index = 0; index < flushes; index++)
+        {
+            current = flushList[index];
+            current->queued = 0;
+            switch (flushConnection(current, &stats))
+            {
+                case -1:
+                    closeConnection(current);
+                    continue;
+                case 1:
+                    /* The send buffer is full, wait for room */
+                    if (current->watchingOut)
+                    {
+                        continue;
+                    }
+                    event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+                    break;
+                default:
+                    /* A file that has gone lets the input behind it run */
+                    if (current->runnable)
+                    {
+                        runLater(&runs, current);
+                    }
+                    if (!current->watchingOut)
+                    {
+                        continue;
+                    }
+                    event.events = EPOLLIN | EPOLLET;
+                    break;
+            }
+            current->watchingOut = !current->watchingOut;
+            event.data.ptr = current;
+            countSyscall(0);
+            if (epoll_ctl(epoll, EPOLL_CTL_MOD, current->socket, &event) == -1)
+            {
+                engineError(engine, engineErrorType(errno));
+                closeConnection(current);
+            }
+        }
+    }
+    
+    engineLeave(engine);
+    if (listenSocket != -1)
+    {
+        close(listenSocket);
+    }
+    close(epoll);
+    free(flushList);
+    free(events);
+    
+    return NULL;
+}
+
+/*
+ -- FUNCTION: acceptor
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Polls every listening socket, one for each
+ -- listen address.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void *acceptor(void *data)
+ --
+ -- RETURNS: NULL
+ --
+ -- NOTES:
+ -- The accepting thread of -H. It waits in poll on the listening sockets and
+ -- then accepts on each ready one until its backlog is empty, giving each connection admission
+ -- control's verdict and pushing the ones let in onto the queue of the least
+ -- loaded reactor. The reactors it handed connections to are woken once
+ -- every HANDOFF_BATCH connections and once at the end, rather than once a
+ -- connection, and a reactor still busy with the last batch is not woken at
+ -- all, see mpscSignal.
+ --
+ -- A connection that finds its reactor's queue full is reset, as one over
+ -- the admission limits would be. While admission control has paused
+ -- accepting the thread sleeps ADMISSION_RECHECK milliseconds at a time.
+ */
+void *acceptor(void *data)
+{
+    acceptorData *self = (acceptorData *)data;
+    int client = 0;
+    int chosen = 0;
+    int batch = 0;
+    int ready = 0;
+    int paused = 0;
+    int index = 0;
+    engineCounters *engine = 0;
+    struct pollfd descriptors[NETWORK_MAX_ADDRESSES];
+    
+    if ((engine = engineJoin()) == NULL)
+    {
+        systemFatal("Unable to allocate engine statistics");
+    }
+    
+    for (index = 0; index < self->listeners; index++)
+    {
+        descriptors[index].fd = self->listenSockets[index];
+        descriptors[index].events = POLLIN;
+    }
+    
+    while (1)
+    {
+        /* Leave the connections in the backlog while paused */
+        paused = admissionPaused();
+        engineWaiting(engine);
+        countSyscall(0);
+        ready = poll(descriptors, paused ? 0 : self->listeners,
+                     paused ? ADMISSION_RECHECK : -1);
+        if (ready == -1 && errno != EINTR)
+        {
+            systemFatal("Acceptor poll error");
+        }
+        engineWakeup(engine, ready > 0);
+        if (ready <= 0)
+        {
+            continue;
+        }
+        
+        for (index = 0; index < self->listeners; index++)
+        {
+            if (descriptors[index].revents == 0)
+            {
+                continue;
+            }
+            
+            batch = 0;
+            while ((client = acceptConnection(&self->listenSockets[index]))
+                   != -1)
+            {
+                if (!admitConnection())
+                {
+                    engine->rejected++;
+                    rejectConnection(client);
+                    continue;
+                }
+                
+                chosen = leastLoaded(self);
+                if (mpscPush(self->reactorList[chosen].handoff, client) == -1)
+                {
+                    admissionClosed();
+                    engine->rejected++;
+                    rejectConnection(client);
+                    continue;
+                }
+                __sync_add_and_fetch(&self->reactorList[chosen].load, 1);
+                self->touched[chosen] = 1;
+                
+                if (++batch == HANDOFF_BATCH)
+                {
+                    wakeReactors(self);
+                    batch = 0;
+                    if (admissionPaused())
+                    {
+                        break;
+                    }
+                }
+            }
+            wakeReactors(self);
+        }
+    }
+    
+    engineLeave(engine);
+    
+    return NULL;
+}
+
+/*
+ -- FUNCTION: leastLoaded
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int leastLoaded(acceptorData *self)
+ --
+ -- RETURNS: the index of the reactor to hand the next connection to
+ --
+ -- NOTES:
+ -- Picks the reactor with the fewest connections, counting those handed to
+ -- it but not yet taken. The search starts one past the last pick, so
+ -- reactors with the same load take turns.
+ */
+static int leastLoaded(acceptorData *self)
+{
+    int index = 0;
+    int reactor = 0;
+    int chosen = self->next;
+    int least = self->reactorList[chosen].load;
+    
+    for (index = 1; index < self->reactors && least > 0; index++)
+    {
+        reactor = (self->next + index) % self->reactors;
+        if (self->reactorList[reactor].load < least)
+        {
+            chosen = reactor;
+            least = self->reactorList[reactor].load;
+        }
+    }
+    self->next = (chosen + 1) % self->reactors;
+    
+    return chosen;
+}
+
+/*
+ -- FUNCTION: wakeReactors
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void wakeReactors(acceptorData *self)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Signals every reactor handed a connection since the last call.
+ */
+static void wakeReactors(acceptorData *self)
+{
+    int index = 0;
+    
+    for (index = 0; index < self->reactors; index++)
+    {
+        if (!self->touched[index])
+        {
+            continue;
+        }
+        self->touched[index] = 0;
+        switch (mpscSignal(self->reactorList[index].handoff))
+        {
+            case -1:
+                systemFatal("Unable to wake a reactor");
+                break;
+            case 1:
+                countSyscall(0);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/*
+ -- FUNCTION: addConnection
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void addConnection(reactorData *self, int epoll,
+ --                                      int client, engineCounters *engine,
+ --                                      int *busyPoll)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Makes a connection for a client socket the reactor has accepted or been
+ -- handed, and adds it to the reactor's epoll object edge triggered. Busy
+ -- polling is turned off for the rest of the reactor's connections the
+ -- first time the socket option fails. A handed over connection counts
+ -- towards its reactor's load until it is closed. A socket that cannot be
+ -- made non-blocking or added to epoll is counted as an error and closed,
+ -- the reactor carries on.
+ */
+static void addConnection(reactorData *self, int epoll, int client,
+                          engineCounters *engine, int *busyPoll)
+{
+    connection *current = 0;
+    struct epoll_event event;
+    
+    if ((current = calloc(1, sizeof(connection))) == NULL)
+    {
+        systemFatal("Unable to allocate connection");
+    }
+    current->socket = client;
+    current->engine = engine;
+    if (self->handoff != NULL)
+    {
+        current->load = &self->load;
+    }
+    engine->accepts++;
+    displayClientData(__sync_add_and_fetch(&connections, 1));
+    
+    if (self->spin && *busyPoll && setBusyPoll(&client, *busyPoll) == -1)
+    {
+        perror("SO_BUSY_POLL not available, not using it");
+        *busyPoll = 0;
+    }
+    current->trace = traceConnection();
+    TRACE(current->trace, TRACE_ACCEPTED);
+    event.events = EPOLLIN | EPOLLET;
+    event.data.ptr = current;
+    if (makeSocketNonBlocking(&client) == -1 ||
+        epoll_ctl(epoll, EPOLL_CTL_ADD, client, &event) == -1)
+    {
+        /* Only this connection is lost */
+        engineError(engine, engineErrorType(errno));
+        closeConnection(current);
+    }
+}
+
+/*
+ -- FUNCTION: monotonicTime
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static unsigned long long monotonicTime()
+ --
+ -- RETURNS: the monotonic clock in nanoseconds
+ --
+ -- NOTES:
+ -- Reads the monotonic clock, which does not enter the kernel.
+ */
+static unsigned long long monotonicTime()
+{
+    struct timespec now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/*
+ -- FUNCTION: reportPolling
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Also reports the reads and sends per event.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void reportPolling(reactorData *self, pollStats *stats,
+ --                                      unsigned long long now)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Prints what busy polling is costing the reactor since the last report: the
+ -- share of a core it used, the share of polls that found nothing, how often
+ -- it fell back to sleeping and the CPU time it spent per event. The counters
+ -- are then reset.
+ */
+static void reportPolling(reactorData *self, pollStats *stats,
+                          unsigned long long now)
+{
+    struct timespec cpu;
+    unsigned long long cpuTime = 0;
+    unsigned long long used = 0;
+    
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+    cpuTime = cpu.tv_sec * 1000000000ULL + cpu.tv_nsec;
+    used = cpuTime - stats->lastCpu;
+    
+    printf("Reactor %d: cpu %.1f%%, %llu polls, %.1f%% empty, %llu sleeps, "
+           "%llu events, %.2fus cpu per event, %.2f reads and %.2f sends per "
+           "event\n", self->index, used * 100.0 / (now - stats->lastReport),
+           stats->polls,
+           stats->polls ? stats->emptyPolls * 100.0 / stats->polls : 0,
+           stats->sleeps, stats->events,
+           stats->events ? used / 1000.0 / stats->events : 0,
+           stats->events ? (double)stats->reads / stats->events : 0,
+           stats->events ? (double)stats->sends / stats->events : 0);
+    fflush(stdout);
+    
+    memset(stats, 0, sizeof(pollStats));
+    stats->lastReport = now;
+    stats->lastCpu = cpuTime;
+}
+
+/*
+ -- FUNCTION: processConnection
+ --
+ -- DATE: Feb 20, 2011
+ --
+ -- REVISIONS: October 18, 2026 - Requests that start with a slash are
+ -- served from the document root.
+ -- October 18, 2026 - Reads everything waiting on the socket and queues the
+ -- replies instead of sending them, they are sent by flushConnection.
+ -- October 18, 2026 - Counts the requests in the engine statistics.
+ -- October 18, 2026 - Records trace events for traced connections.
+ -- October 18, 2026 - Notes when the replies owed started waiting, for the
+ -- latency histogram.
+ -- October 18, 2026 - Counts the queued replies as in flight for admission
+ -- control.
+ -- October 18, 2026 - Stops once the connection has used its quantum, and
+ -- parses what is left in the buffer before reading again.
+ -- October 18, 2026 - Parses the requests a batch at a time, see
+ -- requestParser.c, and closes the connection on a malformed one instead of
+ -- exiting.
+ -- October 18, 2026 - Counts the errors it closes the connection on.
+ -- October 18, 2026 - Starts a file reply for flushConnection to send
+ -- instead of sending it here, and leaves the input alone until it has gone.
+ -- October 18, 2026 - No longer waits in poll for the replies before a file
+ -- to be sent, flushConnection sends them first.
+ -- October 18, 2026 - A connection still in debt after its quantum is added
+ -- is not served that round.
+ -- October 18, 2026 - A malformed line closes the connection once the
+ -- replies to the lines before it have been sent.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int processConnection(connection *client, pollStats *stats,
+ --                                  long quantum)
+ --
+ -- RETURNS: 1 on success, 0 if the connection should be closed
+ --
+ -- NOTES:
+ -- Service a client socket by reading all of the requests waiting on it. The
+ -- socket is edge triggered, so it is read until it would block. The
+ -- complete lines in the buffer are parsed together, each adding its byte
+ -- count to the replies owed, and a partial line is kept for the next read.
+ -- A buffer filled without a new line closes the connection. So does a line
+ -- that is not a size in bounds, after the replies to the lines before it
+ -- have been flushed, see flushConnection. A file request starts a file reply, which
+ -- flushConnection sends after the replies before it as the socket has room.
+ -- The lines behind it wait in the buffer until it has all gone.
+ --
+ -- With a quantum the connection is given that many bytes of credit, and
+ -- each reply queued takes its length from it, a file counting as one
+ -- buffer. Once the credit is gone the rest of the input is left where it
+ -- is, in the buffer or the socket, and the connection is marked runnable
+ -- for the reactor to come back to. Credit left when the socket would block
+ -- is dropped. A reply can overdraw the credit, and a connection whose new
+ -- quantum does not cover the debt stays on the run queue unserved until
+ -- later rounds have paid it off.
+ --
+ -- Requests are timed from the wakeup that read them. Requests read while
+ -- earlier replies are still owed are timed from when those were read, since
+ -- they are all answered by the same flush.
+ */
+int processConnection(connection *client, pollStats *stats, long quantum)
+{
+    int bytesRead = 0;
+    int count = 0;
+    int index = 0;
+    char *line = 0;
+    char *start = 0;
+    requestBatch batch;
+    
+    /* Nothing more is taken until the file being sent has gone, or at all
+     once a malformed line has been found */
+    if (client->file.total > 0 || client->closing)
+    {
+        return 1;
+    }
+    
+    TRACE(client->trace, TRACE_READABLE);
+    if (client->answering == 0)
+    {
+        client->readyAt = client->engine->wokeAt;
+    }
+    client->deficit += quantum;
+    client->runnable = 0;
+    
+    /* Still paying off a reply that overdrew its credit, wait a round */
+    if (quantum != 0 && client->deficit <= 0)
+    {
+        client->runnable = 1;
+        return 1;
+    }
+    
+    while (1)
+    {
+        /* Take every complete line, a batch at a time */
+        line = client->input;
+        while (!client->runnable)
+        {
+            start = line;
+            count = parseRequests(start, client->input + client->length - start,
+                                  NETWORK_BUFFER_SIZE, &batch);
+            for (index = 0; index < count && !client->runnable; index++)
+            {
+                TRACE(client->trace, TRACE_PARSED);
+                client->pending += batch.sizes[index];
+                TRACE(client->trace, TRACE_QUEUED);
+                
+                /* Out of credit, leave the rest for the next round */
+                if (quantum != 0)
+                {
+                    client->deficit -= batch.sizes[index];
+                    client->runnable = (client->deficit <= 0);
+                }
+            }
+            if (index > 0)
+            {
+                client->answering += index;
+                client->engine->requests += index;
+                admissionBegin(index);
+                line = start + batch.ends[index - 1];
+            }
+            if (client->runnable)
+            {
+                break;
+            }
+            
+            /* Answer the lines before a malformed one, then close */
+            if (batch.malformed)
+            {
+                engineError(client->engine, ENGINE_ERROR_MALFORMED);
+                if (client->pending == 0)
+                {
+                    return 0;
+                }
+                client->closing = 1;
+                return 1;
+            }
+            
+            if (batch.fileEnd == 0)
+            {
+                /* A full buffer without a new line is no request at all */
+                if (count == 0 && line == client->input &&
+                    client->length == NETWORK_BUFFER_SIZE - 1)
+                {
+                    engineError(client->engine, ENGINE_ERROR_MALFORMED);
+                    return 0;
+                }
+                if (count < REQUEST_BATCH)
+                {
+                    break;
+                }
+                continue;
+            }
+            
+            /* Start the file asked for after the replies before it */
+            start[batch.fileEnd - 1] = '\0';
+            TRACE(client->trace, TRACE_PARSED);
+            startFile(&client->file, line);
+            line = start + batch.fileEnd;
+            if (quantum != 0)
+            {
+                client->deficit -= NETWORK_BUFFER_SIZE;
+            }
+            break;
+        }
+        
+        /* Keep the partial line, or the lines not yet taken */
+        client->length -= line - client->input;
+        memmove(client->input, line, client->length);
+        client->input[client->length] = '\0';
+        if (client->runnable || client->file.total > 0)
+        {
+            return 1;
+        }
+        
+        /* Read the requests from the client */
+        bytesRead = readAvailable(&client->socket,
+                                  client->input + client->length,
+                                  NETWORK_BUFFER_SIZE - 1 - client->length);
+        stats->reads++;
+        if (bytesRead == -1 && errno == EAGAIN)
+        {
+            if (client->deficit > 0)
+            {
+                client->deficit = 0;
+            }
+            return 1;
+        }
+        if (bytesRead <= 0)
+        {
+            if (bytesRead == -1)
+            {
+                engineError(client->engine, engineErrorType(errno));
+            }
+            return 0;
+        }
+        client->length += bytesRead;
+        client->input[client->length] = '\0';
+    }
+}
+
+/*
+ -- FUNCTION: flushConnection
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Counts the bytes sent and the latency of
+ -- the requests answered.
+ -- October 18, 2026 - Hands the requests answered to admission control.
+ -- October 18, 2026 - Counts a failed send as a connection error.
+ -- October 18, 2026 - Sends the file reply started by processConnection
+ -- after the replies before it.
+ -- October 18, 2026 - Fails once the replies of a connection that sent a
+ -- malformed line have gone, so the reactor closes it.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int flushConnection(connection *client, pollStats *stats)
+ --
+ -- RETURNS: 0 when every reply has been sent, 1 if the send buffer filled
+ --          first, -1 on failure
+ --
+ -- NOTES:
+ -- Sends the replies owed to the client. The replies are all the same byte,
+ -- so they are sent back to back as a list of buffers in one sendmsg, as
+ -- many as fit in FLUSH_PARTS. The last of them going out is traced as the
+ -- replies being sent, and every request answered is given the same latency.
+ --
+ -- A file reply goes out next, as much of it as the socket takes. Once it has
+ -- all gone the connection is marked runnable, so the reactor goes back to
+ -- the input that was left behind it. A connection that is closing gives -1
+ -- once everything owed has been sent.
+ */
+int flushConnection(connection *client, pollStats *stats)
+{
+    int count = 0;
+    ssize_t sent = 0;
+    unsigned long long remaining = 0;
+    struct iovec parts[FLUSH_PARTS];
+    struct msghdr message;
+    
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = parts;
+    
+    while (client->pending > 0)
+    {
+        remaining = client->pending;
+        for (count = 0; count < FLUSH_PARTS && remaining > 0; count++)
+        {
+            parts[count].iov_base = replyData;
+            parts[count].iov_len = (remaining > NETWORK_BUFFER_SIZE) ?
+                                   NETWORK_BUFFER_SIZE : remaining;
+            remaining -= parts[count].iov_len;
+        }
+        message.msg_iovlen = count;
+        
+        sent = sendmsg(client->socket, &message, MSG_NOSIGNAL);
+        countSent(sent);
+        stats->sends++;
+        if (sent > 0)
+        {
+            client->pending -= sent;
+            if (client->pending == 0)
+            {
+                TRACE(client->trace, TRACE_SENT);
+                admissionDone(client->answering,
+                              timingNow() - client->readyAt);
+                engineLatency(client->engine, timingNow() - client->readyAt,
+                              client->answering);
+                client->answering = 0;
+            }
+        }
+        else if (sent == -1 && errno == EAGAIN)
+        {
+            return 1;
+        }
+        else if (sent == 0 || errno != EINTR)
+        {
+            engineError(client->engine, engineErrorType(errno));
+            return -1;
+        }
+    }
+    
+    if (client->file.total > 0)
+    {
+        stats->sends++;
+        switch (sendFile(&client->socket, &client->file))
+        {
+            case -1:
+                engineError(client->engine, engineErrorType(errno));
+                return -1;
+            case 1:
+                return 1;
+            default:
+                break;
+        }
+        TRACE(client->trace, TRACE_SENT);
+        admissionDone(0, timingNow() - client->readyAt);
+        engineLatency(client->engine, timingNow() - client->readyAt, 1);
+        client->engine->requests++;
+        client->runnable = 1;
+    }
+    
+    return client->closing ? -1 : 0;
+}
+
+/*
+ -- FUNCTION: closeConnection
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Counts the closed connection.
+ -- October 18, 2026 - Gives back the connection and any replies it was
+ -- still owed to admission control.
+ -- October 18, 2026 - A connection on the run queue is freed by the reactor
+ -- when the queue reaches it.
+ -- October 18, 2026 - Takes the connection off its reactor's load.
+ -- October 18, 2026 - Gives back the file it was being sent.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void closeConnection(connection *client)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Closes the client socket, which also takes it out of epoll, and frees the
+ -- connection.
+ */
+static void closeConnection(connection *client)
+{
+    client->engine->closes++;
+    if (client->answering > 0)
+    {
+        admissionDone(client->answering, timingNow() - client->readyAt);
+    }
+    admissionClosed();
+    if (client->load != NULL)
+    {
+        __sync_sub_and_fetch(client->load, 1);
+    }
+    endFile(&client->file);
+    close(client->socket);
+    if (client->listed)
+    {
+        client->closed = 1;
+    }
+    else
+    {
+        free(client);
+    }
+    displayClientData(__sync_sub_and_fetch(&connections, 1));
+}
+
+/*
+ -- FUNCTION: runLater
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void runLater(runQueue *queue, connection *client)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Puts a connection at the back of the run queue, unless it is on it
+ -- already.
+ */
+static void runLater(runQueue *queue, connection *client)
+{
+    if (client->listed)
+    {
+        return;
+    }
+    
+    client->listed = 1;
+    client->nextRun = NULL;
+    if (queue->tail != NULL)
+    {
+        queue->tail->nextRun = client;
+    }
+    else
+    {
+        queue->head = client;
+    }
+    queue->tail = client;
+}
+
+/*
+ -- FUNCTION: initializeServer
+ --
+ -- DATE: March 12, 2011
+ --
+ -- REVISIONS: September 22, 2011 - Added some extra comments about failure and
+ -- a function call to set the socket into non blocking mode.
+ -- October 18, 2026 - Added the option to share the port between reactors.
+ -- October 18, 2026 - Makes a UNIX domain socket when serving a path.
+ -- October 18, 2026 - Binds to the given address, if there is one.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void initializeServer(int *listenSocket, int *port,
+ --                                  int reusePort,
+ --                                  const networkAddress *address);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- This function sets up the required server connections, such as creating a
+ -- socket, setting the socket to reuse mode, binding it to an address, and
+ -- setting it to listen. If an error occurs, the function calls "systemFatal"
+ -- with an error message.
+ */
+void initializeServer(int *listenSocket, int *port, int reusePort,
+                      const networkAddress *address)
+{
+    // Create a TCP socket for the address, or a UNIX domain one when serving
+    // a path
+    *listenSocket = (address != NULL) ? addressSocket(address) : streamSocket();
+    if (*listenSocket == -1)
+    {
+        systemFatal("Cannot Create Socket!");
+    }
+    
+    // Allow the socket to be reused immediately after exit
+    if (setReuse(listenSocket) == -1)
+    {
+        systemFatal("Cannot Set Socket To Reuse");
+    }
+    
+    // Share the port with the other reactors
+    if (reusePort && setReusePort(listenSocket) == -1)
+    {
+        systemFatal("Cannot Set Socket To Reuse Port");
+    }
+    
+    // Bind an address to the socket
+    if ((address != NULL ? bindAddressTo(address, port, listenSocket) :
+         bindAddress(port, listenSocket)) == -1)
+    {
+        systemFatal("Cannot Bind Address To Socket");
+    }
+    
+    if (makeSocketNonBlocking(listenSocket) == -1)
+    {
+        systemFatal("Cannot Make Socket Non-Blocking");
+    }
+    
+    // Set the socket to listen for connections
+    if (setListen(listenSocket) == -1)
+    {
+        systemFatal("Cannot Listen On Socket");
+    }
+}
+
+void displayClientData(unsigned long long clients)
+{
+    char cache[NETWORK_BUFFER_SIZE];
+    
+    printf("Connected clients: %llu\n", clients);
+    if (describeFileCache(cache, sizeof(cache)) > 0)
+    {
+        printf("File cache: %s\n", cache);
     }
-}
-
-void displayClientData(unsigned long long clients)
-{
-    printf("Connected clients: %llu\n", clients);
 }
 
 /*
@@ -0,0 +1,698 @@
+/*
+ -- SOURCE FILE: fileServe.c
+ --
+ -- PROGRAM: Web Client Emulator
+ --
+ -- FUNCTIONS:
+ -- int openDocumentRoot(const char *path, unsigned int entries,
+ --                      size_t bytes);
+ -- int isFileRequest(const char *request);
+ -- int serveFile(int *socket, const char *request);
+ -- void startFile(fileReply *reply, const char *request);
+ -- int sendFile(int *socket, fileReply *reply);
+ -- void endFile(fileReply *reply);
+ -- int describeFileCache(char *text, size_t length);
+ -- static int openBeneathRoot(const char *name);
+ -- static int sendMappedFile(int socket, fileReply *reply);
+ -- static int sendFileData(int socket, fileReply *reply);
+ -- static int spliceFileData(int socket, fileReply *reply);
+ -- static int waitWritable(int socket);
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Replaced the direct mapped file cache with
+ -- the sharded LRU cache in contentCache.c, and small files are now sent
+ -- straight from their mapping.
+ -- October 18, 2026 - The system calls made here are counted for the calling
+ -- thread, see setNetworkCounters.
+ -- October 18, 2026 - Sends are counted with countSent.
+ -- October 18, 2026 - A file reply keeps its progress in a fileReply, so the
+ -- event driven servers go back to their loop when the socket fills instead
+ -- of waiting in poll.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- NOTES:
+ -- This file lets the servers serve files from a document root, the way a web
+ -- server serves static content. A request that starts with a slash names a
+ -- file under the root instead of a number of bytes:
+ --
+ --     /index.html\n
+ --
+ -- and the reply is the size of the file on a line of its own followed by
+ -- its contents, or -1 on its own if the file cannot be served.
+ --
+ -- Opened files are kept in the content cache keyed by name, so hot files are
+ -- not opened and looked up on every request. Files up to FILE_MAP_LIMIT are
+ -- mapped by the cache and sent with the size in a single writev, so a hot
+ -- small file costs one system call. Bigger files go from the page cache to
+ -- the socket with sendfile, so they are never copied into user space. If
+ -- sendfile cannot be used for a file the data is spliced through a pipe
+ -- instead, which is also copy free. Files are opened with
+ -- RESOLVE_BENEATH so a request cannot escape the root through "..", an
+ -- absolute path or a symbolic link.
+ --
+ -- A server with non blocking sockets starts a reply with startFile and
+ -- calls sendFile each time the socket has room, until it is done. The
+ -- fileReply holds the file, the header and how far the reply has got, so
+ -- one client that stops reading only holds up its own connection. A
+ -- connection closed part way through gives the file back with endFile.
+ -- serveFile sends a whole reply on a blocking socket.
+ */
+
+// Includes
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <linux/openat2.h>
+
+#include "contentCache.h"
+#include "fileServe.h"
+#include "network.h"
+
+/* Most bytes moved by one splice call */
+#define SPLICE_CHUNK 65536
+
+static int openBeneathRoot(const char *name);
+static int sendMappedFile(int socket, fileReply *reply);
+static int sendFileData(int socket, fileReply *reply);
+static int spliceFileData(int socket, fileReply *reply);
+static int waitWritable(int socket);
+
+/* The document root that files are opened under */
+static int rootFd = -1;
+
+/*
+ -- FUNCTION: openDocumentRoot
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Takes the entry and byte limits of the file
+ -- cache.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int openDocumentRoot(const char *path, unsigned int entries,
+ --                                 size_t bytes);
+ --
+ -- RETURNS: 0 on success, -1 on failure
+ --
+ -- NOTES:
+ -- Opens the directory that file requests are served from and sets up the
+ -- cache of files opened under it.
+ */
+int openDocumentRoot(const char *path, unsigned int entries, size_t bytes)
+{
+    if ((rootFd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1)
+    {
+        return -1;
+    }
+    
+    if (contentCacheInit(openBeneathRoot, entries, bytes,
+                         FILE_MAP_LIMIT) == -1)
+    {
+        close(rootFd);
+        rootFd = -1;
+        return -1;
+    }
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: isFileRequest
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int isFileRequest(const char *request);
+ --
+ -- RETURNS: 1 if the request names a file and files are being served
+ --
+ -- NOTES:
+ -- Tells a file request apart from a request for a number of bytes.
+ */
+int isFileRequest(const char *request)
+{
+    return rootFd != -1 && request[0] == '/';
+}
+
+/*
+ -- FUNCTION: serveFile
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Mapped files are sent with their size in one
+ -- writev.
+ -- October 18, 2026 - Sends the reply with startFile and sendFile. Only
+ -- for blocking sockets now, event driven servers keep a fileReply.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int serveFile(int *socket, const char *request);
+ --
+ -- RETURNS: 0 if a reply was sent, -1 if the socket failed
+ --
+ -- NOTES:
+ -- Sends the file named by the request, a NUL terminated line that starts
+ -- with a slash, with its size in front, and returns once it has all gone.
+ -- This is for the thread server, whose sockets block. Anything else that
+ -- makes the socket fill up is waited for in poll, which holds up only the
+ -- calling thread.
+ */
+int serveFile(int *socket, const char *request)
+{
+    int result = 0;
+    fileReply reply;
+    
+    startFile(&reply, request);
+    while ((result = sendFile(socket, &reply)) == 1)
+    {
+        if (waitWritable(*socket) == -1)
+        {
+            endFile(&reply);
+            return -1;
+        }
+    }
+    
+    return result;
+}
+
+/*
+ -- FUNCTION: startFile
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void startFile(fileReply *reply, const char *request);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Gets a reply ready for the file named by the request, a NUL terminated
+ -- line that starts with a slash. A file that does not exist or is not a
+ -- regular file gets a reply of -1 on its own. Nothing is sent, see
+ -- sendFile.
+ */
+void startFile(fileReply *reply, const char *request)
+{
+    int length = 0;
+    char name[FILE_NAME_SIZE];
+    cacheEntry *file = 0;
+    
+    /* Strip the leading slashes and the line ending */
+    while (*request == '/')
+    {
+        request++;
+    }
+    length = strcspn(request, "\r\n");
+    if (length > 0 && length < FILE_NAME_SIZE)
+    {
+        memcpy(name, request, length);
+        name[length] = '\0';
+        file = contentCacheAcquire(name);
+    }
+    
+    memset(reply, 0, sizeof(fileReply));
+    reply->file = file;
+    reply->pipes[0] = -1;
+    reply->pipes[1] = -1;
+    if (file == NULL)
+    {
+        reply->headerLength = snprintf(reply->header, sizeof(reply->header),
+                                       "-1\n");
+        reply->total = reply->headerLength;
+    }
+    else
+    {
+        reply->headerLength = snprintf(reply->header, sizeof(reply->header),
+                                       "%lld\n", (long long)file->size);
+        reply->total = reply->headerLength + file->size;
+    }
+}
+
+/*
+ -- FUNCTION: sendFile
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int sendFile(int *socket, fileReply *reply);
+ --
+ -- RETURNS: 0 when the reply has all been sent, 1 if the send buffer filled
+ --          first, -1 on failure
+ --
+ -- NOTES:
+ -- Sends as much of a reply started with startFile as the socket takes. On
+ -- 1 the caller waits for the socket to be writable and calls this again,
+ -- otherwise the reply is over and its file has been given back. Mapped
+ -- files go out with their size in one sendmsg, others have the size sent
+ -- with MSG_MORE so it shares a segment with the start of the file.
+ */
+int sendFile(int *socket, fileReply *reply)
+{
+    int result = 0;
+    
+    if (reply->file == NULL || reply->file->map != NULL)
+    {
+        result = sendMappedFile(*socket, reply);
+    }
+    else
+    {
+        result = sendFileData(*socket, reply);
+    }
+    
+    if (result != 1)
+    {
+        endFile(reply);
+    }
+    
+    return result;
+}
+
+/*
+ -- FUNCTION: endFile
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void endFile(fileReply *reply);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Gives back the file of a reply and its pipe, if it was being spliced, and
+ -- leaves the reply idle. Does nothing to a reply that is already idle, or
+ -- was zeroed and never started, so a server can call it on every
+ -- connection it closes.
+ */
+void endFile(fileReply *reply)
+{
+    if (reply->total == 0)
+    {
+        return;
+    }
+    
+    if (reply->file != NULL)
+    {
+        contentCacheRelease(reply->file);
+        reply->file = NULL;
+    }
+    if (reply->pipes[0] != -1)
+    {
+        close(reply->pipes[0]);
+        close(reply->pipes[1]);
+        reply->pipes[0] = -1;
+        reply->pipes[1] = -1;
+    }
+    reply->total = 0;
+}
+
+/*
+ -- FUNCTION: describeFileCache
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int describeFileCache(char *text, size_t length);
+ --
+ -- RETURNS: the length of the description, or 0 if no files are being served
+ --
+ -- NOTES:
+ -- Writes the file cache counters as a single line for the servers to print.
+ */
+int describeFileCache(char *text, size_t length)
+{
+    contentCacheStats stats;
+    unsigned long long lookups = 0;
+    
+    if (rootFd == -1)
+    {
+        return 0;
+    }
+    
+    contentCacheStatistics(&stats);
+    lookups = stats.hits + stats.misses;
+    
+    return snprintf(text, length, "%llu hits, %llu misses (%.1f%% hit), "
+                    "%llu evictions, %llu files, %.1f MB mapped", stats.hits,
+                    stats.misses, lookups ? stats.hits * 100.0 / lookups : 0,
+                    stats.evictions, stats.entries, stats.bytes / 1048576.0);
+}
+
+/*
+ -- FUNCTION: openBeneathRoot
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int openBeneathRoot(const char *name);
+ --
+ -- RETURNS: the file descriptor, or -1 on failure
+ --
+ -- NOTES:
+ -- Opens the file for reading without letting the name resolve to anything
+ -- outside the document root. Kernels without openat2 get a plain openat, and
+ -- names with a ".." in them are turned away.
+ */
+static int openBeneathRoot(const char *name)
+{
+    int fd = 0;
+    const char *part = 0;
+    struct open_how how;
+    
+    memset(&how, 0, sizeof(how));
+    how.flags = O_RDONLY | O_CLOEXEC;
+    how.resolve = RESOLVE_BENEATH;
+    
+    fd = syscall(SYS_openat2, rootFd, name, &how, sizeof(how));
+    if (fd != -1 || errno != ENOSYS)
+    {
+        return fd;
+    }
+    
+    for (part = name; part != NULL; part = strchr(part, '/'))
+    {
+        part += (*part == '/');
+        if (strncmp(part, "..", 2) == 0 && (part[2] == '/' || part[2] == '\0'))
+        {
+            errno = EACCES;
+            return -1;
+        }
+    }
+    
+    return openat(rootFd, name, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+}
+
+/*
+ -- FUNCTION: sendMappedFile
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Picks up from the reply's progress and
+ -- returns when the socket fills instead of waiting.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int sendMappedFile(int socket, fileReply *reply);
+ --
+ -- RETURNS: 0 on success, 1 if the send buffer filled, -1 on failure
+ --
+ -- NOTES:
+ -- Sends what is left of the header and the mapped contents of the file
+ -- together with sendmsg. Also sends the -1 of a reply with no file.
+ */
+static int sendMappedFile(int socket, fileReply *reply)
+{
+    int count = 0;
+    ssize_t sent = 0;
+    size_t done = 0;
+    struct iovec parts[2];
+    struct msghdr message;
+    
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = parts;
+    
+    while (reply->sent < reply->total)
+    {
+        count = 0;
+        if (reply->sent < reply->headerLength)
+        {
+            parts[count].iov_base = reply->header + reply->sent;
+            parts[count].iov_len = reply->headerLength - reply->sent;
+            count++;
+        }
+        if (reply->file != NULL)
+        {
+            done = (reply->sent > reply->headerLength) ?
+                   reply->sent - reply->headerLength : 0;
+            parts[count].iov_base = (char *)reply->file->map + done;
+            parts[count].iov_len = reply->file->size - done;
+            count++;
+        }
+        message.msg_iovlen = count;
+        
+        sent = sendmsg(socket, &message, MSG_NOSIGNAL);
+        countSent(sent);
+        if (sent > 0)
+        {
+            reply->sent += sent;
+        }
+        else if (sent == -1 && errno == EAGAIN)
+        {
+            return 1;
+        }
+        else if (sent == 0 || errno != EINTR)
+        {
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: sendFileData
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Sends the header as well, picks up from the
+ -- reply's progress and returns when the socket fills instead of waiting.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int sendFileData(int socket, fileReply *reply);
+ --
+ -- RETURNS: 0 on success, 1 if the send buffer filled, -1 on failure
+ --
+ -- NOTES:
+ -- Sends what is left of the header, then the file with sendfile. The offset
+ -- is kept in the reply rather than in the file, so any number of requests
+ -- can send the same descriptor at once. If the file system does not support
+ -- sendfile the rest is spliced instead.
+ */
+static int sendFileData(int socket, fileReply *reply)
+{
+    ssize_t sent = 0;
+    off_t offset = 0;
+    
+    while (reply->sent < reply->headerLength)
+    {
+        sent = send(socket, reply->header + reply->sent,
+                    reply->headerLength - reply->sent, MSG_MORE | MSG_NOSIGNAL);
+        countSent(sent);
+        if (sent > 0)
+        {
+            reply->sent += sent;
+        }
+        else if (sent == -1 && errno == EAGAIN)
+        {
+            return 1;
+        }
+        else if (sent == 0 || errno != EINTR)
+        {
+            return -1;
+        }
+    }
+    
+    if (reply->pipes[0] != -1)
+    {
+        return spliceFileData(socket, reply);
+    }
+    
+    while (reply->sent < reply->total)
+    {
+        offset = reply->sent - reply->headerLength;
+        sent = sendfile(socket, reply->file->fd, &offset,
+                        reply->total - reply->sent);
+        countSent(sent);
+        if (sent > 0)
+        {
+            reply->sent += sent;
+            continue;
+        }
+        if (sent == 0)
+        {
+            /* The file shrank since it was opened */
+            return -1;
+        }
+        if (errno == EAGAIN)
+        {
+            return 1;
+        }
+        else if (errno == EINVAL || errno == ENOSYS)
+        {
+            if (pipe2(reply->pipes, O_CLOEXEC) == -1)
+            {
+                reply->pipes[0] = -1;
+                reply->pipes[1] = -1;
+                return -1;
+            }
+            return spliceFileData(socket, reply);
+        }
+        else if (errno != EINTR)
+        {
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: spliceFileData
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - The pipe and what is still in it are kept
+ -- in the reply, so it can return when the socket fills instead of waiting.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int spliceFileData(int socket, fileReply *reply);
+ --
+ -- RETURNS: 0 on success, 1 if the send buffer filled, -1 on failure
+ --
+ -- NOTES:
+ -- Sends the rest of the file by splicing it into the reply's pipe and from
+ -- the pipe into the socket. The pages are moved by reference, not copied.
+ -- Bytes already in the pipe when the socket filled go out first next time.
+ */
+static int spliceFileData(int socket, fileReply *reply)
+{
+    ssize_t filled = 0;
+    ssize_t drained = 0;
+    size_t chunk = 0;
+    off_t offset = 0;
+    
+    while (reply->sent < reply->total)
+    {
+        if (reply->piped == 0)
+        {
+            offset = reply->sent - reply->headerLength;
+            chunk = reply->total - reply->sent;
+            if (chunk > SPLICE_CHUNK)
+            {
+                chunk = SPLICE_CHUNK;
+            }
+            
+            filled = splice(reply->file->fd, &offset, reply->pipes[1], NULL,
+                            chunk, SPLICE_F_MOVE | SPLICE_F_MORE);
+            countSyscall(0);
+            if (filled <= 0)
+            {
+                return -1;
+            }
+            reply->piped = filled;
+        }
+        
+        drained = splice(reply->pipes[0], NULL, socket, NULL, reply->piped,
+                         SPLICE_F_MOVE | SPLICE_F_MORE);
+        countSent(drained);
+        if (drained > 0)
+        {
+            reply->piped -= drained;
+            reply->sent += drained;
+        }
+        else if (drained == -1 && errno == EAGAIN)
+        {
+            return 1;
+        }
+        else if (drained == 0 || errno != EINTR)
+        {
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: waitWritable
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int waitWritable(int socket);
+ --
+ -- RETURNS: 0 once the socket can be written, -1 on failure
+ --
+ -- NOTES:
+ -- Blocks until the socket has room in its send buffer again. Only serveFile
+ -- waits here, on a thread of its own.
+ */
+static int waitWritable(int socket)
+{
+    struct pollfd descriptor;
+    
+    descriptor.fd = socket;
+    descriptor.events = POLLOUT;
+    
+    countSyscall(0);
+    while (poll(&descriptor, 1, -1) == -1)
+    {
+        if (errno != EINTR)
+        {
+            return -1;
+        }
+    }
+    
+    return (descriptor.revents & (POLLERR | POLLHUP)) ? -1 : 0;
+}
@@ -0,0 +1,41 @@
+#ifndef FILE_SERVE_H
+#define FILE_SERVE_H
+
+#include <stddef.h>
+
+/* Defines */
+#define FILE_CACHE_ENTRIES 1024
+#define FILE_CACHE_MEGABYTES 256
+#define FILE_MAP_LIMIT (1024 * 1024)
+#define FILE_NAME_SIZE 256
+
+struct cacheEntry;
+
+/* A file reply part way out on a non blocking socket, idle while total is 0 */
+typedef struct
+{
+    struct cacheEntry *file;
+    char header[32];
+    size_t headerLength;
+    size_t total;
+    size_t sent;
+    size_t piped;
+    int pipes[2];
+} fileReply;
+
+/* Function Prototypes */
+#ifdef __cplusplus
+extern "C" {
+#endif
+    int openDocumentRoot(const char *path, unsigned int entries,
+                         size_t bytes);
+    int isFileRequest(const char *request);
+    int serveFile(int *socket, const char *request);
+    void startFile(fileReply *reply, const char *request);
+    int sendFile(int *socket, fileReply *reply);
+    void endFile(fileReply *reply);
+    int describeFileCache(char *text, size_t length);
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,273 @@
+/*
+ -- SOURCE FILE: histogram.c
+ --
+ -- PROGRAM: Web Client Emulator
+ --
+ -- FUNCTIONS:
+ -- void histogramRecord(histogram *table, unsigned long long value);
+ -- void histogramMerge(histogram *destination, const histogram *source);
+ -- void histogramSubtract(histogram *destination, const histogram *later,
+ --                        const histogram *earlier);
+ -- unsigned int histogramBucket(unsigned long long value);
+ -- unsigned long long histogramBucketValue(unsigned int bucket);
+ -- unsigned long long histogramPercentile(const histogram *table,
+ --                                        double percentile);
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- NOTES:
+ -- A fixed size latency histogram. Values below HISTOGRAM_SUB_BUCKETS get a
+ -- bucket each, and every power of two above that is split into
+ -- HISTOGRAM_SUB_BUCKETS linear buckets, so any value up to 2^64 is recorded
+ -- with a relative error of at most 1 / HISTOGRAM_SUB_BUCKETS. Recording is a
+ -- count leading zeros and an increment, and two histograms are merged by
+ -- adding their buckets, which is what lets results from many threads, runs or
+ -- hosts be combined without losing the percentiles.
+ */
+
+// Includes
+#include "histogram.h"
+
+/*
+ -- FUNCTION: histogramRecord
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void histogramRecord(histogram *table,
+ --                                 unsigned long long value);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Adds a single value to the histogram.
+ */
+void histogramRecord(histogram *table, unsigned long long value)
+{
+    table->buckets[histogramBucket(value)]++;
+    table->count++;
+    table->total += value;
+    if (value > table->maximum)
+    {
+        table->maximum = value;
+    }
+}
+
+/*
+ -- FUNCTION: histogramMerge
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void histogramMerge(histogram *destination,
+ --                                const histogram *source);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Adds every value recorded in source to destination.
+ */
+void histogramMerge(histogram *destination, const histogram *source)
+{
+    unsigned int bucket = 0;
+
+    for (bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+    {
+        destination->buckets[bucket] += source->buckets[bucket];
+    }
+    destination->count += source->count;
+    destination->total += source->total;
+    if (source->maximum > destination->maximum)
+    {
+        destination->maximum = source->maximum;
+    }
+}
+
+/*
+ -- FUNCTION: histogramSubtract
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void histogramSubtract(histogram *destination,
+ --                                   const histogram *later,
+ --                                   const histogram *earlier);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Stores the values recorded between two snapshots of the same histogram in
+ -- destination. The largest value of the difference is not known exactly, so
+ -- it is taken as the top of the highest bucket that changed.
+ */
+void histogramSubtract(histogram *destination, const histogram *later,
+                       const histogram *earlier)
+{
+    unsigned int bucket = 0;
+    unsigned long long top = 0;
+
+    for (bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+    {
+        destination->buckets[bucket] = later->buckets[bucket] -
+                                       earlier->buckets[bucket];
+        if (destination->buckets[bucket] != 0)
+        {
+            top = bucket;
+        }
+    }
+    destination->count = later->count - earlier->count;
+    destination->total = later->total - earlier->total;
+    destination->maximum = 0;
+
+    if (destination->count != 0)
+    {
+        destination->maximum = (top + 1 < HISTOGRAM_BUCKETS) ?
+                               histogramBucketValue(top + 1) - 1 :
+                               later->maximum;
+        if (destination->maximum > later->maximum)
+        {
+            destination->maximum = later->maximum;
+        }
+    }
+}
+
+/*
+ -- FUNCTION: histogramBucket
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: unsigned int histogramBucket(unsigned long long value);
+ --
+ -- RETURNS: the index of the bucket that holds the value
+ */
+unsigned int histogramBucket(unsigned long long value)
+{
+    unsigned int power = 0;
+
+    if (value < HISTOGRAM_SUB_BUCKETS)
+    {
+        return value;
+    }
+
+    power = 63 - __builtin_clzll(value);
+
+    return (power - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS +
+           ((value >> (power - HISTOGRAM_SUB_BITS)) &
+            (HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+/*
+ -- FUNCTION: histogramBucketValue
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: unsigned long long histogramBucketValue(unsigned int bucket);
+ --
+ -- RETURNS: the smallest value that falls into the bucket
+ */
+unsigned long long histogramBucketValue(unsigned int bucket)
+{
+    unsigned int power = 0;
+    unsigned long long sub = 0;
+
+    if (bucket < HISTOGRAM_SUB_BUCKETS)
+    {
+        return bucket;
+    }
+
+    power = bucket / HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BITS - 1;
+    sub = bucket % HISTOGRAM_SUB_BUCKETS;
+
+    return (HISTOGRAM_SUB_BUCKETS + sub) << (power - HISTOGRAM_SUB_BITS);
+}
+
+/*
+ -- FUNCTION: histogramPercentile
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: unsigned long long histogramPercentile(const histogram *table,
+ --                                                   double percentile);
+ --
+ -- RETURNS: the value below which the percentile of samples fall
+ --
+ -- NOTES:
+ -- The answer is the top of the bucket holding the percentile, capped at the
+ -- largest value seen, so it never under reports the latency.
+ */
+unsigned long long histogramPercentile(const histogram *table,
+                                       double percentile)
+{
+    unsigned int bucket = 0;
+    unsigned long long seen = 0;
+    unsigned long long target = 0;
+    unsigned long long value = 0;
+
+    if (table->count == 0)
+    {
+        return 0;
+    }
+
+    target = table->count * (percentile / 100.0);
+    if (target >= table->count)
+    {
+        target = table->count - 1;
+    }
+
+    for (bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+    {
+        seen += table->buckets[bucket];
+        if (seen > target)
+        {
+            break;
+        }
+    }
+
+    if (bucket + 1 >= HISTOGRAM_BUCKETS)
+    {
+        return table->maximum;
+    }
+
+    value = histogramBucketValue(bucket + 1) - 1;
+
+    return (value < table->maximum) ? value : table->maximum;
+}
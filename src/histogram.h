@@ -0,0 +1,33 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+/* Defines */
+#define HISTOGRAM_SUB_BITS 3
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+/* A log linear histogram, each power of two is split into sub buckets */
+typedef struct
+{
+    unsigned long long count;
+    unsigned long long total;
+    unsigned long long maximum;
+    unsigned long long buckets[HISTOGRAM_BUCKETS];
+} histogram;
+
+/* Function Prototypes */
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void histogramRecord(histogram *table, unsigned long long value);
+    void histogramMerge(histogram *destination, const histogram *source);
+    void histogramSubtract(histogram *destination, const histogram *later,
+                           const histogram *earlier);
+    unsigned int histogramBucket(unsigned long long value);
+    unsigned long long histogramBucketValue(unsigned int bucket);
+    unsigned long long histogramPercentile(const histogram *table,
+                                           double percentile);
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,289 @@
+/*
+ -- SOURCE FILE: mpscQueue.c
+ --
+ -- PROGRAM: Web Client Emulator
+ --
+ -- FUNCTIONS:
+ -- mpscQueue *mpscCreate(unsigned int size);
+ -- void mpscDestroy(mpscQueue *queue);
+ -- int mpscPush(mpscQueue *queue, int value);
+ -- int mpscPop(mpscQueue *queue, int *value);
+ -- int mpscSignal(mpscQueue *queue);
+ -- void mpscClearSignal(mpscQueue *queue);
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- NOTES:
+ -- A bounded queue for handing sockets from accepting threads to the thread
+ -- that serves them, without a lock. Any number of threads may push, only
+ -- the owner of the queue pops.
+ --
+ -- The queue is a ring of cells, each with a sequence number. A producer
+ -- claims the cell at the tail by moving the tail on with a compare and swap
+ -- once the cell's sequence shows the consumer is done with it, fills it in,
+ -- then moves the sequence on to hand it over. The consumer takes the cell at
+ -- the head once its sequence shows it was filled, and moves the sequence on
+ -- a lap to give it back. A push only fails when the ring is full.
+ --
+ -- The consumer sleeps in epoll on the queue's eventfd. Producers push a batch
+ -- and then signal, and only the first signal after the consumer last cleared
+ -- the flag writes to the eventfd, so a busy consumer costs its producers no
+ -- system calls. The consumer clears the flag before it empties the queue, so
+ -- anything pushed after it looked is signalled again.
+ */
+
+// Includes
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "mpscQueue.h"
+
+/*
+ -- FUNCTION: mpscCreate
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: mpscQueue *mpscCreate(unsigned int size);
+ --
+ -- RETURNS: the new queue, or NULL on failure
+ --
+ -- NOTES:
+ -- Makes an empty queue with room for at least size sockets, rounded up to a
+ -- power of two, and its eventfd.
+ */
+mpscQueue *mpscCreate(unsigned int size)
+{
+    unsigned long index = 0;
+    unsigned long cells = 2;
+    mpscQueue *queue = 0;
+    
+    while (cells < size)
+    {
+        cells *= 2;
+    }
+    
+    if ((queue = calloc(1, sizeof(mpscQueue))) == NULL)
+    {
+        return NULL;
+    }
+    if ((queue->cells = malloc(sizeof(mpscCell) * cells)) == NULL)
+    {
+        free(queue);
+        return NULL;
+    }
+    if ((queue->wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1)
+    {
+        free(queue->cells);
+        free(queue);
+        return NULL;
+    }
+    
+    for (index = 0; index < cells; index++)
+    {
+        queue->cells[index].sequence = index;
+    }
+    queue->mask = cells - 1;
+    
+    return queue;
+}
+
+/*
+ -- FUNCTION: mpscDestroy
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void mpscDestroy(mpscQueue *queue);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Frees the queue and closes its eventfd. Sockets still in it are not
+ -- closed.
+ */
+void mpscDestroy(mpscQueue *queue)
+{
+    close(queue->wakeup);
+    free(queue->cells);
+    free(queue);
+}
+
+/*
+ -- FUNCTION: mpscPush
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int mpscPush(mpscQueue *queue, int value);
+ --
+ -- RETURNS: 0 on success, -1 if the queue is full
+ --
+ -- NOTES:
+ -- Adds a socket at the tail of the queue. Safe to call from any thread. The
+ -- consumer is not woken, see mpscSignal.
+ */
+int mpscPush(mpscQueue *queue, int value)
+{
+    unsigned long position = queue->tail;
+    long difference = 0;
+    mpscCell *cell = 0;
+    
+    while (1)
+    {
+        cell = &queue->cells[position & queue->mask];
+        difference = (long)(cell->sequence - position);
+        if (difference == 0 &&
+            __sync_bool_compare_and_swap(&queue->tail, position, position + 1))
+        {
+            break;
+        }
+        if (difference < 0)
+        {
+            /* The consumer has not emptied this cell since the last lap */
+            return -1;
+        }
+        position = queue->tail;
+    }
+    
+    cell->value = value;
+    __sync_synchronize();
+    cell->sequence = position + 1;
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: mpscPop
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int mpscPop(mpscQueue *queue, int *value);
+ --
+ -- RETURNS: 1 if a socket was taken, 0 if the queue is empty
+ --
+ -- NOTES:
+ -- Takes the socket at the head of the queue. Only the owner of the queue
+ -- may call this. A producer that has claimed the head cell but not yet
+ -- filled it makes the queue look empty until it has.
+ */
+int mpscPop(mpscQueue *queue, int *value)
+{
+    mpscCell *cell = &queue->cells[queue->head & queue->mask];
+    
+    if (cell->sequence != queue->head + 1)
+    {
+        return 0;
+    }
+    __sync_synchronize();
+    
+    *value = cell->value;
+    __sync_synchronize();
+    cell->sequence = queue->head + queue->mask + 1;
+    queue->head++;
+    
+    return 1;
+}
+
+/*
+ -- FUNCTION: mpscSignal
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Fences the pushes before it reads the
+ -- signalled flag.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int mpscSignal(mpscQueue *queue);
+ --
+ -- RETURNS: 1 if the eventfd was written, 0 if the consumer had already been
+ --          signalled, -1 on failure
+ --
+ -- NOTES:
+ -- Wakes the consumer after a batch of pushes, unless it has been woken
+ -- since it last cleared the signal. The fence pairs with the one in
+ -- mpscClearSignal: without it the read of the flag could be done before
+ -- the pushes are visible, and a consumer clearing the flag in between would
+ -- neither see the pushes nor be signalled again.
+ */
+int mpscSignal(mpscQueue *queue)
+{
+    uint64_t one = 1;
+    
+    __sync_synchronize();
+    if (queue->signalled ||
+        !__sync_bool_compare_and_swap(&queue->signalled, 0, 1))
+    {
+        return 0;
+    }
+    
+    if (write(queue->wakeup, &one, sizeof(one)) != sizeof(one))
+    {
+        return -1;
+    }
+    
+    return 1;
+}
+
+/*
+ -- FUNCTION: mpscClearSignal
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void mpscClearSignal(mpscQueue *queue);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Called by the consumer when its eventfd is readable, before it empties
+ -- the queue. Resets the eventfd and lets the next push signal again.
+ */
+void mpscClearSignal(mpscQueue *queue)
+{
+    uint64_t count = 0;
+    
+    if (read(queue->wakeup, &count, sizeof(count)) == -1)
+    {
+        count = 0;
+    }
+    queue->signalled = 0;
+    __sync_synchronize();
+}
@@ -0,0 +1,38 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+/* Defines */
+#define MPSC_QUEUE_SIZE 4096
+
+/* One slot of the ring, the sequence says whose turn it is */
+typedef struct
+{
+    volatile unsigned long sequence;
+    int value;
+} mpscCell;
+
+/* A bounded queue of sockets with many producers and one consumer */
+typedef struct
+{
+    mpscCell *cells;
+    unsigned long mask;
+    volatile unsigned long tail;
+    unsigned long head;
+    volatile int signalled;
+    int wakeup;
+} mpscQueue;
+
+/* Function Prototypes */
+#ifdef __cplusplus
+extern "C" {
+#endif
+    mpscQueue *mpscCreate(unsigned int size);
+    void mpscDestroy(mpscQueue *queue);
+    int mpscPush(mpscQueue *queue, int value);
+    int mpscPop(mpscQueue *queue, int *value);
+    int mpscSignal(mpscQueue *queue);
+    void mpscClearSignal(mpscQueue *queue);
+#ifdef __cplusplus
+}
+#endif
+#endif
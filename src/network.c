@@ -5,17 +5,62 @@
  --
  -- FUNCTIONS:
  -- int tcpSocket();
+ -- int streamSocket();
+ -- int setUnixPath(const char *path);
+ -- const char *getUnixPath();
  -- int setReuse(int* socket);
  -- int bindAddress(int *port, int *socket);
+ -- int bindAddressTo(const networkAddress *address, int *port, int *socket);
+ -- int bindLoopback(int *port, int *socket);
+ -- int addressSocket(const networkAddress *address);
+ -- int parseAddress(const char *text, networkAddress *address);
+ -- int parseAddressList(const char *text, networkAddress *addresses,
+ --                      int *counts, int most);
+ -- int describeAddress(const networkAddress *address, char *text,
+ --                     size_t length);
+ -- int setSourceAddresses(const char *list);
  -- int setListen(int *socket);
  -- int acceptConnection(int *listenSocket);
  -- int readData(int *socket, char *buffer, int bytesToRead);
  -- int sendData(int *socket, char *buffer, int bytesToSend);
+ -- int readAvailable(int *socket, char *buffer, int maxBytesToRead);
+ -- int inputWaiting(int *socket);
  -- int closeSocket(int *socket);
+ -- int makeSocketBlocking(int *socket);
+ -- int setReusePort(int *socket);
+ -- int steerByCpu(int *socket, const unsigned int *indexOfCpu,
+ --                unsigned int cpus);
+ -- int incomingCpu(int *socket);
+ -- int setBusyPoll(int *socket, int microseconds);
+ -- int loadSocketTuning(const char *path, char *error, size_t errorLength);
+ -- int describeSocketTuning(char *text, size_t length);
+ -- void setNetworkCounters(networkCounters *counters);
+ -- void countSyscall(long bytes);
+ -- void countSent(long bytes);
+ -- static void tuneBuffers(int socket);
+ -- static void tuneConnection(int socket);
+ -- static int socketDomain(int socket);
+ -- static int connectToPath(const char *path, int *sock);
+ -- static int bindSource(int socket, int family);
  --
  -- DATE: March 12, 2011
  --
- -- REVISIONS: (Date and Description)
+ -- REVISIONS: October 18, 2026 - Added a socket tuning profile. Every socket
+ -- made or accepted through these wrappers gets the same options, so all of
+ -- the programs can be tuned from one file.
+ -- October 18, 2026 - The wrappers count the system calls they make and the
+ -- bytes those calls move, for threads that ask for it.
+ -- October 18, 2026 - The bytes sent are also counted on their own.
+ -- October 18, 2026 - The listen backlog can be set in the tuning profile.
+ -- October 18, 2026 - Added inputWaiting.
+ -- October 18, 2026 - sendData no longer raises SIGPIPE, and sends the whole
+ -- buffer after a partial send.
+ -- October 18, 2026 - Added UNIX domain stream sockets as a transport. A
+ -- server serves a path set with setUnixPath, and a client connects to one
+ -- by giving the path as its address.
+ -- October 18, 2026 - Added IPv6. bindAddress binds the wildcard address of
+ -- the socket's family, bindAddressTo binds a given address, and clients
+ -- may connect from a list of source addresses.
  --
  -- DESIGNER: Luke Queenan
  --
@@ -26,28 +71,82 @@
  -- programs.The file contains all network related header files, meaning that the
  -- user of this library does not need to include anything except the network.h
  -- header file.
+ --
+ -- When the clients run on the same host as the server, TCP over loopback
+ -- still runs every byte through the TCP stack, and that cost is measured
+ -- along with the server's own. A UNIX domain stream socket carries the same
+ -- byte stream without it. Once setUnixPath has been given a path,
+ -- streamSocket makes UNIX domain sockets and bindAddress binds them to the
+ -- path, so a server takes the transport with no other change. Sockets made
+ -- with tcpSocket, such as the admin port, stay TCP. The TCP options of the
+ -- tuning profile are not applied to UNIX domain sockets, they have none.
+ --
+ -- Addresses are IPv4 or IPv6 and are kept as a networkAddress, parsed from
+ -- text with parseAddress. A server can listen on several of them, each
+ -- socket made with addressSocket and bound with bindAddressTo. An IPv6
+ -- socket is made IPv6 only, so the IPv4 and IPv6 wildcards can be listed
+ -- together.
+ --
+ -- A client host only has about 28 thousand ephemeral ports for each server
+ -- address and port it connects to, since every connection needs its own
+ -- four tuple. setSourceAddresses gives connectToServer more addresses to
+ -- connect from, which it takes in turn for each connection. The socket is
+ -- bound to the source with IP_BIND_ADDRESS_NO_PORT, so the port is only
+ -- picked at connect, against the full four tuple, rather than at bind where
+ -- it would have to be unique for the source address alone.
  */
 
 // Includes
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <linux/filter.h>
+
+#ifndef IP_BIND_ADDRESS_NO_PORT
+#define IP_BIND_ADDRESS_NO_PORT 24
+#endif
 
 #include "network.h"
 
 #define MAX_QUEUE 10
 
+static void tuneBuffers(int socket);
+static void tuneConnection(int socket);
+static int socketDomain(int socket);
+static int connectToPath(const char *path, int *sock);
+static int bindSource(int socket, int family);
+
+/* The options set on every socket, -1 leaves an option at the default */
+static socketTuning tuning = {1, -1, -1, -1, -1, -1, -1, -1};
+
+/* Where the calling thread's system calls are counted, if anywhere */
+static __thread networkCounters *counters = 0;
+
+/* The path servers listen on instead of a port, empty for TCP */
+static char unixPath[sizeof(((struct sockaddr_un *)0)->sun_path)] = "";
+
+/* The addresses clients connect from, taken in turn */
+static networkAddress sources[NETWORK_MAX_ADDRESSES];
+static int sourceCount = 0;
+static unsigned int nextSource = 0;
+
 /*
  -- FUNCTION: tcpSocket
  --
  -- DATE: March 12, 2011
  --
- -- REVISIONS: (Date and Description)
+ -- REVISIONS: October 18, 2026 - Sets the tuned buffer sizes.
  --
  -- DESIGNER: Luke Queenan
  --
@@ -62,13 +161,20 @@
  */
 int tcpSocket()
 {
-    return socket(AF_INET, SOCK_STREAM, 0);
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    
+    if (sock != -1)
+    {
+        tuneBuffers(sock);
+    }
+    
+    return sock;
 }
 
 /*
- -- FUNCTION: setReuse
+ -- FUNCTION: streamSocket
  --
- -- DATE: March 12, 2011
+ -- DATE: October 18, 2026
  --
  -- REVISIONS: (Date and Description)
  --
@@ -76,25 +182,35 @@ int tcpSocket()
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: int setReuse(int *socket);
+ -- INTERFACE: int streamSocket();
  --
- -- RETURNS: the result of the setsockopt function
+ -- RETURNS: a new stream socket, or -1 on failure
  --
  -- NOTES:
- -- This is the wrapper function for setting the reuse option on a socket. This
- -- allows the socket to be reused after an improper shutdown.
+ -- Makes a socket for a server to listen on with the transport in use, a
+ -- UNIX domain socket if a path has been set and a tcp socket otherwise.
  */
-int setReuse(int *socket)
+int streamSocket()
 {
-    socklen_t optlen = 1;
-    return setsockopt(*socket, SOL_SOCKET, SO_REUSEADDR, &optlen,
-                      sizeof(optlen));
+    int sock = 0;
+    
+    if (unixPath[0] == '\0')
+    {
+        return tcpSocket();
+    }
+    
+    if ((sock = socket(AF_UNIX, SOCK_STREAM, 0)) != -1)
+    {
+        tuneBuffers(sock);
+    }
+    
+    return sock;
 }
 
 /*
- -- FUNCTION: bindAddress
+ -- FUNCTION: setUnixPath
  --
- -- DATE: March 12, 2011
+ -- DATE: October 18, 2026
  --
  -- REVISIONS: (Date and Description)
  --
@@ -102,29 +218,30 @@ int setReuse(int *socket)
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: int bindAddress(int *port, int *socket);
+ -- INTERFACE: int setUnixPath(const char *path);
  --
- -- RETURNS: the result of the bind function
+ -- RETURNS: 0 on success, -1 if the path is too long for a socket address
  --
  -- NOTES:
- -- This is the wrapper function for binding an address to a socket.
+ -- Sets the path that streamSocket and bindAddress serve on in place of a
+ -- port. Call it before the listening sockets are made.
  */
-int bindAddress(int *port, int *socket)
+int setUnixPath(const char *path)
 {
-    struct sockaddr_in address;
-    
-    bzero((char *)&address, sizeof(struct sockaddr_in));
-    address.sin_family = AF_INET;
-    address.sin_port = htons(*port);
-    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (strlen(path) >= sizeof(unixPath))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
     
-    return bind(*socket, (struct sockaddr *)&address, sizeof(address));
+    strcpy(unixPath, path);
+    return 0;
 }
 
 /*
- -- FUNCTION: setListen
+ -- FUNCTION: getUnixPath
  --
- -- DATE: March 12, 2011
+ -- DATE: October 18, 2026
  --
  -- REVISIONS: (Date and Description)
  --
@@ -132,20 +249,20 @@ int bindAddress(int *port, int *socket)
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: int setListen(int *socket);
+ -- INTERFACE: const char *getUnixPath();
  --
- -- RETURNS: the result of listen function
+ -- RETURNS: the path being served, or NULL when the transport is TCP
  --
  -- NOTES:
- -- This is the wrapper function for setting a socket to listen on.
+ -- For the servers, which only bind a path once and print it at start up.
  */
-int setListen(int *socket)
+const char *getUnixPath()
 {
-    return listen(*socket, MAX_QUEUE);
+    return (unixPath[0] != '\0') ? unixPath : NULL;
 }
 
 /*
- -- FUNCTION: acceptConnection
+ -- FUNCTION: setReuse
  --
  -- DATE: March 12, 2011
  --
@@ -155,55 +272,83 @@ int setListen(int *socket)
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: int acceptConnection(int *listenSocket);
+ -- INTERFACE: int setReuse(int *socket);
  --
- -- RETURNS: the new socket created for the connection
+ -- RETURNS: the result of the setsockopt function
  --
  -- NOTES:
- -- This is the wrapper function for accepting a connection from the specified
- -- socket.
+ -- This is the wrapper function for setting the reuse option on a socket. This
+ -- allows the socket to be reused after an improper shutdown.
  */
-int acceptConnection(int *listenSocket)
+int setReuse(int *socket)
 {
-    struct sockaddr_in clientAddress;
-    socklen_t addrlen = sizeof(clientAddress);
-    return accept(*listenSocket, (struct sockaddr *) &clientAddress, &addrlen);
+    socklen_t optlen = 1;
+    return setsockopt(*socket, SOL_SOCKET, SO_REUSEADDR, &optlen,
+                      sizeof(optlen));
 }
 
 /*
- -- FUNCTION: acceptConnectionIp
+ -- FUNCTION: bindAddress
  --
  -- DATE: March 12, 2011
  --
- -- REVISIONS: (Date and Description)
+ -- REVISIONS: October 18, 2026 - Binds a UNIX domain socket to the path set
+ -- with setUnixPath.
+ -- October 18, 2026 - Binds an IPv6 socket to the IPv6 wildcard address.
  --
  -- DESIGNER: Luke Queenan
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: int acceptConnectionIp(int *listenSocket, char *ip);
+ -- INTERFACE: int bindAddress(int *port, int *socket);
  --
- -- RETURNS: the new socket created for the connection
+ -- RETURNS: the result of the bind function
  --
  -- NOTES:
- -- This is the wrapper function for accepting a connection from the specified
- -- socket. If you need the client's ip address, you can pass a char* to the
- -- function. You must ensure that the length of the ip array is long enough.
+ -- This is the wrapper function for binding an address to a socket. A UNIX
+ -- domain socket is bound to the path instead of the port. A socket file
+ -- left at the path by a server that did not exit cleanly is removed first,
+ -- anything else there makes the bind fail. Other sockets are bound to the
+ -- port on every address of their family.
  */
-int acceptConnectionIp(int *listenSocket, char *ip)
+int bindAddress(int *port, int *socket)
 {
-    int sock = 0;
-    struct sockaddr_in clientAddress;
-    socklen_t addrlen = sizeof(clientAddress);
-    sock = accept(*listenSocket, (struct sockaddr *) &clientAddress, &addrlen);
-    strcpy(ip, inet_ntoa(clientAddress.sin_addr));
-    return sock;
+    int domain = socketDomain(*socket);
+    struct sockaddr_in address;
+    struct sockaddr_un local;
+    struct stat status;
+    networkAddress any;
+    
+    if (domain == AF_INET6)
+    {
+        parseAddress("::", &any);
+        return bindAddressTo(&any, port, socket);
+    }
+    
+    if (domain == AF_UNIX)
+    {
+        memset(&local, 0, sizeof(struct sockaddr_un));
+        local.sun_family = AF_UNIX;
+        strcpy(local.sun_path, unixPath);
+        if (lstat(unixPath, &status) == 0 && S_ISSOCK(status.st_mode))
+        {
+            unlink(unixPath);
+        }
+        return bind(*socket, (struct sockaddr *)&local, sizeof(local));
+    }
+    
+    bzero((char *)&address, sizeof(struct sockaddr_in));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(*port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    
+    return bind(*socket, (struct sockaddr *)&address, sizeof(address));
 }
 
 /*
- -- FUNCTION: acceptConnectionPort
+ -- FUNCTION: bindAddressTo
  --
- -- DATE: September 28, 2011
+ -- DATE: October 18, 2026
  --
  -- REVISIONS: (Date and Description)
  --
@@ -211,32 +356,38 @@ int acceptConnectionIp(int *listenSocket, char *ip)
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: int acceptConnectionIpPort(int *listenSocket, char *ip,
- --                                       unsigned short *port);
+ -- INTERFACE: int bindAddressTo(const networkAddress *address, int *port,
+ --                              int *socket);
  --
- -- RETURNS: the new socket created for the connection
+ -- RETURNS: the result of the bind function
  --
  -- NOTES:
- -- This is the wrapper function for accepting a connection from the specified
- -- socket. If you need the client's ip address, you can pass a char* to the
- -- function. You must ensure that the length of the ip array is long enough. If
- -- you need the client's port, you can pass an unsigned short* to the function.
+ -- Binds the socket to the port on one address. The socket must have been
+ -- made for the address's family, see addressSocket. An IPv6 socket is set
+ -- to IPv6 only first, so it does not take the IPv4 port as well.
  */
-int acceptConnectionIpPort(int *listenSocket, char *ip, unsigned short *port)
+int bindAddressTo(const networkAddress *address, int *port, int *socket)
 {
-    int sock = 0;
-    struct sockaddr_in clientAddress;
-    socklen_t addrlen = sizeof(clientAddress);
-    sock = accept(*listenSocket, (struct sockaddr *) &clientAddress, &addrlen);
-    strcpy(ip, inet_ntoa(clientAddress.sin_addr));
-    *port = htons(clientAddress.sin_port);
-    return sock;
+    int only = 1;
+    networkAddress bound = *address;
+    
+    if (bound.address.ss_family == AF_INET6)
+    {
+        ((struct sockaddr_in6 *)&bound.address)->sin6_port = htons(*port);
+        setsockopt(*socket, IPPROTO_IPV6, IPV6_V6ONLY, &only, sizeof(only));
+    }
+    else
+    {
+        ((struct sockaddr_in *)&bound.address)->sin_port = htons(*port);
+    }
+    
+    return bind(*socket, (struct sockaddr *)&bound.address, bound.length);
 }
 
 /*
- -- FUNCTION: readData
+ -- FUNCTION: addressSocket
  --
- -- DATE: March 13, 2011
+ -- DATE: October 18, 2026
  --
  -- REVISIONS: (Date and Description)
  --
@@ -244,40 +395,29 @@ int acceptConnectionIpPort(int *listenSocket, char *ip, unsigned short *port)
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: int readData(int *socket, char *buffer, int bytesToRead);
+ -- INTERFACE: int addressSocket(const networkAddress *address);
  --
- -- RETURNS: the number of bytes read
+ -- RETURNS: a new tcp socket of the address's family, or -1 on failure
  --
  -- NOTES:
- -- This is the wrapper function for reading data from a socket. The data is
- -- stored in a char array. The function will continue to read until it has read
- -- the number of bytes specified by bytesToRead. You MUST ensure that the sender
- -- has sent the SAME number of bytes, or this function will block.
+ -- tcpSocket for an address that may be IPv6.
  */
-int readData(int *socket, char *buffer, int bytesToRead)
+int addressSocket(const networkAddress *address)
 {
-    int read = 0;
-    int readTotal = 0;
-    int bytesLeft = bytesToRead;
+    int sock = socket(address->address.ss_family, SOCK_STREAM, 0);
     
-    while (read < bytesToRead)
+    if (sock != -1)
     {
-        read = recv(*socket, buffer + readTotal, bytesLeft, MSG_WAITALL);
-        if (read == -1)
-        {
-            return -1;
-        }
-        readTotal += read;
-        bytesLeft = bytesToRead - readTotal;
+        tuneBuffers(sock);
     }
     
-    return read;
+    return sock;
 }
 
 /*
- -- FUNCTION: sendData
+ -- FUNCTION: parseAddress
  --
- -- DATE: March 13, 2011
+ -- DATE: October 18, 2026
  --
  -- REVISIONS: (Date and Description)
  --
@@ -285,38 +425,42 @@ int readData(int *socket, char *buffer, int bytesToRead)
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: int sendData(int *socket, const char *buffer, int bytesToSend);
+ -- INTERFACE: int parseAddress(const char *text, networkAddress *address);
  --
- -- RETURNS: the bytes written to the specified socket
+ -- RETURNS: 0 on success, -1 if the text is not an IPv4 or IPv6 address
  --
  -- NOTES:
- -- This is the wrapper function for sending a char buffer to a socket using
- -- write.
+ -- Reads a numeric address, such as 10.0.0.1, :: or fe80::1%eth0 with the
+ -- interface of a link local address. The port is left at zero. Names are
+ -- not looked up, a server is told exactly where to listen.
  */
-int sendData(int *socket, const char *buffer, int bytesToSend)
+int parseAddress(const char *text, networkAddress *address)
 {
-    int sent = 0;
-    int sentTotal = 0;
-    int bytesLeft = bytesToSend;
+    struct addrinfo hints;
+    struct addrinfo *result;
+    
+    memset(&hints, 0, sizeof(struct addrinfo));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICHOST | AI_PASSIVE;
     
-    while (sent < bytesToSend)
+    if (getaddrinfo(text, NULL, &hints, &result) != 0)
     {
-        sent = send(*socket, buffer + sentTotal, bytesLeft, 0);
-        if (sent == -1)
-        {
-            return -1;
-        }
-        sentTotal += sent;
-        bytesLeft = bytesToSend - sentTotal;
+        return -1;
     }
     
-    return sent;
+    memset(address, 0, sizeof(networkAddress));
+    memcpy(&address->address, result->ai_addr, result->ai_addrlen);
+    address->length = result->ai_addrlen;
+    freeaddrinfo(result);
+    
+    return 0;
 }
 
 /*
- -- FUNCTION: readLine
+ -- FUNCTION: parseAddressList
  --
- -- DATE: February 11, 2012
+ -- DATE: October 18, 2026
  --
  -- REVISIONS: (Date and Description)
  --
@@ -324,55 +468,67 @@ int sendData(int *socket, const char *buffer, int bytesToSend)
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: int readLine(int *socket, char *buffer, int maxBytesToRead);
+ -- INTERFACE: int parseAddressList(const char *text,
+ --                                 networkAddress *addresses, int *counts,
+ --                                 int most);
  --
- -- RETURNS: the number of bytes read
+ -- RETURNS: the number of addresses, or -1 if the list is not valid
  --
  -- NOTES:
- -- This is the wrapper function for reading a line from a socket. The function
- -- will continue to read from the socket until the maximum bytes to read has
- -- been met, or the buffer reaches a new line.
+ -- Reads a comma separated list of up to most addresses. With counts, each
+ -- address may be followed by @ and a count, for the servers to give each
+ -- address its own number of reactors. A count left out is 0, and so is
+ -- one given without counts to put it in, which is an error.
  */
-int readLine(int *socket, char *buffer, int maxBytesToRead)
+int parseAddressList(const char *text, networkAddress *addresses, int *counts,
+                     int most)
 {
     int count = 0;
-    int bytesRead = 0;
+    int number = 0;
+    size_t length = 0;
+    char entry[NETWORK_ADDRESS_SIZE];
+    char *at = 0;
+    char *end = 0;
     
-    for (count = 0; count < maxBytesToRead; count++)
+    while (*text != '\0')
     {
-        if ((bytesRead = recv(*socket, &buffer[count], 1, MSG_WAITALL)) == 1)
+        length = strcspn(text, ",");
+        if (count == most || length == 0 || length >= sizeof(entry))
         {
-            /* Get out of the read if we find the new line */
-            if (buffer[count] == '\n')
-            {
-                break;
-            }
+            return -1;
         }
-        else if (bytesRead == 0)
+        memcpy(entry, text, length);
+        entry[length] = '\0';
+        text += length + (text[length] == ',');
+        
+        number = 0;
+        if ((at = strchr(entry, '@')) != NULL)
         {
-            /* EOF, no data read */
-            if (count == 0)
-            {
-                return 0;
-            }
-            else
+            *at = '\0';
+            number = strtol(at + 1, &end, 10);
+            if (counts == NULL || *end != '\0' || number < 1)
             {
-                break;
+                return -1;
             }
         }
-        else
+        if (parseAddress(entry, &addresses[count]) == -1)
         {
             return -1;
         }
+        if (counts != NULL)
+        {
+            counts[count] = number;
+        }
+        count++;
     }
     
     return count;
 }
 
 /*
- -- FUNCTION: closeSocket
+ -- FUNCTION: describeAddress
  --
- -- DATE: March 13, 2011
+ -- DATE: October 18, 2026
  --
  -- REVISIONS: (Date and Description)
  --
@@ -380,22 +536,30 @@ int readLine(int *socket, char *buffer, int maxBytesToRead)
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: int closeSocket(int *socket);
+ -- INTERFACE: int describeAddress(const networkAddress *address, char *text,
+ --                                size_t length);
  --
- -- RETURNS: the result of the close function
+ -- RETURNS: 0 on success, -1 if the text does not fit
  --
  -- NOTES:
- -- This is the wrapper function for closing a file descriptor.
+ -- Writes the address as text, for the servers to say where they listen.
  */
-int closeSocket(int *socket)
+int describeAddress(const networkAddress *address, char *text, size_t length)
 {
-    return close(*socket);
+    const void *raw = &((const struct sockaddr_in *)&address->address)->sin_addr;
+    
+    if (address->address.ss_family == AF_INET6)
+    {
+        raw = &((const struct sockaddr_in6 *)&address->address)->sin6_addr;
+    }
+    
+    return inet_ntop(address->address.ss_family, raw, text, length) ? 0 : -1;
 }
 
 /*
- -- FUNCTION: connectToServer
+ -- FUNCTION: setSourceAddresses
  --
- -- DATE: March 14, 2011
+ -- DATE: October 18, 2026
  --
  -- REVISIONS: (Date and Description)
  --
@@ -403,69 +567,40 @@ int closeSocket(int *socket)
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: int connectToServer(int *port, int *socket, const char *ip);
+ -- INTERFACE: int setSourceAddresses(const char *list);
  --
- -- RETURNS: the result of the connect function or gethostbyname if it fails
+ -- RETURNS: the number of source addresses, or -1 if the list is not valid
  --
  -- NOTES:
- -- This is the wrapper function for connecting to a server.
+ -- Sets the comma separated addresses connectToServer connects from, up to
+ -- NETWORK_MAX_ADDRESSES of them. NULL or an empty list goes back to letting
+ -- the system pick. Call it before the connections are made, it is not safe
+ -- against connections being made on other threads.
  */
-int connectToServer(const char *port, int *sock, const char *ip)
+int setSourceAddresses(const char *list)
 {
-    struct addrinfo hints;
-    struct addrinfo *result;
-    struct addrinfo *rp;
-    
-    memset(&hints, 0, sizeof(struct addrinfo));
-    hints.ai_family = AF_INET;
-    hints.ai_socktype = SOCK_STREAM;
-
-    if (getaddrinfo(ip, port, &hints, &result) != 0)
-    {
-        return -1;
-    }
-        
-    for (rp = result; rp != NULL; rp = rp->ai_next)
-    {
-        *sock = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
-        
-        if (*sock == -1)
-            continue;
-        
-        if (connect(*sock, rp->ai_addr, rp->ai_addrlen) != -1)
-            break;
-            
-        close(*sock);
-    }
+    int count = 0;
     
-    if (rp == NULL)
+    if (list == NULL)
     {
-        return -1;
+        list = "";
     }
     
-    freeaddrinfo(result);
-    
-    return *sock;
-/*
-    struct sockaddr_in address;
-    struct hostent *hp;
-    
-    memset(&address, '\0', sizeof(struct sockaddr_in));
-    address.sin_family = AF_INET;
-    address.sin_port = htons(*port);
-    if ((hp = gethostbyname(&(*ip))) == NULL)
+    if ((count = parseAddressList(list, sources, NULL,
+                                  NETWORK_MAX_ADDRESSES)) == -1)
     {
+        sourceCount = 0;
         return -1;
     }
-    memcpy(&address.sin_addr, hp->h_addr, hp->h_length);
     
-    return connect(*socket, (struct sockaddr *)&address, sizeof(address));*/
+    sourceCount = count;
+    return count;
 }
 
 /*
- -- FUNCTION: makeSocketNonBlocking
+ -- FUNCTION: bindLoopback
  --
- -- DATE: September 22, 2011
+ -- DATE: October 18, 2026
  --
  -- REVISIONS: (Date and Description)
  --
@@ -473,29 +608,1255 @@ int connectToServer(const char *port, int *sock, const char *ip)
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: int makeSocketNonBlocking(int *socket);
+ -- INTERFACE: int bindLoopback(int *port, int *socket);
  --
- -- RETURNS: the result of the fcntl function
+ -- RETURNS: the result of the bind function
  --
  -- NOTES:
- -- This is the wrapper function for setting the non blocking flag on the socket
- -- desriptor.
+ -- Binds the socket to the port on the loopback address only. If the port is
+ -- zero the system picks a free one, and the port it picked is written back.
  */
-int makeSocketNonBlocking(int *socket)
+int bindLoopback(int *port, int *socket)
 {
-    int flags = 0;
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
     
-    // Get the current flags off the socket
+    bzero((char *)&address, sizeof(struct sockaddr_in));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(*port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    
+    if (bind(*socket, (struct sockaddr *)&address, sizeof(address)) == -1 ||
+        getsockname(*socket, (struct sockaddr *)&address, &length) == -1)
+    {
+        return -1;
+    }
+    
+    *port = ntohs(address.sin_port);
+    return 0;
+}
+
+/*
+ -- FUNCTION: setListen
+ --
+ -- DATE: March 12, 2011
+ --
+ -- REVISIONS: October 18, 2026 - Sets TCP_DEFER_ACCEPT and TCP_FASTOPEN from
+ -- the tuning.
+ -- October 18, 2026 - The backlog can be set by the tuning.
+ -- October 18, 2026 - The TCP options are left off UNIX domain sockets.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int setListen(int *socket);
+ --
+ -- RETURNS: the result of listen function
+ --
+ -- NOTES:
+ -- This is the wrapper function for setting a socket to listen on.
+ */
+int setListen(int *socket)
+{
+    int tcp = (socketDomain(*socket) != AF_UNIX);
+    
+    /* Only wake the acceptor once the request has arrived */
+    if (tcp && tuning.deferAccept != -1)
+    {
+        setsockopt(*socket, IPPROTO_TCP, TCP_DEFER_ACCEPT, &tuning.deferAccept,
+                   sizeof(int));
+    }
+    
+    /* Take data in the SYN from clients that have a fast open cookie */
+    if (tcp && tuning.fastOpen != -1)
+    {
+        setsockopt(*socket, IPPROTO_TCP, TCP_FASTOPEN, &tuning.fastOpen,
+                   sizeof(int));
+    }
+    
+    /* A short accept queue turns a burst of connections into SYN drops */
+    return listen(*socket, (tuning.backlog != -1) ? tuning.backlog :
+                  MAX_QUEUE);
+}
+
+/*
+ -- FUNCTION: acceptConnection
+ --
+ -- DATE: March 12, 2011
+ --
+ -- REVISIONS: October 18, 2026 - Applies the tuning to the new connection.
+ -- October 18, 2026 - Accepts UNIX domain connections, which are not tuned.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int acceptConnection(int *listenSocket);
+ --
+ -- RETURNS: the new socket created for the connection
+ --
+ -- NOTES:
+ -- This is the wrapper function for accepting a connection from the specified
+ -- socket.
+ */
+int acceptConnection(int *listenSocket)
+{
+    struct sockaddr_storage clientAddress;
+    socklen_t addrlen = sizeof(clientAddress);
+    int sock = accept(*listenSocket, (struct sockaddr *) &clientAddress,
+                      &addrlen);
+    countSyscall(0);
+    if (sock != -1 && clientAddress.ss_family != AF_UNIX)
+    {
+        tuneConnection(sock);
+    }
+    return sock;
+}
+
+/*
+ -- FUNCTION: acceptConnectionIp
+ --
+ -- DATE: March 12, 2011
+ --
+ -- REVISIONS: October 18, 2026 - Applies the tuning to the new connection.
+ -- October 18, 2026 - A UNIX domain client's address is given as "local".
+ -- October 18, 2026 - Gives an IPv6 client's address, which needs
+ -- INET6_ADDRSTRLEN characters.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int acceptConnectionIp(int *listenSocket, char *ip);
+ --
+ -- RETURNS: the new socket created for the connection
+ --
+ -- NOTES:
+ -- This is the wrapper function for accepting a connection from the specified
+ -- socket. If you need the client's ip address, you can pass a char* to the
+ -- function. You must ensure that the length of the ip array is long enough.
+ */
+int acceptConnectionIp(int *listenSocket, char *ip)
+{
+    int sock = 0;
+    networkAddress client;
+    client.length = sizeof(client.address);
+    sock = accept(*listenSocket, (struct sockaddr *) &client.address,
+                  &client.length);
+    countSyscall(0);
+    if (sock == -1 || client.address.ss_family == AF_UNIX)
+    {
+        strcpy(ip, "local");
+        return sock;
+    }
+    describeAddress(&client, ip, INET6_ADDRSTRLEN);
+    tuneConnection(sock);
+    return sock;
+}
+
+/*
+ -- FUNCTION: acceptConnectionPort
+ --
+ -- DATE: September 28, 2011
+ --
+ -- REVISIONS: October 18, 2026 - Applies the tuning to the new connection.
+ -- October 18, 2026 - A UNIX domain client's address is given as "local",
+ -- with port 0.
+ -- October 18, 2026 - Gives an IPv6 client's address and port.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int acceptConnectionIpPort(int *listenSocket, char *ip,
+ --                                       unsigned short *port);
+ --
+ -- RETURNS: the new socket created for the connection
+ --
+ -- NOTES:
+ -- This is the wrapper function for accepting a connection from the specified
+ -- socket. If you need the client's ip address, you can pass a char* to the
+ -- function. You must ensure that the length of the ip array is long enough. If
+ -- you need the client's port, you can pass an unsigned short* to the function.
+ */
+int acceptConnectionIpPort(int *listenSocket, char *ip, unsigned short *port)
+{
+    int sock = 0;
+    networkAddress client;
+    client.length = sizeof(client.address);
+    sock = accept(*listenSocket, (struct sockaddr *) &client.address,
+                  &client.length);
+    countSyscall(0);
+    if (sock == -1 || client.address.ss_family == AF_UNIX)
+    {
+        strcpy(ip, "local");
+        *port = 0;
+        return sock;
+    }
+    describeAddress(&client, ip, INET6_ADDRSTRLEN);
+    if (client.address.ss_family == AF_INET6)
+    {
+        *port = ntohs(((struct sockaddr_in6 *)&client.address)->sin6_port);
+    }
+    else
+    {
+        *port = ntohs(((struct sockaddr_in *)&client.address)->sin_port);
+    }
+    tuneConnection(sock);
+    return sock;
+}
+
+/*
+ -- FUNCTION: readData
+ --
+ -- DATE: March 13, 2011
+ --
+ -- REVISIONS: October 18, 2026 - Returns the total read and stops at end of
+ -- file instead of looping on it forever.
+ -- October 18, 2026 - Turns quick ACK back on when the tuning asks for it.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int readData(int *socket, char *buffer, int bytesToRead);
+ --
+ -- RETURNS: the number of bytes read, which is less than bytesToRead if the
+ -- connection was closed
+ --
+ -- NOTES:
+ -- This is the wrapper function for reading data from a socket. The data is
+ -- stored in a char array. The function will continue to read until it has read
+ -- the number of bytes specified by bytesToRead. You MUST ensure that the sender
+ -- has sent the SAME number of bytes, or this function will block.
+ */
+int readData(int *socket, char *buffer, int bytesToRead)
+{
+    int read = 0;
+    int readTotal = 0;
+    int bytesLeft = bytesToRead;
+    
+    while (readTotal < bytesToRead)
+    {
+        read = recv(*socket, buffer + readTotal, bytesLeft, MSG_WAITALL);
+        countSyscall(read);
+        if (read == -1)
+        {
+            return -1;
+        }
+        
+        /* The other side closed the connection, return what we have */
+        if (read == 0)
+        {
+            break;
+        }
+        readTotal += read;
+        bytesLeft = bytesToRead - readTotal;
+    }
+    
+    /* Quick ACK mode does not stick, so it is turned back on after a read */
+    if (tuning.quickAck > 0 && readTotal > 0)
+    {
+        setsockopt(*socket, IPPROTO_TCP, TCP_QUICKACK, &tuning.quickAck,
+                   sizeof(int));
+        countSyscall(0);
+    }
+    
+    return readTotal;
+}
+
+/*
+ -- FUNCTION: sendData
+ --
+ -- DATE: March 13, 2011
+ --
+ -- REVISIONS: October 18, 2026 - Sends with MSG_NOSIGNAL, so a peer that has
+ -- gone away is an error for the caller rather than a SIGPIPE that ends the
+ -- process. The loop now runs until the whole buffer is sent, where it used
+ -- to compare the last send with the total and could spin sending nothing
+ -- after a partial send. Interrupted sends are retried.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int sendData(int *socket, const char *buffer, int bytesToSend);
+ --
+ -- RETURNS: the bytes written to the specified socket, -1 on failure with
+ --          errno set
+ --
+ -- NOTES:
+ -- This is the wrapper function for sending a char buffer to a socket using
+ -- send.
+ */
+int sendData(int *socket, const char *buffer, int bytesToSend)
+{
+    int sent = 0;
+    int sentTotal = 0;
+    
+    while (sentTotal < bytesToSend)
+    {
+        sent = send(*socket, buffer + sentTotal, bytesToSend - sentTotal,
+                    MSG_NOSIGNAL);
+        countSent(sent);
+        if (sent == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        sentTotal += sent;
+    }
+    
+    return sentTotal;
+}
+
+/*
+ -- FUNCTION: readLine
+ --
+ -- DATE: February 11, 2012
+ --
+ -- REVISIONS: October 18, 2026 - Turns quick ACK back on when the tuning asks
+ -- for it.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int readLine(int *socket, char *buffer, int maxBytesToRead);
+ --
+ -- RETURNS: the number of bytes read
+ --
+ -- NOTES:
+ -- This is the wrapper function for reading a line from a socket. The function
+ -- will continue to read from the socket until the maximum bytes to read has
+ -- been met, or the buffer reaches a new line.
+ */
+int readLine(int *socket, char *buffer, int maxBytesToRead)
+{
+    int count = 0;
+    int bytesRead = 0;
+    
+    for (count = 0; count < maxBytesToRead; count++)
+    {
+        bytesRead = recv(*socket, &buffer[count], 1, MSG_WAITALL);
+        countSyscall(bytesRead);
+        if (bytesRead == 1)
+        {
+            /* Get out of the read if we find the new line */
+            if (buffer[count] == '\n')
+            {
+                break;
+            }
+        }
+        else if (bytesRead == 0)
+        {
+            /* EOF, no data read */
+            if (count == 0)
+            {
+                return 0;
+            }
+            else
+            {
+                break;
+            }
+        }
+        else
+        {
+            return -1;
+        }
+    }
+    
+    /* Quick ACK mode does not stick, so it is turned back on after a read */
+    if (tuning.quickAck > 0)
+    {
+        setsockopt(*socket, IPPROTO_TCP, TCP_QUICKACK, &tuning.quickAck,
+                   sizeof(int));
+        countSyscall(0);
+    }
+    
+    return count;
+}
+
+/*
+ -- FUNCTION: readAvailable
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int readAvailable(int *socket, char *buffer,
+ --                              int maxBytesToRead);
+ --
+ -- RETURNS: the number of bytes read, 0 on EOF, -1 on failure
+ --
+ -- NOTES:
+ -- Reads whatever is waiting on a non blocking socket in one call, up to the
+ -- maximum. When nothing is waiting it returns -1 with errno set to EAGAIN.
+ */
+int readAvailable(int *socket, char *buffer, int maxBytesToRead)
+{
+    int bytesRead = recv(*socket, buffer, maxBytesToRead, 0);
+    
+    countSyscall(bytesRead);
+    if (bytesRead > 0 && tuning.quickAck > 0)
+    {
+        setsockopt(*socket, IPPROTO_TCP, TCP_QUICKACK, &tuning.quickAck,
+                   sizeof(int));
+        countSyscall(0);
+    }
+    
+    return bytesRead;
+}
+
+/*
+ -- FUNCTION: inputWaiting
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int inputWaiting(int *socket);
+ --
+ -- RETURNS: 1 if a read would not block, 0 otherwise
+ --
+ -- NOTES:
+ -- Peeks at a socket without blocking, even if the socket blocks. The end of
+ -- the stream and errors count as input, since the next read returns them
+ -- straight away.
+ */
+int inputWaiting(int *socket)
+{
+    char next = 0;
+    int bytesRead = recv(*socket, &next, 1, MSG_PEEK | MSG_DONTWAIT);
+    
+    countSyscall(0);
+    
+    return bytesRead >= 0 || errno != EAGAIN;
+}
+
+/*
+ -- FUNCTION: closeSocket
+ --
+ -- DATE: March 13, 2011
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int closeSocket(int *socket);
+ --
+ -- RETURNS: the result of the close function
+ --
+ -- NOTES:
+ -- This is the wrapper function for closing a file descriptor.
+ */
+int closeSocket(int *socket)
+{
+    return close(*socket);
+}
+
+/*
+ -- FUNCTION: connectToServer
+ --
+ -- DATE: March 14, 2011
+ --
+ -- REVISIONS: October 18, 2026 - Applies the socket tuning, including fast
+ -- open on the connect when it is turned on.
+ -- October 18, 2026 - An address starting with a slash is the path of a
+ -- UNIX domain socket, and the port is not used.
+ -- October 18, 2026 - Connects over IPv6 as well as IPv4, and from the next
+ -- source address when there are any.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int connectToServer(int *port, int *socket, const char *ip);
+ --
+ -- RETURNS: the result of the connect function or gethostbyname if it fails
+ --
+ -- NOTES:
+ -- This is the wrapper function for connecting to a server.
+ */
+int connectToServer(const char *port, int *sock, const char *ip)
+{
+    struct addrinfo hints;
+    struct addrinfo *result;
+    struct addrinfo *rp;
+    
+    if (ip[0] == '/')
+    {
+        return connectToPath(ip, sock);
+    }
+    
+    memset(&hints, 0, sizeof(struct addrinfo));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    
+    if (getaddrinfo(ip, port, &hints, &result) != 0)
+    {
+        return -1;
+    }
+    
+    for (rp = result; rp != NULL; rp = rp->ai_next)
+    {
+        *sock = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+        
+        if (*sock == -1)
+            continue;
+        
+        tuneBuffers(*sock);
+        
+        /* Send the first request in the SYN when the server allows it */
+        if (tuning.fastOpen > 0)
+        {
+            setsockopt(*sock, IPPROTO_TCP, TCP_FASTOPEN_CONNECT,
+                       &tuning.fastOpen, sizeof(int));
+        }
+        
+        countSyscall(0);
+        if (bindSource(*sock, rp->ai_family) != -1 &&
+            connect(*sock, rp->ai_addr, rp->ai_addrlen) != -1)
+            break;
+        
+        close(*sock);
+    }
+    
+    if (rp == NULL)
+    {
+        freeaddrinfo(result);
+        return -1;
+    }
+    
+    freeaddrinfo(result);
+    
+    tuneConnection(*sock);
+    
+    return *sock;
+/*
+    struct sockaddr_in address;
+    struct hostent *hp;
+    
+    memset(&address, '\0', sizeof(struct sockaddr_in));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(*port);
+    if ((hp = gethostbyname(&(*ip))) == NULL)
+    {
+        return -1;
+    }
+    memcpy(&address.sin_addr, hp->h_addr, hp->h_length);
+    
+    return connect(*socket, (struct sockaddr *)&address, sizeof(address));*/
+}
+
+/*
+ -- FUNCTION: makeSocketNonBlocking
+ --
+ -- DATE: September 22, 2011
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int makeSocketNonBlocking(int *socket);
+ --
+ -- RETURNS: the result of the fcntl function
+ --
+ -- NOTES:
+ -- This is the wrapper function for setting the non blocking flag on the socket
+ -- desriptor.
+ */
+int makeSocketNonBlocking(int *socket)
+{
+    int flags = 0;
+    
+    // Get the current flags off the socket
+    flags = fcntl(*socket, F_GETFL, 0);
+    
+    // Make sure we did not encounter an error
+    if (flags == -1)
+    {
+        return -1;
+    }
+    
+    // Set the flags to non blocking
+    flags |= O_NONBLOCK;
+    
+    return fcntl(*socket, F_SETFL, flags);
+}
+
+/*
+ -- FUNCTION: makeSocketBlocking
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int makeSocketBlocking(int *socket);
+ --
+ -- RETURNS: the result of the fcntl function
+ --
+ -- NOTES:
+ -- Clears the non blocking flag set by makeSocketNonBlocking.
+ */
+int makeSocketBlocking(int *socket)
+{
+    int flags = 0;
+    
+    // Get the current flags off the socket
     flags = fcntl(*socket, F_GETFL, 0);
     
-    // Make sure we did not encounter an error
-    if (flags == -1)
+    // Make sure we did not encounter an error
+    if (flags == -1)
+    {
+        return -1;
+    }
+    
+    // Clear the non blocking flag
+    flags &= ~O_NONBLOCK;
+    
+    return fcntl(*socket, F_SETFL, flags);
+}
+
+/*
+ -- FUNCTION: setReusePort
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int setReusePort(int *socket);
+ --
+ -- RETURNS: the result of the setsockopt function
+ --
+ -- NOTES:
+ -- Lets several listening sockets bind the same port, with the kernel
+ -- spreading new connections between them. Must be set before the bind.
+ */
+int setReusePort(int *socket)
+{
+    int value = 1;
+    return setsockopt(*socket, SOL_SOCKET, SO_REUSEPORT, &value,
+                      sizeof(value));
+}
+
+/*
+ -- FUNCTION: steerByCpu
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int steerByCpu(int *socket, const unsigned int *indexOfCpu,
+ --                           unsigned int cpus);
+ --
+ -- RETURNS: the result of the setsockopt function
+ --
+ -- NOTES:
+ -- Attaches a classic BPF program to a group of SO_REUSEPORT sockets that
+ -- picks the socket by the CPU that received the connection's packets. The
+ -- program loads the CPU number and compares it against each CPU in turn,
+ -- returning indexOfCpu[cpu], where the index is the position the socket was
+ -- bound in within the group. CPUs past the end of the table get an index that
+ -- is out of range, which makes the kernel fall back to its normal hash. The
+ -- program is shared by the whole group, so it only has to be attached to one
+ -- of the sockets, after they have all been bound.
+ */
+int steerByCpu(int *socket, const unsigned int *indexOfCpu, unsigned int cpus)
+{
+    int result = 0;
+    unsigned int cpu = 0;
+    unsigned int length = 0;
+    struct sock_filter *code = 0;
+    struct sock_fprog program;
+    
+    /* One load, a compare and return for each CPU and the fall back return */
+    if (cpus > (BPF_MAXINSNS - 2) / 2 ||
+        (code = malloc(sizeof(struct sock_filter) * (cpus * 2 + 2))) == NULL)
+    {
+        return -1;
+    }
+    
+    code[length++] = (struct sock_filter)BPF_STMT(BPF_LD | BPF_W | BPF_ABS,
+                                                  SKF_AD_OFF + SKF_AD_CPU);
+    for (cpu = 0; cpu < cpus; cpu++)
+    {
+        code[length++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ |
+                                                      BPF_K, cpu, 0, 1);
+        code[length++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K,
+                                                      indexOfCpu[cpu]);
+    }
+    code[length++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, 0xffffffff);
+    
+    program.len = length;
+    program.filter = code;
+    
+    result = setsockopt(*socket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                        &program, sizeof(program));
+    
+    free(code);
+    
+    return result;
+}
+
+/*
+ -- FUNCTION: incomingCpu
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int incomingCpu(int *socket);
+ --
+ -- RETURNS: the CPU, or -1 if it is not known
+ --
+ -- NOTES:
+ -- Gets the CPU that last processed packets for the socket in softirq. For a
+ -- newly accepted socket this is the CPU that took the handshake, which is
+ -- normally where the rest of the connection's packets arrive too.
+ */
+int incomingCpu(int *socket)
+{
+    int cpu = -1;
+    socklen_t length = sizeof(cpu);
+    
+    if (getsockopt(*socket, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &length) == -1)
+    {
+        return -1;
+    }
+    
+    return cpu;
+}
+
+/*
+ -- FUNCTION: setBusyPoll
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int setBusyPoll(int *socket, int microseconds);
+ --
+ -- RETURNS: the result of the setsockopt function, -1 if not supported
+ --
+ -- NOTES:
+ -- Makes reads that find the socket empty poll the device receive queue for
+ -- up to the given time before sleeping. Raising it above the system default
+ -- needs CAP_NET_ADMIN, so callers should treat a failure as a hint to go
+ -- without it.
+ */
+int setBusyPoll(int *socket, int microseconds)
+{
+#ifdef SO_BUSY_POLL
+    return setsockopt(*socket, SOL_SOCKET, SO_BUSY_POLL, &microseconds,
+                      sizeof(microseconds));
+#else
+    (void)socket;
+    (void)microseconds;
+    return -1;
+#endif
+}
+
+/*
+ -- FUNCTION: loadSocketTuning
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Added the listen backlog.
+ -- October 18, 2026 - An option without a value is an error.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int loadSocketTuning(const char *path, char *error,
+ --                                 size_t errorLength);
+ --
+ -- RETURNS: 0 on success, -1 on failure with a message in error
+ --
+ -- NOTES:
+ -- Reads a tuning profile and makes it the tuning for every socket the
+ -- process opens from then on. A profile has one option and value per line:
+ --
+ --     # comment
+ --     nodelay 1
+ --     sndbuf 262144
+ --     rcvbuf 262144
+ --     quickack 1
+ --     defer_accept 1
+ --     fastopen 256
+ --     notsent_lowat 16384
+ --     backlog 4096
+ --
+ -- An option that is left out, or given as "default", is left at the
+ -- system's setting. Without a profile only TCP_NODELAY is set.
+ */
+int loadSocketTuning(const char *path, char *error, size_t errorLength)
+{
+    FILE *file = 0;
+    char line[NETWORK_BUFFER_SIZE];
+    char name[64];
+    char value[64];
+    char *end = 0;
+    int number = 0;
+    int lineNumber = 0;
+    int fields = 0;
+    int *field = 0;
+    socketTuning loaded = {-1, -1, -1, -1, -1, -1, -1, -1};
+    
+    if ((file = fopen(path, "r")) == NULL)
     {
+        snprintf(error, errorLength, "Unable to open %s", path);
         return -1;
     }
     
-    // Set the flags to non blocking
-    flags |= O_NONBLOCK;
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        lineNumber++;
+        fields = sscanf(line, "%63s %63s", name, value);
+        if (fields < 1 || name[0] == '#')
+        {
+            continue;
+        }
+        if (fields != 2)
+        {
+            snprintf(error, errorLength, "%s:%d: missing value for %s", path,
+                     lineNumber, name);
+            fclose(file);
+            return -1;
+        }
+        
+        if (strcmp(name, "nodelay") == 0)
+        {
+            field = &loaded.noDelay;
+        }
+        else if (strcmp(name, "sndbuf") == 0)
+        {
+            field = &loaded.sendBuffer;
+        }
+        else if (strcmp(name, "rcvbuf") == 0)
+        {
+            field = &loaded.receiveBuffer;
+        }
+        else if (strcmp(name, "quickack") == 0)
+        {
+            field = &loaded.quickAck;
+        }
+        else if (strcmp(name, "defer_accept") == 0)
+        {
+            field = &loaded.deferAccept;
+        }
+        else if (strcmp(name, "fastopen") == 0)
+        {
+            field = &loaded.fastOpen;
+        }
+        else if (strcmp(name, "notsent_lowat") == 0)
+        {
+            field = &loaded.notSentLowat;
+        }
+        else if (strcmp(name, "backlog") == 0)
+        {
+            field = &loaded.backlog;
+        }
+        else
+        {
+            snprintf(error, errorLength, "%s:%d: unknown option %s", path,
+                     lineNumber, name);
+            fclose(file);
+            return -1;
+        }
+        
+        if (strcmp(value, "default") == 0)
+        {
+            *field = -1;
+            continue;
+        }
+        
+        number = strtol(value, &end, 10);
+        if (end == value || *end != '\0' || number < 0)
+        {
+            snprintf(error, errorLength, "%s:%d: bad value for %s", path,
+                     lineNumber, name);
+            fclose(file);
+            return -1;
+        }
+        *field = number;
+    }
     
-    return fcntl(*socket, F_SETFL, flags);
+    fclose(file);
+    memcpy(&tuning, &loaded, sizeof(socketTuning));
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: describeSocketTuning
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Added the listen backlog.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int describeSocketTuning(char *text, size_t length);
+ --
+ -- RETURNS: the length of the description
+ --
+ -- NOTES:
+ -- Writes the options that are being set as key=value pairs, in the same form
+ -- as the profile, so they can go into benchmark output.
+ */
+int describeSocketTuning(char *text, size_t length)
+{
+    int used = 0;
+    unsigned int index = 0;
+    const int values[8] = {tuning.noDelay, tuning.sendBuffer,
+                           tuning.receiveBuffer, tuning.quickAck,
+                           tuning.deferAccept, tuning.fastOpen,
+                           tuning.notSentLowat, tuning.backlog};
+    static const char *names[8] = {"nodelay", "sndbuf", "rcvbuf", "quickack",
+                                   "defer_accept", "fastopen",
+                                   "notsent_lowat", "backlog"};
+    
+    text[0] = '\0';
+    
+    for (index = 0; index < 8 && used < (int)length; index++)
+    {
+        if (values[index] != -1)
+        {
+            used += snprintf(text + used, length - used, "%s%s=%d",
+                             used ? " " : "", names[index], values[index]);
+        }
+    }
+    
+    if (used == 0)
+    {
+        used = snprintf(text, length, "system defaults");
+    }
+    
+    return (used < (int)length) ? used : (int)length - 1;
+}
+
+/*
+ -- FUNCTION: setNetworkCounters
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void setNetworkCounters(networkCounters *counters);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Counts the system calls the calling thread makes through the wrappers in
+ -- the given counters from now on, or stops counting them if it is NULL. Only
+ -- the calling thread writes to the counters.
+ */
+void setNetworkCounters(networkCounters *threadCounters)
+{
+    counters = threadCounters;
+}
+
+/*
+ -- FUNCTION: countSyscall
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void countSyscall(long bytes);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Counts one system call that moved the given bytes in the calling thread's
+ -- counters. A failed call passes -1 and is counted with no bytes. Used by
+ -- the wrappers, and by callers for the system calls they make directly.
+ */
+void countSyscall(long bytes)
+{
+    if (counters != NULL)
+    {
+        counters->syscalls++;
+        counters->bytes += (bytes > 0) ? bytes : 0;
+    }
+}
+
+/*
+ -- FUNCTION: countSent
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void countSent(long bytes);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Counts one system call that sent the given bytes to a socket. The bytes
+ -- are counted as moved, like countSyscall, and as sent.
+ */
+void countSent(long bytes)
+{
+    if (counters != NULL)
+    {
+        counters->syscalls++;
+        counters->bytes += (bytes > 0) ? bytes : 0;
+        counters->sent += (bytes > 0) ? bytes : 0;
+    }
+}
+
+/*
+ -- FUNCTION: tuneBuffers
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void tuneBuffers(int socket);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Sets the buffer sizes on a new socket. This has to happen before it
+ -- listens or connects, as the window scale is agreed during the handshake.
+ -- Accepted sockets inherit the sizes from the listening socket.
+ */
+static void tuneBuffers(int socket)
+{
+    if (tuning.sendBuffer != -1)
+    {
+        setsockopt(socket, SOL_SOCKET, SO_SNDBUF, &tuning.sendBuffer,
+                   sizeof(int));
+    }
+    if (tuning.receiveBuffer != -1)
+    {
+        setsockopt(socket, SOL_SOCKET, SO_RCVBUF, &tuning.receiveBuffer,
+                   sizeof(int));
+    }
+}
+
+/*
+ -- FUNCTION: tuneConnection
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void tuneConnection(int socket);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Sets the options that apply to an open connection, on both the accepting
+ -- and connecting sides. With the request then reply pattern used here Nagle
+ -- holds back small writes until the delayed ACK for the last one arrives,
+ -- which is what TCP_NODELAY and TCP_QUICKACK are for.
+ */
+static void tuneConnection(int socket)
+{
+    if (socket == -1)
+    {
+        return;
+    }
+    
+    if (tuning.noDelay != -1)
+    {
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &tuning.noDelay,
+                   sizeof(int));
+    }
+    if (tuning.quickAck != -1)
+    {
+        setsockopt(socket, IPPROTO_TCP, TCP_QUICKACK, &tuning.quickAck,
+                   sizeof(int));
+    }
+    if (tuning.notSentLowat != -1)
+    {
+        setsockopt(socket, IPPROTO_TCP, TCP_NOTSENT_LOWAT,
+                   &tuning.notSentLowat, sizeof(int));
+    }
+}
+
+/*
+ -- FUNCTION: socketDomain
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int socketDomain(int socket)
+ --
+ -- RETURNS: the address family of the socket, or -1 on failure
+ --
+ -- NOTES:
+ -- Asks the socket for its domain. This is a system call, so it is only made
+ -- when a socket is set up, never per connection.
+ */
+static int socketDomain(int socket)
+{
+    int domain = 0;
+    socklen_t length = sizeof(domain);
+    
+    if (getsockopt(socket, SOL_SOCKET, SO_DOMAIN, &domain, &length) == -1)
+    {
+        return -1;
+    }
+    
+    return domain;
+}
+
+/*
+ -- FUNCTION: connectToPath
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int connectToPath(const char *path, int *sock)
+ --
+ -- RETURNS: the connected socket, or -1 on failure
+ --
+ -- NOTES:
+ -- Connects to a server listening on a UNIX domain socket at the path. The
+ -- buffer sizes of the tuning are set, the TCP options are not.
+ */
+static int connectToPath(const char *path, int *sock)
+{
+    struct sockaddr_un address;
+    
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    
+    memset(&address, 0, sizeof(struct sockaddr_un));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    
+    if ((*sock = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+    {
+        return -1;
+    }
+    tuneBuffers(*sock);
+    
+    countSyscall(0);
+    if (connect(*sock, (struct sockaddr *)&address, sizeof(address)) == -1)
+    {
+        close(*sock);
+        *sock = -1;
+        return -1;
+    }
+    
+    return *sock;
+}
+
+/*
+ -- FUNCTION: bindSource
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int bindSource(int socket, int family)
+ --
+ -- RETURNS: 0 on success or when there are no sources, -1 on failure
+ --
+ -- NOTES:
+ -- Binds a socket about to connect to the next source address of its family.
+ -- The sources are taken in turn by every thread, so the connections are
+ -- spread evenly over them. A family with no source address is left to the
+ -- system.
+ */
+static int bindSource(int socket, int family)
+{
+    int tries = 0;
+    int noPort = 1;
+    const networkAddress *source = 0;
+    
+    for (tries = 0; tries < sourceCount; tries++)
+    {
+        source = &sources[__sync_fetch_and_add(&nextSource, 1) % sourceCount];
+        if (source->address.ss_family == family)
+        {
+            setsockopt(socket, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &noPort,
+                       sizeof(noPort));
+            return bind(socket, (const struct sockaddr *)&source->address,
+                        source->length);
+        }
+    }
+    
+    return 0;
 }
@@ -5,14 +5,59 @@
 #define NETWORK_BUFFER_SIZE 1024
 #define LOCAL_BUFFER_SIZE 1024
 #define DEFAULT_PORT 8989
+#define NETWORK_ADDRESS_SIZE 108
+#define NETWORK_MAX_ADDRESSES 16
+
+#include <stddef.h>
+#include <sys/socket.h>
+
+/* An IPv4 or IPv6 address to listen on or connect from, port not included */
+typedef struct
+{
+    struct sockaddr_storage address;
+    socklen_t length;
+} networkAddress;
+
+/* Socket options set by the wrappers, -1 leaves an option at the default */
+typedef struct
+{
+    int noDelay;
+    int sendBuffer;
+    int receiveBuffer;
+    int quickAck;
+    int deferAccept;
+    int fastOpen;
+    int notSentLowat;
+    int backlog;
+} socketTuning;
+
+/* System calls made through the wrappers by one thread */
+typedef struct
+{
+    unsigned long long syscalls;
+    unsigned long long bytes;
+    unsigned long long sent;
+} networkCounters;
 
 /* Function Prototypes */
 #ifdef __cplusplus
 extern "C" {
 #endif
     int tcpSocket();
+    int streamSocket();
+    int setUnixPath(const char *path);
+    const char *getUnixPath();
     int setReuse(int* socket);
     int bindAddress(int *port, int *socket);
+    int bindLoopback(int *port, int *socket);
+    int bindAddressTo(const networkAddress *address, int *port, int *socket);
+    int addressSocket(const networkAddress *address);
+    int parseAddress(const char *text, networkAddress *address);
+    int parseAddressList(const char *text, networkAddress *addresses,
+                         int *counts, int most);
+    int describeAddress(const networkAddress *address, char *text,
+                        size_t length);
+    int setSourceAddresses(const char *list);
     int setListen(int *socket);
     int acceptConnection(int *listenSocket);
     int acceptConnectionIp(int *listenSocket, char* ip);
@@ -20,9 +65,22 @@ extern "C" {
     int readData(int *socket, char *buffer, int bytesToRead);
     int sendData(int *socket, const char *buffer, int bytesToSend);
     int readLine(int *socket, char *buffer, int maxBytesToRead);
+    int readAvailable(int *socket, char *buffer, int maxBytesToRead);
+    int inputWaiting(int *socket);
     int closeSocket(int *socket);
     int connectToServer(const char *port, int *socket, const char *ip);
     int makeSocketNonBlocking(int *socket);
+    int makeSocketBlocking(int *socket);
+    int setReusePort(int *socket);
+    int steerByCpu(int *socket, const unsigned int *indexOfCpu,
+                   unsigned int cpus);
+    int incomingCpu(int *socket);
+    int setBusyPoll(int *socket, int microseconds);
+    int loadSocketTuning(const char *path, char *error, size_t errorLength);
+    int describeSocketTuning(char *text, size_t length);
+    void setNetworkCounters(networkCounters *counters);
+    void countSyscall(long bytes);
+    void countSent(long bytes);
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,431 @@
+/*-----------------------------------------------------------------------------
+ --	SOURCE FILE:    report.c - Summarizes, merges and compares results files
+ --
+ --	PROGRAM:		Web Client Emulator
+ --
+ --	FUNCTIONS:
+ --                 int main(int argc, char **argv);
+ --                 int summarize(int count, char **paths);
+ --                 int merge(int count, char **paths, const char *output);
+ --                 int compare(const char *first, const char *second);
+ --                 static int loadRuns(const char *argument, runList *list);
+ --                 static void releaseRuns(runList *list);
+ --
+ --	DATE:			October 18, 2026
+ --
+ --	REVISIONS:		(Date and Description)
+ --
+ --	DESIGNERS:      Luke Queenan
+ --
+ --	PROGRAMMERS:	Luke Queenan
+ --
+ --	NOTES:
+ -- The reporting tool for the binary results files written by the client.
+ --
+ --     report.out summary FILE[@RUN]...
+ --     report.out merge [-o OUTPUT] FILE[@RUN]...
+ --     report.out diff FILE[@RUN] FILE[@RUN]
+ --
+ -- A file on its own means every run in the file, and FILE@N picks out run N,
+ -- counting from zero, or from the end if N is negative. summary prints each
+ -- run. merge treats the runs as having been made at the same time, such as by
+ -- several client machines against one server, so counts and histograms are
+ -- added and the duration is the longest of the runs; with -o the merged run
+ -- is appended to a new results file, interval by interval. diff compares two
+ -- runs, which defaults to the last run of each file. Files are mapped rather
+ -- than read, and only the non empty histogram buckets are touched, so even
+ -- very long runs are summarized quickly.
+ ----------------------------------------------------------------------------*/
+
+/* System includes */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* User includes */
+#include "results.h"
+#include "summary.h"
+
+/* Files stay mapped while their runs are in use */
+static resultsFile fileList[64];
+static unsigned int files = 0;
+
+int main(int argc, char **argv);
+int summarize(int count, char **paths);
+int merge(int count, char **paths, const char *output);
+int compare(const char *first, const char *second);
+static int loadRuns(const char *argument, runList *list);
+static void releaseRuns(runList *list);
+
+/*
+ -- FUNCTION: main
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int main(argc, char **argv)
+ --
+ -- RETURNS: 0 on success
+ --
+ -- NOTES:
+ -- This is the main entry point for the report tool
+ */
+int main(int argc, char **argv)
+{
+    int option = 0;
+    const char *output = 0;
+
+    if (argc < 3)
+    {
+        fprintf(stderr, "Usage: %s summary|merge|diff [-o output] "
+                "file[@run]...\n", argv[0]);
+        return 1;
+    }
+
+    /* Options come after the command */
+    optind = 2;
+    while ((option = getopt(argc, argv, "o:")) != -1)
+    {
+        switch (option)
+        {
+            case 'o':
+                output = optarg;
+                break;
+            default:
+                return 1;
+        }
+    }
+
+    if (strcmp(argv[1], "summary") == 0)
+    {
+        return summarize(argc - optind, argv + optind);
+    }
+    if (strcmp(argv[1], "merge") == 0)
+    {
+        return merge(argc - optind, argv + optind, output);
+    }
+    if (strcmp(argv[1], "diff") == 0 && argc - optind == 2)
+    {
+        return compare(argv[optind], argv[optind + 1]);
+    }
+
+    fprintf(stderr, "Unknown command %s\n", argv[1]);
+    return 1;
+}
+
+/*
+ -- FUNCTION: summarize
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int summarize(int count, char **paths)
+ --
+ -- RETURNS: 0 on success, 1 if a file could not be read
+ --
+ -- NOTES:
+ -- Prints a summary of every run picked out by the arguments.
+ */
+int summarize(int count, char **paths)
+{
+    int index = 0;
+    unsigned int run = 0;
+    runList list;
+
+    memset(&list, 0, sizeof(runList));
+
+    for (index = 0; index < count; index++)
+    {
+        if (loadRuns(paths[index], &list) == -1)
+        {
+            releaseRuns(&list);
+            return 1;
+        }
+    }
+
+    for (run = 0; run < list.count; run++)
+    {
+        printRun(list.runs[run]);
+    }
+
+    releaseRuns(&list);
+
+    return 0;
+}
+
+/*
+ -- FUNCTION: merge
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int merge(int count, char **paths, const char *output)
+ --
+ -- RETURNS: 0 on success, 1 on failure
+ --
+ -- NOTES:
+ -- Adds all of the picked runs together and prints the result. If an output
+ -- file is given the merged run is written to it, with interval N of the
+ -- merged run made up of interval N of every input run.
+ */
+int merge(int count, char **paths, const char *output)
+{
+    int index = 0;
+    int result = 0;
+    char config[RESULTS_CONFIG_SIZE];
+    runList list;
+    runSummary *merged = 0;
+    resultsWriter *writer = 0;
+
+    memset(&list, 0, sizeof(runList));
+
+    for (index = 0; index < count; index++)
+    {
+        if (loadRuns(paths[index], &list) == -1)
+        {
+            releaseRuns(&list);
+            return 1;
+        }
+    }
+
+    if (list.count == 0 || (merged = calloc(1, sizeof(runSummary))) == NULL)
+    {
+        fprintf(stderr, "No runs to merge\n");
+        releaseRuns(&list);
+        return 1;
+    }
+
+    snprintf(config, sizeof(config), "merged from %u runs", list.count);
+    merged->name = config;
+    mergeRuns(&list, merged);
+    printRun(merged);
+
+    if (output != 0)
+    {
+        if ((writer = malloc(sizeof(resultsWriter))) == NULL ||
+            openResults(writer, output) == -1)
+        {
+            fprintf(stderr, "Unable to write %s\n", output);
+            result = 1;
+        }
+        else if ((writeMergedRun(&list, writer, config) == -1) |
+                 (closeResults(writer, merged->endTime) == -1))
+        {
+            fprintf(stderr, "Unable to write %s\n", output);
+            result = 1;
+        }
+    }
+
+    free(writer);
+    free(merged);
+    releaseRuns(&list);
+
+    return result;
+}
+
+/*
+ -- FUNCTION: compare
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int compare(const char *first, const char *second)
+ --
+ -- RETURNS: 0 on success, 1 on failure
+ --
+ -- NOTES:
+ -- Prints the main figures of two runs side by side with the change from the
+ -- first to the second. Without a run number the last run of each file is
+ -- used.
+ */
+int compare(const char *first, const char *second)
+{
+    char argument[2][1024];
+    const char *paths[2];
+    unsigned int index = 0;
+    runList list;
+    runSummary *runs[2];
+    double values[2][8];
+    static const char *names[8] = {"Requests/s", "MB/s", "Mean us", "50% us",
+                                   "90% us", "99% us", "99.9% us", "Errors"};
+    static const double percentiles[4] = {50, 90, 99, 99.9};
+
+    paths[0] = first;
+    paths[1] = second;
+    memset(&list, 0, sizeof(runList));
+
+    for (index = 0; index < 2; index++)
+    {
+        /* Default to the last run in the file */
+        snprintf(argument[index], sizeof(argument[index]),
+                 strchr(paths[index], '@') ? "%s" : "%s@-1", paths[index]);
+
+        if (loadRuns(argument[index], &list) == -1 || list.count != index + 1)
+        {
+            fprintf(stderr, "No run in %s\n", paths[index]);
+            releaseRuns(&list);
+            return 1;
+        }
+        runs[index] = list.runs[index];
+    }
+
+    for (index = 0; index < 2; index++)
+    {
+        unsigned int percentile = 0;
+
+        values[index][0] = perSecond(runs[index]->total.requests,
+                                runs[index]->total.duration);
+        values[index][1] = perSecond(runs[index]->total.bytes,
+                                runs[index]->total.duration) / 1000000.0;
+        values[index][2] = runs[index]->latency.count ?
+                           runs[index]->latency.total / 1000.0 /
+                           runs[index]->latency.count : 0;
+        for (percentile = 0; percentile < 4; percentile++)
+        {
+            values[index][3 + percentile] =
+                histogramPercentile(&runs[index]->latency,
+                                    percentiles[percentile]) / 1000.0;
+        }
+        values[index][7] = runs[index]->total.errors;
+    }
+
+    printf("%-12s %14s %14s %9s\n", "", "first", "second", "change");
+    for (index = 0; index < 8; index++)
+    {
+        printf("%-12s %14.2f %14.2f", names[index], values[0][index],
+               values[1][index]);
+        if (values[0][index] != 0)
+        {
+            printf(" %+8.1f%%\n", (values[1][index] - values[0][index]) *
+                   100.0 / values[0][index]);
+        }
+        else
+        {
+            printf(" %9s\n", "-");
+        }
+    }
+
+    releaseRuns(&list);
+
+    return 0;
+}
+
+/*
+ -- FUNCTION: loadRuns
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int loadRuns(const char *argument, runList *list)
+ --
+ -- RETURNS: 0 on success, -1 on failure
+ --
+ -- NOTES:
+ -- Maps the file named by the argument and adds the runs it picks out to the
+ -- list.
+ */
+static int loadRuns(const char *argument, runList *list)
+{
+    char path[1024];
+    char *at = 0;
+    int wanted = -1;
+    int runs = 0;
+    size_t offset = 0;
+    const resultsRecord *record = 0;
+    resultsFile *file = 0;
+
+    snprintf(path, sizeof(path), "%s", argument);
+    if ((at = strrchr(path, '@')) != NULL)
+    {
+        *at = '\0';
+    }
+
+    if (files == sizeof(fileList) / sizeof(resultsFile))
+    {
+        fprintf(stderr, "Too many files\n");
+        return -1;
+    }
+
+    file = &fileList[files];
+    if (mapResults(path, file) == -1)
+    {
+        perror(path);
+        return -1;
+    }
+    files++;
+
+    /* Count the runs so that negative run numbers can be resolved */
+    if (at != NULL)
+    {
+        while ((record = nextRecord(file, &offset)) != NULL)
+        {
+            runs += (record->type == RESULTS_RUN);
+        }
+        wanted = atoi(at + 1);
+        if (wanted < 0)
+        {
+            wanted += runs;
+        }
+        if (wanted < 0 || wanted >= runs)
+        {
+            fprintf(stderr, "%s has no run %s\n", path, at + 1);
+            return -1;
+        }
+    }
+
+    return (addRuns(list, file, argument, wanted) == -1) ? -1 : 0;
+}
+
+/*
+ -- FUNCTION: releaseRuns
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void releaseRuns(runList *list)
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Frees the runs and unmaps the files they came from.
+ */
+static void releaseRuns(runList *list)
+{
+    freeRuns(list);
+
+    while (files > 0)
+    {
+        unmapResults(&fileList[--files]);
+    }
+}
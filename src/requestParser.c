@@ -0,0 +1,447 @@
+/*
+ -- SOURCE FILE: requestParser.c
+ --
+ -- PROGRAM: Web Client Emulator
+ --
+ -- FUNCTIONS:
+ -- int parseRequests(const char *buffer, int length, int largest,
+ --                   requestBatch *batch);
+ -- int requestSize(const char *line, int largest);
+ -- const char *requestParserName();
+ -- static void chooseFinder();
+ -- static int findNewlinesScalar(const char *buffer, int length, int *ends,
+ --                               int most);
+ -- static int findNewlinesSse2(const char *buffer, int length, int *ends,
+ --                             int most);
+ -- static int findNewlinesAvx2(const char *buffer, int length, int *ends,
+ --                             int most);
+ -- static int convertLine(const char *line, int length, int largest);
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - A line may end in a carriage return, and a
+ -- malformed line no longer loses the good lines before it.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- NOTES:
+ -- Parses the requests the servers read, which are a decimal byte count or a
+ -- file path on a line each. A pipelining client leaves many of them in one
+ -- read, and taking them a line at a time with strchr and atol showed up in
+ -- profiles.
+ --
+ -- parseRequests works on a whole buffer in two passes. The first finds the
+ -- end of every line, comparing 32 bytes at a time with AVX2 or 16 at a time
+ -- with SSE2 and turning the matches into a bit mask, which is walked with
+ -- count trailing zeros. The instruction set is picked once, from what the
+ -- CPU supports, and other machines get a byte at a time loop. The second
+ -- pass converts every line to its size. The lines are a few digits long, so
+ -- this is plain code, but it does not branch on the bytes: a bad digit, a
+ -- line too long or a size out of bounds each set a flag that is tested once
+ -- for the whole batch.
+ --
+ -- Malformed input is returned as an error for the server to close that one
+ -- connection on, where atol used to let it through to the bounds check and
+ -- a systemFatal. The lines before it are still returned, so the server can
+ -- answer them first the way it did when it took a line at a time. A line
+ -- ending in a carriage return is taken as if it did not, as atol did.
+ */
+
+// Includes
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "requestParser.h"
+
+/* Finds the ends of up to most lines in a buffer */
+typedef int (*newlineFinder)(const char *buffer, int length, int *ends,
+                             int most);
+
+static void chooseFinder();
+static int findNewlinesScalar(const char *buffer, int length, int *ends,
+                              int most);
+static int convertLine(const char *line, int length, int largest);
+
+#if defined(__x86_64__) || defined(__i386__)
+static int findNewlinesSse2(const char *buffer, int length, int *ends,
+                            int most) __attribute__((target("sse2")));
+static int findNewlinesAvx2(const char *buffer, int length, int *ends,
+                            int most) __attribute__((target("avx2")));
+#endif
+
+/* The finder for this CPU, picked on first use */
+static newlineFinder findNewlines = 0;
+static const char *finderName = "scalar";
+
+/*
+ -- FUNCTION: parseRequests
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Returns the lines before a malformed one
+ -- and sets malformed, instead of failing the whole batch.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int parseRequests(const char *buffer, int length, int largest,
+ --                              requestBatch *batch);
+ --
+ -- RETURNS: the number of sizes parsed
+ --
+ -- NOTES:
+ -- Parses up to REQUEST_BATCH complete lines from the start of the buffer.
+ -- Each line found has the offset just past its new line in ends and its
+ -- size, from 1 to largest, in sizes. A partial line at the end is left
+ -- alone. Fewer than REQUEST_BATCH lines means there are no more complete
+ -- ones.
+ --
+ -- A line starting with a slash is a file request. Parsing stops at it, and
+ -- fileEnd is set to the offset past its new line, so the caller can serve
+ -- it and parse on from there. fileEnd is 0 when there is none.
+ --
+ -- A malformed line also stops parsing. The lines before it are returned as
+ -- usual and malformed is set, and the caller answers them and then closes
+ -- the connection. malformed is 0 otherwise.
+ */
+int parseRequests(const char *buffer, int length, int largest,
+                  requestBatch *batch)
+{
+    int index = 0;
+    int start = 0;
+    int count = 0;
+    int size = 0;
+    int invalid = 0;
+    
+    if (findNewlines == NULL)
+    {
+        chooseFinder();
+    }
+    
+    batch->fileEnd = 0;
+    batch->malformed = 0;
+    count = findNewlines(buffer, length, batch->ends, REQUEST_BATCH);
+    
+    for (index = 0; index < count; index++)
+    {
+        if (buffer[start] == '/')
+        {
+            batch->fileEnd = batch->ends[index];
+            break;
+        }
+        size = convertLine(buffer + start, batch->ends[index] - 1 - start,
+                           largest);
+        batch->sizes[index] = size;
+        invalid |= size;
+        start = batch->ends[index];
+    }
+    batch->count = index;
+    
+    /* Only a failed line is negative, find the first one */
+    if (invalid < 0)
+    {
+        index = 0;
+        while (batch->sizes[index] >= 0)
+        {
+            index++;
+        }
+        batch->count = index;
+        batch->fileEnd = 0;
+        batch->malformed = 1;
+    }
+    
+    return batch->count;
+}
+
+/*
+ -- FUNCTION: requestSize
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int requestSize(const char *line, int largest);
+ --
+ -- RETURNS: the size asked for, or -1 if the line is not a size from 1 to
+ --          largest
+ --
+ -- NOTES:
+ -- Converts a single request line, without its new line, for the servers
+ -- that read a line at a time.
+ */
+int requestSize(const char *line, int largest)
+{
+    return convertLine(line, strlen(line), largest);
+}
+
+/*
+ -- FUNCTION: requestParserName
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: const char *requestParserName();
+ --
+ -- RETURNS: the instruction set lines are found with
+ --
+ -- NOTES:
+ -- For the servers to print at start up.
+ */
+const char *requestParserName()
+{
+    if (findNewlines == NULL)
+    {
+        chooseFinder();
+    }
+    
+    return finderName;
+}
+
+/*
+ -- FUNCTION: chooseFinder
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void chooseFinder();
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Picks the widest newline finder the CPU supports. Threads that race here
+ -- all pick the same one.
+ */
+static void chooseFinder()
+{
+    newlineFinder finder = findNewlinesScalar;
+    const char *name = "scalar";
+    
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        finder = findNewlinesAvx2;
+        name = "avx2";
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        finder = findNewlinesSse2;
+        name = "sse2";
+    }
+#endif
+    
+    finderName = name;
+    findNewlines = finder;
+}
+
+/*
+ -- FUNCTION: findNewlinesScalar
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int findNewlinesScalar(const char *buffer, int length,
+ --                                          int *ends, int most)
+ --
+ -- RETURNS: the number of lines found
+ --
+ -- NOTES:
+ -- Stores the offset past each of the first most new lines in ends, a byte
+ -- at a time.
+ */
+static int findNewlinesScalar(const char *buffer, int length, int *ends,
+                              int most)
+{
+    int offset = 0;
+    int count = 0;
+    
+    for (offset = 0; offset < length && count < most; offset++)
+    {
+        if (buffer[offset] == '\n')
+        {
+            ends[count++] = offset + 1;
+        }
+    }
+    
+    return count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/*
+ -- FUNCTION: findNewlinesSse2
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int findNewlinesSse2(const char *buffer, int length,
+ --                                        int *ends, int most)
+ --
+ -- RETURNS: the number of lines found
+ --
+ -- NOTES:
+ -- As findNewlinesScalar, 16 bytes at a time. The bytes after the last full
+ -- block are done a byte at a time.
+ */
+static int findNewlinesSse2(const char *buffer, int length, int *ends,
+                            int most)
+{
+    int offset = 0;
+    int count = 0;
+    unsigned int mask = 0;
+    __m128i newline = _mm_set1_epi8('\n');
+    
+    for (offset = 0; offset + 16 <= length; offset += 16)
+    {
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(
+            _mm_loadu_si128((const __m128i *)(buffer + offset)), newline));
+        while (mask != 0)
+        {
+            ends[count++] = offset + __builtin_ctz(mask) + 1;
+            if (count == most)
+            {
+                return count;
+            }
+            mask &= mask - 1;
+        }
+    }
+    
+    for (; offset < length && count < most; offset++)
+    {
+        if (buffer[offset] == '\n')
+        {
+            ends[count++] = offset + 1;
+        }
+    }
+    
+    return count;
+}
+
+/*
+ -- FUNCTION: findNewlinesAvx2
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int findNewlinesAvx2(const char *buffer, int length,
+ --                                        int *ends, int most)
+ --
+ -- RETURNS: the number of lines found
+ --
+ -- NOTES:
+ -- As findNewlinesScalar, 32 bytes at a time. The bytes after the last full
+ -- block are done a byte at a time.
+ */
+static int findNewlinesAvx2(const char *buffer, int length, int *ends,
+                            int most)
+{
+    int offset = 0;
+    int count = 0;
+    unsigned int mask = 0;
+    __m256i newline = _mm256_set1_epi8('\n');
+    
+    for (offset = 0; offset + 32 <= length; offset += 32)
+    {
+        mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+            _mm256_loadu_si256((const __m256i *)(buffer + offset)), newline));
+        while (mask != 0)
+        {
+            ends[count++] = offset + __builtin_ctz(mask) + 1;
+            if (count == most)
+            {
+                return count;
+            }
+            mask &= mask - 1;
+        }
+    }
+    
+    for (; offset < length && count < most; offset++)
+    {
+        if (buffer[offset] == '\n')
+        {
+            ends[count++] = offset + 1;
+        }
+    }
+    
+    return count;
+}
+#endif
+
+/*
+ -- FUNCTION: convertLine
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Leaves out a carriage return at the end.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int convertLine(const char *line, int length,
+ --                                   int largest)
+ --
+ -- RETURNS: the size on the line, or -1 if it is not a size from 1 to largest
+ --
+ -- NOTES:
+ -- Converts a line of decimal digits. Every byte is converted whether it is
+ -- a digit or not, and the checks are folded into one flag which turns the
+ -- result into -1, so the only branch is the loop over the bytes. A line
+ -- longer than REQUEST_DIGITS may have overflowed and fails on its length.
+ -- A carriage return at the end, from a client sending CRLF lines, is not
+ -- part of the size.
+ */
+static int convertLine(const char *line, int length, int largest)
+{
+    int index = 0;
+    unsigned int value = 0;
+    unsigned int digit = 0;
+    unsigned int bad = 0;
+    
+    length -= (length > 0 && line[length - 1] == '\r');
+    bad = (length < 1) | (length > REQUEST_DIGITS);
+    
+    for (index = 0; index < length; index++)
+    {
+        digit = (unsigned char)line[index] - '0';
+        bad |= (digit > 9);
+        value = value * 10 + digit;
+    }
+    bad |= (value - 1 >= (unsigned int)largest);
+    
+    return (int)(value | (0U - bad));
+}
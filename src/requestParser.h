@@ -0,0 +1,29 @@
+#ifndef REQUEST_PARSER_H
+#define REQUEST_PARSER_H
+
+/* Defines */
+#define REQUEST_BATCH 64
+#define REQUEST_DIGITS 9
+
+/* The request lines found in a buffer by one call to parseRequests */
+typedef struct
+{
+    int count;
+    int fileEnd;
+    int malformed;
+    int ends[REQUEST_BATCH];
+    int sizes[REQUEST_BATCH];
+} requestBatch;
+
+/* Function Prototypes */
+#ifdef __cplusplus
+extern "C" {
+#endif
+    int parseRequests(const char *buffer, int length, int largest,
+                      requestBatch *batch);
+    int requestSize(const char *line, int largest);
+    const char *requestParserName();
+#ifdef __cplusplus
+}
+#endif
+#endif
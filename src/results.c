@@ -0,0 +1,471 @@
+/*
+ -- SOURCE FILE: results.c
+ --
+ -- PROGRAM: Web Client Emulator
+ --
+ -- FUNCTIONS:
+ -- int openResults(resultsWriter *writer, const char *path);
+ -- int writeRunHeader(resultsWriter *writer, uint64_t startTime,
+ --                    const char *config);
+ -- int writeInterval(resultsWriter *writer, resultsInterval *interval,
+ --                   const histogram *latency);
+ -- int closeResults(resultsWriter *writer, uint64_t endTime);
+ -- int mapResults(const char *path, resultsFile *file);
+ -- void unmapResults(resultsFile *file);
+ -- const resultsRecord *nextRecord(const resultsFile *file, size_t *offset);
+ -- void readInterval(const resultsRecord *record, resultsInterval *interval,
+ --                   histogram *latency);
+ -- static int appendRecord(resultsWriter *writer, uint32_t type,
+ --                         const void *data, uint32_t length);
+ -- static int flushResults(resultsWriter *writer);
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- NOTES:
+ -- This file reads and writes the binary results format. A results file is
+ -- only ever appended to, so it can hold any number of runs. Each run is a
+ -- RESULTS_RUN record holding the configuration, host and start time,
+ -- followed by one RESULTS_INTERVAL record per reporting interval and a
+ -- RESULTS_END record if the run finished cleanly. Interval records carry the
+ -- counters for the interval and only the non empty latency buckets. Every
+ -- record is a multiple of eight bytes long, so the records of a mapped file
+ -- can be read in place. Records are written in host byte order; the magic
+ -- number in the run header shows if a file came from a different machine.
+ */
+
+// Includes
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "results.h"
+
+static int appendRecord(resultsWriter *writer, uint32_t type, const void *data,
+                        uint32_t length);
+static int flushResults(resultsWriter *writer);
+
+/*
+ -- FUNCTION: openResults
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int openResults(resultsWriter *writer, const char *path);
+ --
+ -- RETURNS: 0 on success, -1 on failure
+ --
+ -- NOTES:
+ -- Opens the results file for appending, creating it if it does not exist.
+ -- Earlier runs in the file are left alone.
+ */
+int openResults(resultsWriter *writer, const char *path)
+{
+    writer->used = 0;
+    writer->intervals = 0;
+    writer->fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0666);
+
+    return (writer->fd == -1) ? -1 : 0;
+}
+
+/*
+ -- FUNCTION: writeRunHeader
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int writeRunHeader(resultsWriter *writer, uint64_t startTime,
+ --                               const char *config);
+ --
+ -- RETURNS: 0 on success, -1 on failure
+ --
+ -- NOTES:
+ -- Starts a new run in the file. The start time is in nanoseconds since the
+ -- epoch and the config is a free form description of the run options. The
+ -- header is written straight through so that a run is visible in the file
+ -- as soon as it starts.
+ */
+int writeRunHeader(resultsWriter *writer, uint64_t startTime,
+                   const char *config)
+{
+    resultsRun run;
+
+    memset(&run, 0, sizeof(resultsRun));
+    run.magic = RESULTS_MAGIC;
+    run.version = RESULTS_VERSION;
+    run.startTime = startTime;
+    gethostname(run.host, sizeof(run.host) - 1);
+    strncpy(run.config, config, sizeof(run.config) - 1);
+
+    if (appendRecord(writer, RESULTS_RUN, &run, sizeof(resultsRun)) == -1)
+    {
+        return -1;
+    }
+
+    return flushResults(writer);
+}
+
+/*
+ -- FUNCTION: writeInterval
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int writeInterval(resultsWriter *writer,
+ --                              resultsInterval *interval,
+ --                              const histogram *latency);
+ --
+ -- RETURNS: 0 on success, -1 on failure
+ --
+ -- NOTES:
+ -- Appends an interval record. The index, bucket count and latency summary
+ -- fields of the interval are filled in from the writer and the histogram.
+ */
+int writeInterval(resultsWriter *writer, resultsInterval *interval,
+                  const histogram *latency)
+{
+    char record[sizeof(resultsInterval) +
+                HISTOGRAM_BUCKETS * sizeof(resultsBucket)];
+    resultsBucket *buckets = (resultsBucket *)(record +
+                                               sizeof(resultsInterval));
+    unsigned int bucket = 0;
+
+    interval->index = writer->intervals++;
+    interval->bucketCount = 0;
+    interval->latencyTotal = latency->total;
+    interval->latencyMaximum = latency->maximum;
+
+    for (bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+    {
+        if (latency->buckets[bucket] != 0)
+        {
+            buckets[interval->bucketCount].bucket = bucket;
+            buckets[interval->bucketCount].reserved = 0;
+            buckets[interval->bucketCount].count = latency->buckets[bucket];
+            interval->bucketCount++;
+        }
+    }
+
+    memcpy(record, interval, sizeof(resultsInterval));
+
+    return appendRecord(writer, RESULTS_INTERVAL, record,
+                        sizeof(resultsInterval) +
+                        interval->bucketCount * sizeof(resultsBucket));
+}
+
+/*
+ -- FUNCTION: closeResults
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int closeResults(resultsWriter *writer, uint64_t endTime);
+ --
+ -- RETURNS: 0 on success, -1 on failure
+ --
+ -- NOTES:
+ -- Ends the run, writes out anything still buffered and closes the file.
+ */
+int closeResults(resultsWriter *writer, uint64_t endTime)
+{
+    int result = 0;
+    resultsEnd end;
+
+    memset(&end, 0, sizeof(resultsEnd));
+    end.endTime = endTime;
+    end.intervals = writer->intervals;
+
+    if (appendRecord(writer, RESULTS_END, &end, sizeof(resultsEnd)) == -1 ||
+        flushResults(writer) == -1)
+    {
+        result = -1;
+    }
+
+    close(writer->fd);
+    writer->fd = -1;
+
+    return result;
+}
+
+/*
+ -- FUNCTION: mapResults
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int mapResults(const char *path, resultsFile *file);
+ --
+ -- RETURNS: 0 on success, -1 on failure
+ --
+ -- NOTES:
+ -- Maps a whole results file into memory read only, so the records can be
+ -- walked without copying them.
+ */
+int mapResults(const char *path, resultsFile *file)
+{
+    int fd = 0;
+    struct stat status;
+    void *data = 0;
+
+    file->data = 0;
+    file->size = 0;
+
+    if ((fd = open(path, O_RDONLY)) == -1)
+    {
+        return -1;
+    }
+
+    if (fstat(fd, &status) == -1)
+    {
+        close(fd);
+        return -1;
+    }
+
+    if (status.st_size > 0)
+    {
+        data = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            return -1;
+        }
+        madvise(data, status.st_size, MADV_SEQUENTIAL);
+        file->data = data;
+        file->size = status.st_size;
+    }
+
+    close(fd);
+
+    return 0;
+}
+
+/*
+ -- FUNCTION: unmapResults
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void unmapResults(resultsFile *file);
+ --
+ -- RETURNS: void
+ */
+void unmapResults(resultsFile *file)
+{
+    if (file->data != 0)
+    {
+        munmap((void *)file->data, file->size);
+    }
+    file->data = 0;
+    file->size = 0;
+}
+
+/*
+ -- FUNCTION: nextRecord
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: const resultsRecord *nextRecord(const resultsFile *file,
+ --                                            size_t *offset);
+ --
+ -- RETURNS: the record at offset, or NULL at the end of the file
+ --
+ -- NOTES:
+ -- Returns the record at the offset and moves the offset past it. A record
+ -- that runs off the end of the file, such as one cut short by a crash, ends
+ -- the walk.
+ */
+const resultsRecord *nextRecord(const resultsFile *file, size_t *offset)
+{
+    const resultsRecord *record = 0;
+
+    if (*offset + sizeof(resultsRecord) > file->size)
+    {
+        return NULL;
+    }
+
+    record = (const resultsRecord *)(file->data + *offset);
+    if (*offset + sizeof(resultsRecord) + record->length > file->size)
+    {
+        return NULL;
+    }
+
+    *offset += sizeof(resultsRecord) + record->length;
+
+    return record;
+}
+
+/*
+ -- FUNCTION: readInterval
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void readInterval(const resultsRecord *record,
+ --                              resultsInterval *interval,
+ --                              histogram *latency);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Copies out the counters of an interval record and adds its latency
+ -- buckets to the histogram, which lets intervals be summed as they are read.
+ */
+void readInterval(const resultsRecord *record, resultsInterval *interval,
+                  histogram *latency)
+{
+    const char *data = (const char *)(record + 1);
+    const resultsBucket *buckets = (const resultsBucket *)
+                                   (data + sizeof(resultsInterval));
+    unsigned int count = 0;
+
+    memcpy(interval, data, sizeof(resultsInterval));
+
+    if (sizeof(resultsInterval) + interval->bucketCount *
+        sizeof(resultsBucket) > record->length)
+    {
+        interval->bucketCount = 0;
+    }
+
+    for (count = 0; count < interval->bucketCount; count++)
+    {
+        if (buckets[count].bucket < HISTOGRAM_BUCKETS)
+        {
+            latency->buckets[buckets[count].bucket] += buckets[count].count;
+            latency->count += buckets[count].count;
+        }
+    }
+
+    latency->total += interval->latencyTotal;
+    if (interval->latencyMaximum > latency->maximum)
+    {
+        latency->maximum = interval->latencyMaximum;
+    }
+}
+
+/*
+ -- FUNCTION: appendRecord
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int appendRecord(resultsWriter *writer, uint32_t type,
+ --                                    const void *data, uint32_t length);
+ --
+ -- RETURNS: 0 on success, -1 on failure
+ --
+ -- NOTES:
+ -- Copies a record into the write buffer, flushing the buffer first if the
+ -- record does not fit.
+ */
+static int appendRecord(resultsWriter *writer, uint32_t type, const void *data,
+                        uint32_t length)
+{
+    resultsRecord record;
+
+    record.type = type;
+    record.length = length;
+
+    if (writer->used + sizeof(resultsRecord) + length > RESULTS_BUFFER_SIZE &&
+        flushResults(writer) == -1)
+    {
+        return -1;
+    }
+
+    memcpy(writer->buffer + writer->used, &record, sizeof(resultsRecord));
+    memcpy(writer->buffer + writer->used + sizeof(resultsRecord), data, length);
+    writer->used += sizeof(resultsRecord) + length;
+
+    return 0;
+}
+
+/*
+ -- FUNCTION: flushResults
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int flushResults(resultsWriter *writer);
+ --
+ -- RETURNS: 0 on success, -1 on failure
+ --
+ -- NOTES:
+ -- Writes the buffered records to the end of the file.
+ */
+static int flushResults(resultsWriter *writer)
+{
+    size_t written = 0;
+    ssize_t result = 0;
+
+    while (written < writer->used)
+    {
+        result = write(writer->fd, writer->buffer + written,
+                       writer->used - written);
+        if (result == -1)
+        {
+            return -1;
+        }
+        written += result;
+    }
+
+    writer->used = 0;
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "histogram.h"
+
+/* Defines */
+#define RESULTS_MAGIC 0x52434557
+#define RESULTS_VERSION 1
+#define RESULTS_HOST_SIZE 64
+#define RESULTS_CONFIG_SIZE 512
+#define RESULTS_BUFFER_SIZE 65536
+
+/* Record types */
+#define RESULTS_RUN 1
+#define RESULTS_INTERVAL 2
+#define RESULTS_END 3
+
+/* Every record starts with its type and the length of what follows */
+typedef struct
+{
+    uint32_t type;
+    uint32_t length;
+} resultsRecord;
+
+/* Written once at the start of every run */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t startTime;
+    char host[RESULTS_HOST_SIZE];
+    char config[RESULTS_CONFIG_SIZE];
+} resultsRun;
+
+/* Counters for one interval, followed by bucketCount resultsBucket entries */
+typedef struct
+{
+    uint32_t index;
+    uint32_t bucketCount;
+    uint64_t offset;
+    uint64_t duration;
+    uint64_t requests;
+    uint64_t bytes;
+    uint64_t connections;
+    uint64_t connectTime;
+    uint64_t errors;
+    uint64_t latencyTotal;
+    uint64_t latencyMaximum;
+} resultsInterval;
+
+/* A non empty latency histogram bucket */
+typedef struct
+{
+    uint32_t bucket;
+    uint32_t reserved;
+    uint64_t count;
+} resultsBucket;
+
+/* Written when the run finishes cleanly */
+typedef struct
+{
+    uint64_t endTime;
+    uint32_t intervals;
+    uint32_t reserved;
+} resultsEnd;
+
+/* Buffered appender for a results file */
+typedef struct
+{
+    int fd;
+    size_t used;
+    unsigned int intervals;
+    char buffer[RESULTS_BUFFER_SIZE];
+} resultsWriter;
+
+/* A results file mapped in for reading */
+typedef struct
+{
+    const char *data;
+    size_t size;
+} resultsFile;
+
+/* Function Prototypes */
+#ifdef __cplusplus
+extern "C" {
+#endif
+    int openResults(resultsWriter *writer, const char *path);
+    int writeRunHeader(resultsWriter *writer, uint64_t startTime,
+                       const char *config);
+    int writeInterval(resultsWriter *writer, resultsInterval *interval,
+                      const histogram *latency);
+    int closeResults(resultsWriter *writer, uint64_t endTime);
+    int mapResults(const char *path, resultsFile *file);
+    void unmapResults(resultsFile *file);
+    const resultsRecord *nextRecord(const resultsFile *file, size_t *offset);
+    void readInterval(const resultsRecord *record, resultsInterval *interval,
+                      histogram *latency);
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -5,15 +5,55 @@
  --
  --	FUNCTIONS:		
  --                 int main(int argc, char **argv);
- --                 void server(int port, int comm);
- --                 int processConnection(int socket, int comm);
- --                 void initializeServer(int *listenSocket, int *port);
+ --                 void server(int port, int comm, long quantum,
+ --                             const networkAddress *address);
+ --                 int processConnection(int socket, int comm,
+ --                                       unsigned int trace,
+ --                                       engineCounters *engine,
+ --                                       fileReply *file);
+ --                 static int continueFile(int socket, fileReply *file,
+ --                                         unsigned int trace,
+ --                                         engineCounters *engine,
+ --                                         unsigned long long started);
+ --                 static void dropClient(int socket, fd_set *clients,
+ --                                        fd_set *writers, fileReply *file,
+ --                                        engineCounters *engine);
+ --                 void initializeServer(int *listenSocket, int *port,
+ --                                       const networkAddress *address);
  --                 void displayClientData(unsigned long long clients);
  --                 static void systemFatal(const char *message);
  --
  --	DATE:			February 8, 2012
  --
- --	REVISIONS:		(Date and Description)
+ --	REVISIONS:		October 18, 2026 - Added -a to pin the server to a core.
+ --                  October 18, 2026 - Added -d to serve files from a document
+ --                  root, see fileServe.c.
+ --                  October 18, 2026 - Added -c for the file cache limits, and
+ --                  the file cache counters are shown with the client count.
+ --                  October 18, 2026 - The server counts its system calls and
+ --                  context switches per request, see engineStats.c.
+ --                  October 18, 2026 - Added -t to trace a sample of the
+ --                  connections, see trace.c.
+ --                  October 18, 2026 - Added -A to serve live counters on an
+ --                  admin port, see admin.c. The loop times its waits and its
+ --                  requests for it.
+ --                  October 18, 2026 - Added -L for admission control, see
+ --                  admission.c.
+ --                  October 18, 2026 - Added -q to share each pass between
+ --                  the ready connections by deficit round robin.
+ --                  October 18, 2026 - Request sizes are checked by
+ --                  requestParser.c, and a malformed one only closes its
+ --                  connection.
+ --                  October 18, 2026 - A failed send closes its connection
+ --                  rather than the server, and SIGPIPE is ignored. The
+ --                  connection errors are counted by type.
+ --                  October 18, 2026 - Added -u to serve a UNIX domain
+ --                  socket at a path instead of a TCP port.
+ --                  October 18, 2026 - Added -l to listen on one IPv4 or
+ --                  IPv6 address.
+ --                  October 18, 2026 - A file that fills the send buffer is
+ --                  finished from the write set, so a client that stops
+ --                  reading does not hold up the others.
  --
  --	DESIGNERS:      Luke Queenan
  --
@@ -24,6 +64,8 @@
  ----------------------------------------------------------------------------*/
 
 /* System includes */
+#include <errno.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -32,12 +74,27 @@
 #include <unistd.h>
 
 /* User includes */
+#include "admin.h"
+#include "admission.h"
+#include "affinity.h"
+#include "engineStats.h"
+#include "fileServe.h"
 #include "network.h"
+#include "requestParser.h"
+#include "timing.h"
+#include "trace.h"
 
 int main(int argc, char **argv);
-void server(int port, int comm);
-int processConnection(int socket, int comm);
-void initializeServer(int *listenSocket, int *port);
+void server(int port, int comm, long quantum,
+            const networkAddress *address);
+int processConnection(int socket, int comm, unsigned int trace,
+                      engineCounters *engine, fileReply *file);
+static int continueFile(int socket, fileReply *file, unsigned int trace,
+                        engineCounters *engine, unsigned long long started);
+static void dropClient(int socket, fd_set *clients, fd_set *writers,
+                       fileReply *file, engineCounters *engine);
+void initializeServer(int *listenSocket, int *port,
+                      const networkAddress *address);
 void displayClientData(unsigned long long clients);
 static void systemFatal(const char *message);
 
@@ -52,7 +109,20 @@ typedef struct
  --
  -- DATE: Feb 20, 2011
  --
- -- REVISIONS: (Date and Description)
+ -- REVISIONS: October 18, 2026 - Added the -a option. The server runs in one
+ -- thread, so it is pinned to the first core in the list.
+ -- October 18, 2026 - Added the -T option for a socket tuning profile.
+ -- October 18, 2026 - Added the -d option for a document root.
+ -- October 18, 2026 - Added the -c option for the file cache limits.
+ -- October 18, 2026 - Added the -t option for request tracing.
+ -- October 18, 2026 - Added the -A option for an admin port.
+ -- October 18, 2026 - Added the -L option for admission control.
+ -- October 18, 2026 - Added the -q option for the bytes each connection is
+ -- served per pass.
+ -- October 18, 2026 - Ignores SIGPIPE, so a client that goes away during
+ -- a send only fails that send.
+ -- October 18, 2026 - Added the -u option to serve a UNIX domain socket path.
+ -- October 18, 2026 - Added the -l option for the address to listen on.
  --
  -- DESIGNER: Luke Queenan
  --
@@ -70,22 +140,174 @@ int main(int argc, char **argv)
     /* Initialize port and give default option in case of no user input */
     int port = DEFAULT_PORT;
     int option = 0;
+    int adminPort = 0;
     int comms[2];
+    long quantum = 0;
+    unsigned int cacheEntries = FILE_CACHE_ENTRIES;
+    unsigned long cacheMegabytes = FILE_CACHE_MEGABYTES;
+    unsigned int traceEvery = 1;
+    char *root = 0;
+    char *tracePath = 0;
+    char *limits = 0;
+    char *end = 0;
+    char message[NETWORK_BUFFER_SIZE];
+    networkAddress listenAddress;
+    networkAddress *address = 0;
+    coreList cores;
     
     /* Parse command line parameters using getopt */
-    while ((option = getopt(argc, argv, "p:")) != -1)
+    while ((option = getopt(argc, argv, "p:a:T:d:c:t:A:L:q:u:l:")) != -1)
     {
         switch (option)
         {
             case 'p':
                 port = atoi(optarg);
                 break;
+            case 'a':
+                if (parseCoreList(optarg, &cores) == -1 ||
+                    pinThread(affinityCore(&cores, 0)) != 0)
+                {
+                    fprintf(stderr, "No usable cores in %s\n", optarg);
+                    return 1;
+                }
+                printf("Running on core %d\n", affinityCore(&cores, 0));
+                break;
+            case 'd':
+                root = optarg;
+                break;
+            case 'c':
+                cacheEntries = strtoul(optarg, &end, 10);
+                if (*end == ',')
+                {
+                    cacheMegabytes = strtoul(end + 1, NULL, 10);
+                }
+                break;
+            case 't':
+                tracePath = optarg;
+                if ((end = strchr(optarg, ',')) != NULL)
+                {
+                    *end = '\0';
+                    traceEvery = strtoul(end + 1, NULL, 10);
+                }
+                break;
+            case 'A':
+                adminPort = atoi(optarg);
+                break;
+            case 'L':
+                limits = optarg;
+                break;
+            case 'q':
+                quantum = atol(optarg);
+                break;
+            case 'l':
+                if (parseAddress(optarg, &listenAddress) == -1)
+                {
+                    fprintf(stderr, "Listen address: %s is not valid\n",
+                            optarg);
+                    return 1;
+                }
+                address = &listenAddress;
+                break;
+            case 'u':
+                if (setUnixPath(optarg) == -1)
+                {
+                    fprintf(stderr, "Socket path too long: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'T':
+                if (loadSocketTuning(optarg, message, sizeof(message)) == -1)
+                {
+                    fprintf(stderr, "Socket tuning: %s\n", message);
+                    return 1;
+                }
+                break;
             default:
-                fprintf(stderr, "Usage: %s -p [port]\n", argv[0]);
+                fprintf(stderr, "Usage: %s -p [port] -u [path] -l [address] -a [cores] -T [tuning] -d [root] -c [entries,megabytes] -t [trace,every] -A [admin port] -L [connections,inflight[,target us,interval ms]] -q [quantum bytes]\n",
+                        argv[0]);
                 return 0;
         }
     }
     
+    /* A client gone mid send is an error on its connection, not a signal */
+    signal(SIGPIPE, SIG_IGN);
+    
+    /* Calibrate the clock requests are timed with before any threads start */
+    timingInit();
+    
+    if (limits != NULL)
+    {
+        if (admissionConfigure(limits) == -1)
+        {
+            fprintf(stderr, "Admission control: %s is not valid\n", limits);
+            return 1;
+        }
+        admissionDescribe(message, sizeof(message));
+        printf("Admission control: %s\n", message);
+    }
+    
+    if (address != NULL && getUnixPath() != NULL)
+    {
+        fprintf(stderr, "A listen address cannot be used with a path\n");
+        return 1;
+    }
+    
+    describeSocketTuning(message, sizeof(message));
+    printf("Socket tuning: %s\n", message);
+    if (getUnixPath() != NULL)
+    {
+        printf("Listening on %s instead of a port\n", getUnixPath());
+    }
+    if (address != NULL)
+    {
+        describeAddress(address, message, sizeof(message));
+        printf("Listening on %s\n", message);
+    }
+    
+    if (root != NULL)
+    {
+        if (openDocumentRoot(root, cacheEntries,
+                             cacheMegabytes * 1024 * 1024) == -1)
+        {
+            perror(root);
+            return 1;
+        }
+        printf("Serving files from %s, caching up to %u files and %lu MB\n",
+               root, cacheEntries, cacheMegabytes);
+    }
+    
+    if (tracePath != NULL)
+    {
+        if (traceStart(tracePath, traceEvery) == -1)
+        {
+            perror(tracePath);
+            return 1;
+        }
+        printf("Tracing one connection in %u to %s\n",
+               traceEvery ? traceEvery : 1, tracePath);
+    }
+    
+    if (adminPort != 0)
+    {
+        if (adminStart(adminPort, "select") == -1)
+        {
+            perror("Unable to open the admin port");
+            return 1;
+        }
+        printf("Serving metrics on port %d\n", adminPort);
+    }
+    
+    if (quantum < 0)
+    {
+        fprintf(stderr, "The quantum cannot be negative\n");
+        return 1;
+    }
+    if (quantum != 0)
+    {
+        printf("Serving each ready connection %ld bytes of replies a pass\n",
+               quantum);
+    }
+    
     /* Create the socket pair for sending data for collection */
     if (socketpair(AF_UNIX, SOCK_STREAM, 0, comms) == -1)
     {
@@ -95,7 +317,7 @@ int main(int argc, char **argv)
     /* Need to fork and create process to collect data */
     
     /* Start server */
-    server(port, comms[1]);
+    server(port, comms[1], quantum, address);
     
     return 0;
 }
@@ -105,13 +327,28 @@ int main(int argc, char **argv)
  --
  -- DATE: Feb 20, 2011
  --
- -- REVISIONS: (Date and Description)
+ -- REVISIONS: October 18, 2026 - Counts its work in the engine statistics
+ -- and starts the reporter.
+ -- October 18, 2026 - Keeps the trace id of every connection by socket.
+ -- October 18, 2026 - Times its waits and requests, and counts accepts and
+ -- closes.
+ -- October 18, 2026 - The ready sockets of each pass are the requests in
+ -- flight for admission control, and the time since the wakeup is their
+ -- queue delay. Connections are left in the backlog while too many are
+ -- ready, and those not admitted are reset.
+ -- October 18, 2026 - Serves each ready connection up to a quantum of reply
+ -- bytes a pass, and starts each pass one connection further on.
+ -- October 18, 2026 - Listens on the given address, if there is one.
+ -- October 18, 2026 - Selects on a write set as well, for the files that
+ -- filled their send buffer.
+ -- October 18, 2026 - A connection still in debt after its quantum is added
+ -- sits the pass out.
  --
  -- DESIGNER: Luke Queenan
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: void server(int, int)
+ -- INTERFACE: void server(int, int, long, const networkAddress *)
  --
  -- RETURNS: void
  --
@@ -119,63 +356,190 @@ int main(int argc, char **argv)
  -- This function contains the server loop for select. It accept client
  -- connections and calls the process connection function when a socket is ready
  -- for reading.
+ --
+ -- Without a quantum each ready connection has one request answered a pass.
+ -- With one, the connections share each pass by deficit round robin: a
+ -- ready connection is given the quantum, and its requests are answered
+ -- while it has credit left and more input waiting. A reply can overdraw
+ -- the credit, and the connection is not served again until the quanta of
+ -- later passes have paid off the debt. Credit left when the connection
+ -- runs out of requests is dropped. A pipelining client then
+ -- gets the same share of bytes a pass as a client with one request out,
+ -- instead of being read until it stops. The scan starts after the first
+ -- connection served in the pass before, so no socket is always first.
+ --
+ -- A file is sent with the socket made non blocking. If the send buffer
+ -- fills before it has all gone the socket moves from the read set to the
+ -- write set, and each pass it is writable takes the file further. Once it
+ -- is done the socket blocks again and goes back to waiting for requests.
  */
-void server(int port, int comm)
+void server(int port, int comm, long quantum,
+            const networkAddress *address)
 {
     int listenSocket = 0;
     register int client = 0;
-    register int index = 0;
+    int index = 0;
+    register int count = 0;
+    int start = 0;
+    int nextStart = 0;
+    int served = 0;
+    int cost = 0;
+    int ready = 0;
+    int paused = 0;
     fd_set clients;
     fd_set activeClients;
+    fd_set writers;
+    fd_set activeWriters;
     unsigned long long connections = 0;
+    unsigned long long started = 0;
+    unsigned int traces[FD_SETSIZE];
+    long deficits[FD_SETSIZE];
+    fileReply files[FD_SETSIZE];
+    unsigned long long fileStarted[FD_SETSIZE];
+    engineCounters *engine = 0;
     
     /* Initialize the server */
-    initializeServer(&listenSocket, &port);
+    initializeServer(&listenSocket, &port, address);
+    
+    if ((engine = engineJoin()) == NULL ||
+        engineStartReporter("Select server") == -1)
+    {
+        systemFatal("Unable to start the engine statistics");
+    }
     
     /* Set up select variables */
     FD_ZERO(&clients);
     FD_ZERO(&activeClients);
+    FD_ZERO(&writers);
+    FD_ZERO(&activeWriters);
     FD_SET(listenSocket, &clients);
+    memset(files, 0, sizeof(files));
     
     displayClientData(connections);
     
     while (1)
     {
         activeClients = clients;
-        if (select(FD_SETSIZE, &activeClients, NULL, NULL, NULL) == -1)
+        activeWriters = writers;
+        engineWaiting(engine);
+        if ((ready = select(FD_SETSIZE, &activeClients, &activeWriters, NULL,
+                            NULL)) == -1)
         {
             systemFatal("Error with select");
         }
+        engineWakeup(engine, ready > 0);
+        
+        /* Every ready client has a request waiting or a file going out on
+         this pass */
+        admissionBegin(ready - FD_ISSET(listenSocket, &activeClients));
+        paused = admissionPaused();
         
-        /* Process all the sockets */
-        for (index = 0; index < FD_SETSIZE; index++)
+        /* Process all the sockets, from where the last pass left off */
+        served = 0;
+        for (count = 0; count < FD_SETSIZE; count++)
         {
-            if (FD_ISSET(index, &activeClients))
+            index = (start + count) % FD_SETSIZE;
+            if (FD_ISSET(index, &activeWriters))
+            {
+                /* Carry on with the file that filled the send buffer */
+                cost = continueFile(index, &files[index], traces[index],
+                                    engine, fileStarted[index]);
+                admissionDone(1, timingNow() - engine->wokeAt);
+                if (cost == 0)
+                {
+                    dropClient(index, &clients, &writers, &files[index],
+                               engine);
+                    connections--;
+                    displayClientData(connections);
+                }
+                else if (files[index].total == 0)
+                {
+                    FD_CLR(index, &writers);
+                    FD_SET(index, &clients);
+                }
+            }
+            else if (FD_ISSET(index, &activeClients))
             {
                 if (index != listenSocket)
                 {
-                    if (processConnection(index, comm) == 0)
+                    deficits[index] += quantum;
+                    if (quantum != 0 && deficits[index] <= 0)
                     {
-                        close(index);
-                        FD_CLR(index, &clients);
+                        /* Still in debt, its input waits for another pass */
+                        admissionDone(1, timingNow() - engine->wokeAt);
+                        continue;
+                    }
+                    if (served++ == 0)
+                    {
+                        nextStart = index + 1;
+                    }
+                    TRACE(traces[index], TRACE_READABLE);
+                    do
+                    {
+                        started = timingNow();
+                        if ((cost = processConnection(index, comm,
+                                                      traces[index], engine,
+                                                      &files[index])) == 0)
+                        {
+                            break;
+                        }
+                        deficits[index] -= cost;
+                        if (files[index].total > 0)
+                        {
+                            /* Timed and counted once the file has gone */
+                            fileStarted[index] = started;
+                            break;
+                        }
+                        engine->requests++;
+                        engineLatency(engine, timingNow() - started, 1);
+                    } while (deficits[index] > 0 && inputWaiting(&index));
+                    admissionDone(1, timingNow() - engine->wokeAt);
+                    
+                    if (cost == 0)
+                    {
+                        dropClient(index, &clients, &writers, &files[index],
+                                   engine);
                         connections--;
                         displayClientData(connections);
                     }
+                    else if (files[index].total > 0)
+                    {
+                        /* The send buffer filled, finish it when writable */
+                        FD_CLR(index, &clients);
+                        FD_SET(index, &writers);
+                    }
+                    else if (deficits[index] > 0)
+                    {
+                        /* Out of requests, credit is not saved up */
+                        deficits[index] = 0;
+                    }
                 }
-                else
+                else if (!paused)
                 {
                     /* Accept the new connections */
                     while ((client = acceptConnection(&listenSocket)) != -1)
                     {
+                        if (!admitConnection())
+                        {
+                            engine->rejected++;
+                            rejectConnection(client);
+                            continue;
+                        }
                         FD_SET(client, &clients);
+                        engine->accepts++;
+                        deficits[client] = 0;
+                        traces[client] = traceConnection();
+                        TRACE(traces[client], TRACE_ACCEPTED);
                         connections++;
                         displayClientData(connections);
                     }
                 }
             }
         }
+        start = nextStart;
     }
     
+    engineLeave(engine);
     close(listenSocket);
 }
 
@@ -184,21 +548,35 @@ void server(int port, int comm)
  --
  -- DATE: Feb 20, 2011
  --
- -- REVISIONS: (Date and Description)
+ -- REVISIONS: October 18, 2026 - Requests that start with a slash are
+ -- served from the document root.
+ -- October 18, 2026 - Records trace events for traced connections.
+ -- October 18, 2026 - Returns the bytes of the reply, for the quantum.
+ -- October 18, 2026 - A malformed request closes the connection instead of
+ -- exiting.
+ -- October 18, 2026 - A failed send also only closes the connection, and
+ -- the errors are counted by type in the engine counters passed in.
+ -- October 18, 2026 - A file is sent without blocking, and left in the
+ -- reply passed in if the send buffer fills.
  --
  -- DESIGNER: Luke Queenan
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: int processConnection(int, int)
+ -- INTERFACE: int processConnection(int, int, unsigned int,
+ --                                  engineCounters *, fileReply *)
  --
- -- RETURNS: 1 on success
+ -- RETURNS: the bytes of the reply on success, 0 if the connection should be
+ --          closed. A file counts as one buffer, its length is not known here
  --
  -- NOTES:
  -- Service a client socket by reading a request and sending the data to the
- -- client.
+ -- client. The trace id is zero unless the connection is being traced. A
+ -- file that does not fit in the send buffer is still going out when this
+ -- returns, see continueFile.
  */
-int processConnection(int socket, int comm)
+int processConnection(int socket, int comm, unsigned int trace,
+                      engineCounters *engine, fileReply *file)
 {
     int bytesToWrite = 0;
     char line[NETWORK_BUFFER_SIZE];
@@ -208,30 +586,135 @@ int processConnection(int socket, int comm)
     memset(result, 'L', NETWORK_BUFFER_SIZE);
     
     /* Read the request from the client */
-    if (readLine(&socket, line, NETWORK_BUFFER_SIZE) <= 0)
+    if ((bytesToWrite = readLine(&socket, line, NETWORK_BUFFER_SIZE - 1)) <= 0)
     {
+        if (bytesToWrite == -1)
+        {
+            engineError(engine, engineErrorType(errno));
+        }
         return 0;
     }
+    line[bytesToWrite] = '\0';
+    TRACE(trace, TRACE_PARSED);
     
-    /* Get the number of bytes to reply with */
-    bytesToWrite = atol(line);
+    /* Stream a file if one was asked for */
+    if (isFileRequest(line))
+    {
+        if (makeSocketNonBlocking(&socket) == -1)
+        {
+            engineError(engine, engineErrorType(errno));
+            return 0;
+        }
+        startFile(file, line);
+        return continueFile(socket, file, trace, engine, 0);
+    }
     
-    /* Ensure that the bytes requested are within our buffers */
-    if ((bytesToWrite <= 0) || (bytesToWrite > NETWORK_BUFFER_SIZE))
+    /* Get the number of bytes to reply with, within our buffers */
+    if ((bytesToWrite = requestSize(line, NETWORK_BUFFER_SIZE)) == -1)
     {
-        systemFatal("Client requested too large a file");
+        engineError(engine, ENGINE_ERROR_MALFORMED);
+        return 0;
     }
-
+    
     /* Send the data back to the client */
+    TRACE(trace, TRACE_QUEUED);
     if (sendData(&socket, result, bytesToWrite) == -1)
     {
-        systemFatal("Send fail");
+        engineError(engine, engineErrorType(errno));
+        return 0;
     }
-
+    TRACE(trace, TRACE_SENT);
+    
     /* Send the communication time to the data collection process */
     
     
-    return 1;
+    return bytesToWrite;
+}
+
+/*
+ -- FUNCTION: continueFile
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int continueFile(int socket, fileReply *file,
+ --                                    unsigned int trace,
+ --                                    engineCounters *engine,
+ --                                    unsigned long long started);
+ --
+ -- RETURNS: one buffer's worth of bytes on success, 0 if the connection
+ --          should be closed
+ --
+ -- NOTES:
+ -- Sends as much of a file as the non blocking socket takes. If it all goes
+ -- the socket is made to block again. A file that was left waiting for the
+ -- write set is counted here, timed from the time passed in. One sent
+ -- straight away, with a time of zero, is counted by the server loop.
+ */
+static int continueFile(int socket, fileReply *file, unsigned int trace,
+                        engineCounters *engine, unsigned long long started)
+{
+    switch (sendFile(&socket, file))
+    {
+        case -1:
+            engineError(engine, engineErrorType(errno));
+            return 0;
+        case 1:
+            return NETWORK_BUFFER_SIZE;
+        default:
+            break;
+    }
+    
+    if (makeSocketBlocking(&socket) == -1)
+    {
+        engineError(engine, engineErrorType(errno));
+        return 0;
+    }
+    TRACE(trace, TRACE_SENT);
+    if (started != 0)
+    {
+        engine->requests++;
+        engineLatency(engine, timingNow() - started, 1);
+    }
+    
+    return NETWORK_BUFFER_SIZE;
+}
+
+/*
+ -- FUNCTION: dropClient
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void dropClient(int socket, fd_set *clients,
+ --                                   fd_set *writers, fileReply *file,
+ --                                   engineCounters *engine);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Closes a client socket, takes it out of both sets and gives back any file
+ -- it was still being sent.
+ */
+static void dropClient(int socket, fd_set *clients, fd_set *writers,
+                       fileReply *file, engineCounters *engine)
+{
+    admissionClosed();
+    endFile(file);
+    close(socket);
+    engine->closes++;
+    FD_CLR(socket, clients);
+    FD_CLR(socket, writers);
 }
 
 /*
@@ -241,12 +724,15 @@ int processConnection(int socket, int comm)
  --
  -- REVISIONS: September 22, 2011 - Added some extra comments about failure and
  -- a function call to set the socket into non blocking mode.
+ -- October 18, 2026 - Makes a UNIX domain socket when serving a path.
+ -- October 18, 2026 - Binds to the given address, if there is one.
  --
  -- DESIGNER: Luke Queenan
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: void initializeServer(int *listenSocket, int *port);
+ -- INTERFACE: void initializeServer(int *listenSocket, int *port,
+ --                                  const networkAddress *address);
  --
  -- RETURNS: void
  --
@@ -256,10 +742,13 @@ int processConnection(int socket, int comm)
  -- setting it to listen. If an error occurs, the function calls "systemFatal"
  -- with an error message.
  */
-void initializeServer(int *listenSocket, int *port)
+void initializeServer(int *listenSocket, int *port,
+                      const networkAddress *address)
 {
-    // Create a TCP socket
-    if ((*listenSocket = tcpSocket()) == -1)
+    // Create a TCP socket for the address, or a UNIX domain one when serving
+    // a path
+    *listenSocket = (address != NULL) ? addressSocket(address) : streamSocket();
+    if (*listenSocket == -1)
     {
         systemFatal("Cannot Create Socket!");
     }
@@ -271,7 +760,8 @@ void initializeServer(int *listenSocket, int *port)
     }
     
     // Bind an address to the socket
-    if (bindAddress(port, listenSocket) == -1)
+    if ((address != NULL ? bindAddressTo(address, port, listenSocket) :
+         bindAddress(port, listenSocket)) == -1)
     {
         systemFatal("Cannot Bind Address To Socket");
     }
@@ -290,7 +780,13 @@ void initializeServer(int *listenSocket, int *port)
 
 void displayClientData(unsigned long long clients)
 {
+    char cache[NETWORK_BUFFER_SIZE];
+    
     printf("Connected clients: %llu\n", clients);
+    if (describeFileCache(cache, sizeof(cache)) > 0)
+    {
+        printf("File cache: %s\n", cache);
+    }
 }
 
 /*
@@ -0,0 +1,443 @@
+/*
+ -- SOURCE FILE: summary.c
+ --
+ -- PROGRAM: Web Client Emulator
+ --
+ -- FUNCTIONS:
+ -- int addRuns(runList *list, const resultsFile *file, const char *name,
+ --             int wanted);
+ -- void mergeRuns(const runList *list, runSummary *merged);
+ -- int writeMergedRun(const runList *list, resultsWriter *writer,
+ --                    const char *config);
+ -- void printRun(const runSummary *summary);
+ -- void freeRuns(runList *list);
+ -- double perSecond(unsigned long long count, unsigned long long duration);
+ -- static int addRun(runList *list, const char *name, const resultsRun *run);
+ -- static void addInterval(runSummary *summary, const resultsRecord *record);
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- NOTES:
+ -- This file adds up the runs in results files so they can be printed,
+ -- compared and merged. It is shared by the report tool and by the client
+ -- coordinator, which merges the runs sent back by its workers. Merging
+ -- treats the runs as having been made at the same time, so counts and
+ -- histograms are added, the duration is the longest of the runs and
+ -- interval N of the merged run is made up of interval N of every run.
+ */
+
+// Includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "summary.h"
+
+static int addRun(runList *list, const char *name, const resultsRun *run);
+static void addInterval(runSummary *summary, const resultsRecord *record);
+
+/*
+ -- FUNCTION: addRuns
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int addRuns(runList *list, const resultsFile *file,
+ --                        const char *name, int wanted);
+ --
+ -- RETURNS: the number of runs added, -1 on failure
+ --
+ -- NOTES:
+ -- Walks the records of the file and adds run number wanted to the list, or
+ -- every run if wanted is negative. The intervals of each run are added up as
+ -- they are walked. The file must stay mapped while the list is in use.
+ */
+int addRuns(runList *list, const resultsFile *file, const char *name,
+            int wanted)
+{
+    int runs = -1;
+    size_t offset = 0;
+    unsigned int first = list->count;
+    const resultsRecord *record = 0;
+    const resultsRun *run = 0;
+    runSummary *current = 0;
+
+    while ((record = nextRecord(file, &offset)) != NULL)
+    {
+        switch (record->type)
+        {
+            case RESULTS_RUN:
+                current = 0;
+                run = (const resultsRun *)(record + 1);
+                if (++runs != wanted && wanted >= 0)
+                {
+                    break;
+                }
+                if (record->length < sizeof(resultsRun) ||
+                    run->magic != RESULTS_MAGIC)
+                {
+                    fprintf(stderr, "%s is not a results file from this "
+                            "machine\n", name);
+                    return -1;
+                }
+                if (addRun(list, name, run) == -1)
+                {
+                    return -1;
+                }
+                current = list->runs[list->count - 1];
+                break;
+            case RESULTS_INTERVAL:
+                if (current != 0)
+                {
+                    addInterval(current, record);
+                }
+                break;
+            case RESULTS_END:
+                if (current != 0)
+                {
+                    current->complete = 1;
+                    current->endTime = ((const resultsEnd *)
+                                        (record + 1))->endTime;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    return list->count - first;
+}
+
+/*
+ -- FUNCTION: mergeRuns
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void mergeRuns(const runList *list, runSummary *merged);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Adds the totals of every run in the list into merged, which should start
+ -- out zeroed. The merged summary has no run header of its own.
+ */
+void mergeRuns(const runList *list, runSummary *merged)
+{
+    unsigned int run = 0;
+
+    merged->complete = 1;
+
+    for (run = 0; run < list->count; run++)
+    {
+        const runSummary *summary = list->runs[run];
+
+        if (summary->intervals > merged->intervals)
+        {
+            merged->intervals = summary->intervals;
+        }
+        if (summary->endTime > merged->endTime)
+        {
+            merged->endTime = summary->endTime;
+        }
+        if (summary->total.duration > merged->total.duration)
+        {
+            merged->total.duration = summary->total.duration;
+        }
+        merged->complete &= summary->complete;
+        merged->total.requests += summary->total.requests;
+        merged->total.bytes += summary->total.bytes;
+        merged->total.connections += summary->total.connections;
+        merged->total.connectTime += summary->total.connectTime;
+        merged->total.errors += summary->total.errors;
+        histogramMerge(&merged->latency, &summary->latency);
+    }
+}
+
+/*
+ -- FUNCTION: writeMergedRun
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int writeMergedRun(const runList *list, resultsWriter *writer,
+ --                               const char *config);
+ --
+ -- RETURNS: 0 on success, -1 on failure
+ --
+ -- NOTES:
+ -- Writes a run header and the merged intervals of the runs in the list. The
+ -- merged run starts when the first run in the list started. The caller ends
+ -- the run with closeResults.
+ */
+int writeMergedRun(const runList *list, resultsWriter *writer,
+                   const char *config)
+{
+    int result = 0;
+    unsigned int run = 0;
+    unsigned int interval = 0;
+    unsigned int intervals = 0;
+    resultsInterval next;
+    resultsInterval part;
+    histogram *latency = 0;
+
+    if (list->count == 0 || (latency = malloc(sizeof(histogram))) == NULL ||
+        writeRunHeader(writer, list->runs[0]->run->startTime, config) == -1)
+    {
+        free(latency);
+        return -1;
+    }
+
+    for (run = 0; run < list->count; run++)
+    {
+        if (list->runs[run]->intervals > intervals)
+        {
+            intervals = list->runs[run]->intervals;
+        }
+    }
+
+    for (interval = 0; result == 0 && interval < intervals; interval++)
+    {
+        memset(&next, 0, sizeof(resultsInterval));
+        memset(latency, 0, sizeof(histogram));
+
+        for (run = 0; run < list->count; run++)
+        {
+            if (interval >= list->runs[run]->intervals)
+            {
+                continue;
+            }
+            readInterval(list->runs[run]->intervalList[interval], &part,
+                         latency);
+            next.offset = part.offset;
+            next.duration = (part.duration > next.duration) ?
+                            part.duration : next.duration;
+            next.requests += part.requests;
+            next.bytes += part.bytes;
+            next.connections += part.connections;
+            next.connectTime += part.connectTime;
+            next.errors += part.errors;
+        }
+
+        result = writeInterval(writer, &next, latency);
+    }
+
+    free(latency);
+
+    return result;
+}
+
+/*
+ -- FUNCTION: printRun
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void printRun(const runSummary *summary);
+ --
+ -- RETURNS: void
+ */
+void printRun(const runSummary *summary)
+{
+    const histogram *latency = &summary->latency;
+
+    if (summary->run != 0)
+    {
+        printf("%s: run started %llu on %s%s\n  %s\n", summary->name,
+               (unsigned long long)summary->run->startTime,
+               summary->run->host, summary->complete ? "" : " (incomplete)",
+               summary->run->config);
+    }
+    else
+    {
+        printf("%s%s\n", summary->name,
+               summary->complete ? "" : " (incomplete)");
+    }
+
+    printf("  Duration: %.3fs, Intervals: %u\n",
+           summary->total.duration / 1e9, summary->intervals);
+    printf("  Requests: %llu (%.1f/s), Data: %llu bytes (%.2f MB/s), "
+           "Errors: %llu\n", (unsigned long long)summary->total.requests,
+           perSecond(summary->total.requests, summary->total.duration),
+           (unsigned long long)summary->total.bytes,
+           perSecond(summary->total.bytes, summary->total.duration) / 1e6,
+           (unsigned long long)summary->total.errors);
+    printf("  Connections: %llu, Mean Connect: %.1fus\n",
+           (unsigned long long)summary->total.connections,
+           summary->total.connections ? summary->total.connectTime / 1000.0 /
+           summary->total.connections : 0);
+    printf("  Latency us: mean %.1f, 50%% %.1f, 90%% %.1f, 99%% %.1f, "
+           "99.9%% %.1f, max %.1f\n",
+           latency->count ? latency->total / 1000.0 / latency->count : 0,
+           histogramPercentile(latency, 50) / 1000.0,
+           histogramPercentile(latency, 90) / 1000.0,
+           histogramPercentile(latency, 99) / 1000.0,
+           histogramPercentile(latency, 99.9) / 1000.0,
+           latency->maximum / 1000.0);
+}
+
+/*
+ -- FUNCTION: freeRuns
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void freeRuns(runList *list);
+ --
+ -- RETURNS: void
+ */
+void freeRuns(runList *list)
+{
+    unsigned int index = 0;
+
+    for (index = 0; index < list->count; index++)
+    {
+        free(list->runs[index]->intervalList);
+        free(list->runs[index]);
+    }
+
+    free(list->runs);
+    list->runs = 0;
+    list->count = 0;
+}
+
+/*
+ -- FUNCTION: perSecond
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: double perSecond(unsigned long long count,
+ --                             unsigned long long duration);
+ --
+ -- RETURNS: the count per second over a duration in nanoseconds
+ */
+double perSecond(unsigned long long count, unsigned long long duration)
+{
+    return duration ? count * 1e9 / duration : 0;
+}
+
+/*
+ -- FUNCTION: addRun
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int addRun(runList *list, const char *name,
+ --                              const resultsRun *run);
+ --
+ -- RETURNS: 0 on success, -1 if out of memory
+ */
+static int addRun(runList *list, const char *name, const resultsRun *run)
+{
+    runSummary **runs = 0;
+    runSummary *summary = 0;
+
+    if ((summary = calloc(1, sizeof(runSummary))) == NULL ||
+        (runs = realloc(list->runs, sizeof(runSummary *) *
+                        (list->count + 1))) == NULL)
+    {
+        free(summary);
+        fprintf(stderr, "Out of memory\n");
+        return -1;
+    }
+
+    summary->name = name;
+    summary->run = run;
+    summary->endTime = run->startTime;
+    list->runs = runs;
+    list->runs[list->count++] = summary;
+
+    return 0;
+}
+
+/*
+ -- FUNCTION: addInterval
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void addInterval(runSummary *summary,
+ --                                    const resultsRecord *record);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Adds an interval to the run totals and remembers where it is, so that a
+ -- merge can go back to it.
+ */
+static void addInterval(runSummary *summary, const resultsRecord *record)
+{
+    resultsInterval interval;
+    const resultsRecord **intervalList = 0;
+
+    readInterval(record, &interval, &summary->latency);
+
+    summary->total.duration += interval.duration;
+    summary->total.requests += interval.requests;
+    summary->total.bytes += interval.bytes;
+    summary->total.connections += interval.connections;
+    summary->total.connectTime += interval.connectTime;
+    summary->total.errors += interval.errors;
+
+    /* Grow the interval list in powers of two */
+    if ((summary->intervals & (summary->intervals - 1)) == 0)
+    {
+        intervalList = realloc(summary->intervalList,
+                               sizeof(resultsRecord *) *
+                               (summary->intervals ? summary->intervals * 2 :
+                                1));
+        if (intervalList == NULL)
+        {
+            return;
+        }
+        summary->intervalList = intervalList;
+    }
+    summary->intervalList[summary->intervals++] = record;
+}
@@ -0,0 +1,41 @@
+#ifndef SUMMARY_H
+#define SUMMARY_H
+
+#include "results.h"
+
+/* A single run and everything in it added up */
+typedef struct
+{
+    const char *name;
+    const resultsRun *run;
+    int complete;
+    unsigned long long endTime;
+    resultsInterval total;
+    histogram latency;
+    unsigned int intervals;
+    const resultsRecord **intervalList;
+} runSummary;
+
+/* A set of runs picked out of one or more results files */
+typedef struct
+{
+    unsigned int count;
+    runSummary **runs;
+} runList;
+
+/* Function Prototypes */
+#ifdef __cplusplus
+extern "C" {
+#endif
+    int addRuns(runList *list, const resultsFile *file, const char *name,
+                int wanted);
+    void mergeRuns(const runList *list, runSummary *merged);
+    int writeMergedRun(const runList *list, resultsWriter *writer,
+                       const char *config);
+    void printRun(const runSummary *summary);
+    void freeRuns(runList *list);
+    double perSecond(unsigned long long count, unsigned long long duration);
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -5,15 +5,43 @@
  --
  --	FUNCTIONS:		
  --                 int main(int argc, char **argv);
- --                 void server(int port);
+ --                 void server(int port, const coreList *cores, int steer,
+ --                             const networkAddress *address);
  --                 void *processConnection(void *data);
- --                 void initializeServer(int *listenSocket, int *port);
+ --                 void initializeServer(int *listenSocket, int *port,
+ --                                       const networkAddress *address);
  --                 void displayClientData(unsigned long long clients);
  --                 static void systemFatal(const char *message);
  --
  --	DATE:			February 8, 2012
  --
- --	REVISIONS:		(Date and Description)
+ --	REVISIONS:		October 18, 2026 - Added -a to place the connection threads
+ --                  on cores round robin.
+ --                  October 18, 2026 - Added -s to run each connection thread
+ --                  on the CPU that receives the connection's packets.
+ --                  October 18, 2026 - Added -d to serve files from a document
+ --                  root, see fileServe.c.
+ --                  October 18, 2026 - Added -c for the file cache limits, and
+ --                  the file cache counters are shown with the client count.
+ --                  October 18, 2026 - The server counts its system calls and
+ --                  context switches per request, see engineStats.c.
+ --                  October 18, 2026 - Added -t to trace a sample of the
+ --                  connections, see trace.c.
+ --                  October 18, 2026 - Added -A to serve live counters on an
+ --                  admin port, see admin.c. The threads time their requests
+ --                  for its latency histogram.
+ --                  October 18, 2026 - Added -L for admission control, see
+ --                  admission.c.
+ --                  October 18, 2026 - Request sizes are checked by
+ --                  requestParser.c, and a malformed one only closes its
+ --                  connection.
+ --                  October 18, 2026 - A failed send closes its connection
+ --                  rather than the server, and SIGPIPE is ignored. The
+ --                  connection errors are counted by type.
+ --                  October 18, 2026 - Added -u to serve a UNIX domain
+ --                  socket at a path instead of a TCP port.
+ --                  October 18, 2026 - Added -l to listen on one IPv4 or
+ --                  IPv6 address.
  --
  --	DESIGNERS:      Luke Queenan
  --
@@ -24,7 +52,9 @@
  ----------------------------------------------------------------------------*/
 
 /* System includes */
+#include <errno.h>
 #include <pthread.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -32,12 +62,25 @@
 #include <unistd.h>
 
 /* User includes */
+#include "admin.h"
+#include "admission.h"
+#include "affinity.h"
+#include "engineStats.h"
+#include "fileServe.h"
 #include "network.h"
+#include "requestParser.h"
+#include "timing.h"
+#include "trace.h"
+
+/* Milliseconds to wait before accepting again when out of descriptors */
+#define ACCEPT_BACKOFF 10
 
 int main(int argc, char **argv);
-void server(int port);
+void server(int port, const coreList *cores, int steer,
+            const networkAddress *address);
 void *processConnection(void *data);
-void initializeServer(int *listenSocket, int *port);
+void initializeServer(int *listenSocket, int *port,
+                      const networkAddress *address);
 void displayClientData(unsigned long long clients);
 static void systemFatal(const char *message);
 
@@ -45,6 +88,7 @@ typedef struct
 {
     int socket;
     int commSocket;
+    unsigned int trace;
 } clientData;
 
 /*
@@ -52,7 +96,19 @@ typedef struct
  --
  -- DATE: Feb 20, 2011
  --
- -- REVISIONS: (Date and Description)
+ -- REVISIONS: October 18, 2026 - Added the -a option for a core list.
+ -- October 18, 2026 - Added the -s option to steer threads by receive CPU.
+ -- October 18, 2026 - Added the -T option for a socket tuning profile.
+ -- October 18, 2026 - Added the -d option for a document root.
+ -- October 18, 2026 - Added the -c option for the file cache limits.
+ -- October 18, 2026 - Added the -t option for request tracing.
+ -- October 18, 2026 - Added the -A option for an admin port.
+ -- October 18, 2026 - Added the -L option for admission control.
+ -- October 18, 2026 - Ignores SIGPIPE, so a client that goes away during
+ -- a send only fails that send. A thread that cannot be started closes its
+ -- connection instead of the server.
+ -- October 18, 2026 - Added the -u option to serve a UNIX domain socket path.
+ -- October 18, 2026 - Added the -l option for the address to listen on.
  --
  -- DESIGNER: Luke Queenan
  --
@@ -70,23 +126,164 @@ int main(int argc, char **argv)
     // Initialize port and give default option in case of no user input
     int port = DEFAULT_PORT;
     int option = 0;
+    int steer = 0;
+    int adminPort = 0;
+    unsigned int cacheEntries = FILE_CACHE_ENTRIES;
+    unsigned long cacheMegabytes = FILE_CACHE_MEGABYTES;
+    unsigned int traceEvery = 1;
+    char *root = 0;
+    char *tracePath = 0;
+    char *limits = 0;
+    char *end = 0;
+    char message[NETWORK_BUFFER_SIZE];
+    networkAddress listenAddress;
+    networkAddress *address = 0;
+    coreList cores;
+    
+    cores.count = 0;
     
     // Parse command line parameters using getopt
-    while ((option = getopt(argc, argv, "p:")) != -1)
+    while ((option = getopt(argc, argv, "p:a:sT:d:c:t:A:L:u:l:")) != -1)
     {
         switch (option)
         {
             case 'p':
                 port = atoi(optarg);
                 break;
+            case 'a':
+                if (parseCoreList(optarg, &cores) == -1)
+                {
+                    fprintf(stderr, "No usable cores in %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 's':
+                steer = 1;
+                break;
+            case 'd':
+                root = optarg;
+                break;
+            case 'c':
+                cacheEntries = strtoul(optarg, &end, 10);
+                if (*end == ',')
+                {
+                    cacheMegabytes = strtoul(end + 1, NULL, 10);
+                }
+                break;
+            case 't':
+                tracePath = optarg;
+                if ((end = strchr(optarg, ',')) != NULL)
+                {
+                    *end = '\0';
+                    traceEvery = strtoul(end + 1, NULL, 10);
+                }
+                break;
+            case 'A':
+                adminPort = atoi(optarg);
+                break;
+            case 'L':
+                limits = optarg;
+                break;
+            case 'l':
+                if (parseAddress(optarg, &listenAddress) == -1)
+                {
+                    fprintf(stderr, "Listen address: %s is not valid\n",
+                            optarg);
+                    return 1;
+                }
+                address = &listenAddress;
+                break;
+            case 'u':
+                if (setUnixPath(optarg) == -1)
+                {
+                    fprintf(stderr, "Socket path too long: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'T':
+                if (loadSocketTuning(optarg, message, sizeof(message)) == -1)
+                {
+                    fprintf(stderr, "Socket tuning: %s\n", message);
+                    return 1;
+                }
+                break;
             default:
-                fprintf(stderr, "Usage: %s -p [port]\n", argv[0]);
+                fprintf(stderr, "Usage: %s -p [port] -u [path] -l [address] -a [cores] -s -T [tuning] -d [root] -c [entries,megabytes] -t [trace,every] -A [admin port] -L [connections,inflight[,target us,interval ms]]\n",
+                        argv[0]);
                 return 0;
         }
     }
     
+    /* A client gone mid send is an error on its connection, not a signal */
+    signal(SIGPIPE, SIG_IGN);
+    
+    /* Calibrate the clock requests are timed with before any threads start */
+    timingInit();
+    
+    if (limits != NULL)
+    {
+        if (admissionConfigure(limits) == -1)
+        {
+            fprintf(stderr, "Admission control: %s is not valid\n", limits);
+            return 1;
+        }
+        admissionDescribe(message, sizeof(message));
+        printf("Admission control: %s\n", message);
+    }
+    
+    if (address != NULL && getUnixPath() != NULL)
+    {
+        fprintf(stderr, "A listen address cannot be used with a path\n");
+        return 1;
+    }
+    
+    describeSocketTuning(message, sizeof(message));
+    printf("Socket tuning: %s\n", message);
+    if (getUnixPath() != NULL)
+    {
+        printf("Listening on %s instead of a port\n", getUnixPath());
+    }
+    if (address != NULL)
+    {
+        describeAddress(address, message, sizeof(message));
+        printf("Listening on %s\n", message);
+    }
+    
+    if (root != NULL)
+    {
+        if (openDocumentRoot(root, cacheEntries,
+                             cacheMegabytes * 1024 * 1024) == -1)
+        {
+            perror(root);
+            return 1;
+        }
+        printf("Serving files from %s, caching up to %u files and %lu MB\n",
+               root, cacheEntries, cacheMegabytes);
+    }
+    
+    if (tracePath != NULL)
+    {
+        if (traceStart(tracePath, traceEvery) == -1)
+        {
+            perror(tracePath);
+            return 1;
+        }
+        printf("Tracing one connection in %u to %s\n",
+               traceEvery ? traceEvery : 1, tracePath);
+    }
+    
+    if (adminPort != 0)
+    {
+        if (adminStart(adminPort, "thread") == -1)
+        {
+            perror("Unable to open the admin port");
+            return 1;
+        }
+        printf("Serving metrics on port %d\n", adminPort);
+    }
+    
     // Start server
-    server(port);
+    server(port, &cores, steer, address);
     
     return 0;
 }
@@ -96,31 +293,57 @@ int main(int argc, char **argv)
  --
  -- DATE: Feb 20, 2011
  --
- -- REVISIONS: (Date and Description)
+ -- REVISIONS: October 18, 2026 - Each connection thread is started on the
+ -- next core in the core list, if there is one.
+ -- October 18, 2026 - With steer set, the thread is started on the CPU that
+ -- received the connection, as long as that CPU is in the core list.
+ -- October 18, 2026 - Counts the accepts in the engine statistics and starts
+ -- the reporter.
+ -- October 18, 2026 - The thread is given a clientData with the socket and
+ -- the connection's trace id.
+ -- October 18, 2026 - Counts the accepted connections.
+ -- October 18, 2026 - Waits while admission control has paused accepting,
+ -- and resets the connections it does not admit.
+ -- October 18, 2026 - Listens on the given address, if there is one, and
+ -- has room for an IPv6 client's address.
+ -- October 18, 2026 - A failed accept is counted and retried instead of
+ -- ending the server.
  --
  -- DESIGNER: Luke Queenan
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: void server(int)
+ -- INTERFACE: void server(int, const coreList *, int,
+ --                        const networkAddress *)
  --
  -- RETURNS: void
  --
  -- NOTES:
  -- This function contains the server loop for the thread server. It blocks
  -- on accept, and when a connection is detected, a new thread is spawned to
- -- handle the client.
+ -- handle the client. When steering, the CPU that took the connection in
+ -- softirq is read back with SO_INCOMING_CPU and the handler is run there,
+ -- so the socket and its buffers are used on the core that filled them.
+ --
+ -- A failed accept is counted as a connection error. When the process or
+ -- the system is out of descriptors or memory the loop backs off for
+ -- ACCEPT_BACKOFF milliseconds, so it does not spin while the connections
+ -- being served close and give some back.
  */
-void server(int port)
+void server(int port, const coreList *cores, int steer,
+            const networkAddress *address)
 {
     int listenSocket = 0;
     int socket = 0;
+    int core = 0;
     int comms[2];
     unsigned long long connectedClients = 0;
-    char clientIp[16];
-    long data = 0;
+    char clientIp[NETWORK_ADDRESS_SIZE];
+    char placement[NETWORK_BUFFER_SIZE];
+    clientData *data = 0;
     pthread_t thread = 0;
     pthread_attr_t attr;
+    engineCounters *engine = 0;
     
     /* Create the socket pair for sending data for collection */
     if (socketpair(AF_UNIX, SOCK_STREAM, 0, comms) == -1)
@@ -139,31 +362,93 @@ void server(int port)
     
     /* Set the thread for kernel management. This means that system calls will
      not block all threads in the process and that individual threads can be
-     assigned to indiviudal processors in the system. */
+     scheduled on any processor in the system. They are only pinned to one
+     when a core list is given. */
     if (pthread_attr_setscope(&attr, PTHREAD_SCOPE_SYSTEM) != 0)
     {
         systemFatal("Unable to set thread to system scope");
     }
     
     /* Initialize the server */
-    initializeServer(&listenSocket, &port);
+    initializeServer(&listenSocket, &port, address);
+    
+    /* The accepting thread counts too, a new thread per connection is part of
+     what this engine costs */
+    if ((engine = engineJoin()) == NULL ||
+        engineStartReporter("Thread server") == -1)
+    {
+        systemFatal("Unable to start the engine statistics");
+    }
+    
+    if (cores->count != 0)
+    {
+        describeCoreList(cores, placement, sizeof(placement));
+        printf("Placing connection threads on cores %s\n", placement);
+    }
     
     while (1)
     {
+        /* Leave new connections in the backlog while too many requests are
+         being answered */
+        while (admissionPaused())
+        {
+            usleep(ADMISSION_RECHECK * 1000);
+        }
+        
         /* Block on accepting connections */
         if ((socket = acceptConnectionIp(&listenSocket, clientIp)) == -1)
         {
-            systemFatal("Unable to accept client");
+            engineError(engine, engineErrorType(errno));
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS ||
+                errno == ENOMEM)
+            {
+                usleep(ACCEPT_BACKOFF * 1000);
+            }
+            continue;
+        }
+        if (!admitConnection())
+        {
+            engine->rejected++;
+            rejectConnection(socket);
+            continue;
         }
+        engine->accepts++;
         
-        /* Store the data needed in the thread */
-        data = (long)socket << sizeof(int) | comms[1];
+        /* Store the data needed in the thread, which frees it */
+        if ((data = malloc(sizeof(clientData))) == NULL)
+        {
+            systemFatal("Unable to allocate client data");
+        }
+        data->socket = socket;
+        data->commSocket = comms[1];
+        data->trace = traceConnection();
+        TRACE(data->trace, TRACE_ACCEPTED);
+        
+        /* Start the thread on the receiving CPU or the next core, the stack
+         and buffers of the thread are then first touched on that core's node */
+        core = steer ? incomingCpu(&socket) : -1;
+        if (!coreListHas(cores, core))
+        {
+            core = affinityCore(cores, connectedClients);
+        }
+        if ((steer || cores->count != 0) &&
+            setAttrAffinity(&attr, core) != 0)
+        {
+            systemFatal("Unable to set thread affinity");
+        }
         
         /* Create the thread */
+        countSyscall(0);
         if (pthread_create(&thread, &attr, processConnection,
                            (void *) data) != 0)
         {
-            systemFatal("Unable to make thread to handle client");
+            /* Only this connection is lost */
+            engineError(engine, ENGINE_ERROR_IO);
+            engine->closes++;
+            admissionClosed();
+            close(socket);
+            free(data);
+            continue;
         }
         
         /* Increment our count of connected clients and display it */
@@ -177,7 +462,21 @@ void server(int port)
  --
  -- DATE: Feb 20, 2011
  --
- -- REVISIONS: (Date and Description)
+ -- REVISIONS: October 18, 2026 - Requests that start with a slash are
+ -- served from the document root.
+ -- October 18, 2026 - Each connection thread keeps its own engine
+ -- statistics.
+ -- October 18, 2026 - Takes a clientData, and records trace events for
+ -- traced connections.
+ -- October 18, 2026 - Counts the closed connection and the time taken to
+ -- answer each request.
+ -- October 18, 2026 - Reports each request and the closed connection to
+ -- admission control.
+ -- October 18, 2026 - A malformed request closes the connection instead of
+ -- exiting.
+ -- October 18, 2026 - A failed send also only closes the connection. Every
+ -- way out of the loop now shares the one close, and the errors are counted
+ -- by type.
  --
  -- DESIGNER: Luke Queenan
  --
@@ -190,14 +489,22 @@ void server(int port)
  -- NOTES:
  -- Service a client socket by reading a request and sending the data to the
  -- client continueously in a loop until the client closes the connection.
+ -- The thread blocks in its reads rather than waking from an event loop, so
+ -- it has no wakeups to count.
  */
 void *processConnection(void *data)
 {
-    int comm = (int) (long) data;
-    int socket = (long) data >> sizeof(int);
+    clientData *client = (clientData *)data;
+    int socket = client->socket;
+    unsigned int trace = client->trace;
     int bytesToWrite = 0;
+    unsigned long long started = 0;
+    unsigned long long elapsed = 0;
     char line[NETWORK_BUFFER_SIZE];
     char result[NETWORK_BUFFER_SIZE];
+    engineCounters *engine = engineJoin();
+    
+    free(client);
     
     /* Ready the memory for sending to the client */
     memset(result, 'L', NETWORK_BUFFER_SIZE);
@@ -206,27 +513,79 @@ void *processConnection(void *data)
     while (1)
     {
         /* Read the request from the client */
-        if (readLine(&socket, line, NETWORK_BUFFER_SIZE) <= 0)
+        if ((bytesToWrite = readLine(&socket, line,
+                                     NETWORK_BUFFER_SIZE - 1)) <= 0)
         {
-            close(socket);
-            pthread_exit(NULL);
+            if (bytesToWrite == -1)
+            {
+                engineError(engine, engineErrorType(errno));
+            }
+            break;
         }
+        line[bytesToWrite] = '\0';
+        TRACE(trace, TRACE_PARSED);
+        started = timingNow();
+        admissionBegin(1);
         
-        /* Get the number of bytes to reply with */
-        bytesToWrite = atol(line);
+        if (engine != NULL &&
+            ++engine->requests % ENGINE_SAMPLE_EVERY == 0)
+        {
+            engineSample(engine);
+        }
+        
+        /* Stream a file if one was asked for */
+        if (isFileRequest(line))
+        {
+            if (serveFile(&socket, line) == -1)
+            {
+                engineError(engine, engineErrorType(errno));
+                admissionDone(1, timingNow() - started);
+                break;
+            }
+            TRACE(trace, TRACE_SENT);
+            elapsed = timingNow() - started;
+            admissionDone(1, elapsed);
+            if (engine != NULL)
+            {
+                engineLatency(engine, elapsed, 1);
+            }
+            continue;
+        }
         
-        /* Ensure that the bytes requested are within our buffers */
-        if ((bytesToWrite <= 0) || (bytesToWrite > NETWORK_BUFFER_SIZE))
+        /* Get the number of bytes to reply with, within our buffers */
+        if ((bytesToWrite = requestSize(line, NETWORK_BUFFER_SIZE)) == -1)
         {
-            systemFatal("Client requested too large a file");
+            engineError(engine, ENGINE_ERROR_MALFORMED);
+            admissionDone(1, timingNow() - started);
+            break;
         }
         
         /* Send the data back to the client */
+        TRACE(trace, TRACE_QUEUED);
         if (sendData(&socket, result, bytesToWrite) == -1)
         {
-            systemFatal("Send fail");
+            engineError(engine, engineErrorType(errno));
+            admissionDone(1, timingNow() - started);
+            break;
         }
+        TRACE(trace, TRACE_SENT);
+        elapsed = timingNow() - started;
+        admissionDone(1, elapsed);
+        if (engine != NULL)
+        {
+            engineLatency(engine, elapsed, 1);
+        }
+    }
+    
+    /* Only this connection is closed, the other threads carry on */
+    if (engine != NULL)
+    {
+        engine->closes++;
     }
+    engineLeave(engine);
+    admissionClosed();
+    close(socket);
+    pthread_exit(NULL);
 }
                           
 /*
@@ -236,12 +595,15 @@ void *processConnection(void *data)
  --
  -- REVISIONS: September 22, 2011 - Added some extra comments about failure and
  -- a function call to set the socket into non blocking mode.
+ -- October 18, 2026 - Makes a UNIX domain socket when serving a path.
+ -- October 18, 2026 - Binds to the given address, if there is one.
  --
  -- DESIGNER: Luke Queenan
  --
  -- PROGRAMMER: Luke Queenan
  --
- -- INTERFACE: void initializeServer(int *listenSocket, int *port);
+ -- INTERFACE: void initializeServer(int *listenSocket, int *port,
+ --                                  const networkAddress *address);
  --
  -- RETURNS: void
  --
@@ -251,10 +613,13 @@ void *processConnection(void *data)
  -- setting it to listen. If an error occurs, the function calls "systemFatal"
  -- with an error message.
  */
-void initializeServer(int *listenSocket, int *port)
+void initializeServer(int *listenSocket, int *port,
+                      const networkAddress *address)
 {
-    // Create a TCP socket
-    if ((*listenSocket = tcpSocket()) == -1)
+    // Create a TCP socket for the address, or a UNIX domain one when serving
+    // a path
+    *listenSocket = (address != NULL) ? addressSocket(address) : streamSocket();
+    if (*listenSocket == -1)
     {
         systemFatal("Cannot Create Socket!");
     }
@@ -266,7 +631,8 @@ void initializeServer(int *listenSocket, int *port)
     }
     
     // Bind an address to the socket
-    if (bindAddress(port, listenSocket) == -1)
+    if ((address != NULL ? bindAddressTo(address, port, listenSocket) :
+         bindAddress(port, listenSocket)) == -1)
     {
         systemFatal("Cannot Bind Address To Socket");
     }
@@ -280,7 +646,13 @@ void initializeServer(int *listenSocket, int *port)
 
 void displayClientData(unsigned long long clients)
 {
+    char cache[NETWORK_BUFFER_SIZE];
+    
     printf("Connected clients: %llu\n", clients);
+    if (describeFileCache(cache, sizeof(cache)) > 0)
+    {
+        printf("File cache: %s\n", cache);
+    }
 }
 
 /*
@@ -0,0 +1,311 @@
+/*
+ -- SOURCE FILE: timing.c
+ --
+ -- PROGRAM: Web Client Emulator
+ --
+ -- FUNCTIONS:
+ -- int timingInit();
+ -- unsigned long long timingNow();
+ -- const char *timingSource();
+ -- static int invariantTsc();
+ -- static unsigned long long readTicks();
+ -- static unsigned long long monotonicNow();
+ -- static unsigned long long calibrate();
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- NOTES:
+ -- A fast monotonic clock for timing requests. Every request is timed twice,
+ -- so the clock is read far more often than anything else the client does and
+ -- gettimeofday was both too coarse and able to jump with the wall clock.
+ --
+ -- On x86 processors with an invariant TSC the clock is the TSC, scaled to
+ -- nanoseconds. The scale is found by timingInit, which counts the ticks in
+ -- two windows of TIMING_CALIBRATE_NS measured with CLOCK_MONOTONIC. If the
+ -- two rates disagree by more than TIMING_TOLERANCE_PPM the TSC is not
+ -- trusted. Without an invariant TSC, or when calibration fails, the clock
+ -- falls back to CLOCK_MONOTONIC, which the vDSO still answers without a
+ -- system call on most machines.
+ --
+ -- Either way the times are nanoseconds on the CLOCK_MONOTONIC time line, so
+ -- they can be compared with times taken with clock_gettime. Only the
+ -- difference between two times is meaningful. timingInit must be called
+ -- before any threads read the clock.
+ */
+
+// Includes
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+#include "timing.h"
+
+static int invariantTsc();
+static unsigned long long readTicks();
+static unsigned long long monotonicNow();
+static unsigned long long calibrate();
+
+/* The ticks and time the TSC was calibrated at and the nanoseconds per tick
+ as a 32.32 fixed point number, nothing is used until useTsc is set */
+static int useTsc = 0;
+static unsigned long long baseTicks = 0;
+static unsigned long long baseTime = 0;
+static unsigned long long scale = 0;
+
+/*
+ -- FUNCTION: timingInit
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int timingInit();
+ --
+ -- RETURNS: 1 if the TSC is used, 0 if the clock fell back to CLOCK_MONOTONIC
+ --
+ -- NOTES:
+ -- Calibrates the TSC against CLOCK_MONOTONIC twice and uses it if the two
+ -- rates agree. Takes about twice TIMING_CALIBRATE_NS.
+ */
+int timingInit()
+{
+    unsigned long long first = 0;
+    unsigned long long second = 0;
+    unsigned long long drift = 0;
+    
+    useTsc = 0;
+    
+    if (!invariantTsc())
+    {
+        return 0;
+    }
+    
+    /* The first clock read faults in the vDSO, keep it out of the windows */
+    monotonicNow();
+    
+    if ((first = calibrate()) == 0 || (second = calibrate()) == 0)
+    {
+        return 0;
+    }
+    
+    /* A TSC that changes rate is no better than no TSC at all */
+    drift = first > second ? first - second : second - first;
+    if (drift * 1000000ULL / first > TIMING_TOLERANCE_PPM)
+    {
+        return 0;
+    }
+    
+    scale = first / 2 + second / 2;
+    baseTicks = readTicks();
+    baseTime = monotonicNow();
+    baseTicks += (readTicks() - baseTicks) / 2;
+    useTsc = 1;
+    
+    return 1;
+}
+
+/*
+ -- FUNCTION: timingNow
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: unsigned long long timingNow();
+ --
+ -- RETURNS: the current monotonic time in nanoseconds
+ --
+ -- NOTES:
+ -- A reading from a core whose TSC is behind the one that calibrated is held
+ -- at the calibration time so that a difference never goes negative.
+ */
+unsigned long long timingNow()
+{
+    unsigned long long ticks = 0;
+    
+    if (!useTsc)
+    {
+        return monotonicNow();
+    }
+    
+    ticks = readTicks();
+    if (ticks < baseTicks)
+    {
+        return baseTime;
+    }
+    
+    return baseTime + (unsigned long long)(((unsigned __int128)
+                                            (ticks - baseTicks) * scale) >> 32);
+}
+
+/*
+ -- FUNCTION: timingSource
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: const char *timingSource();
+ --
+ -- RETURNS: the name of the clock timingNow reads, "tsc" or "monotonic"
+ */
+const char *timingSource()
+{
+    return useTsc ? "tsc" : "monotonic";
+}
+
+/*
+ -- FUNCTION: invariantTsc
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int invariantTsc();
+ --
+ -- RETURNS: 1 if the processor has an invariant TSC, 0 otherwise
+ --
+ -- NOTES:
+ -- An invariant TSC runs at the same rate in every power state, which is
+ -- bit 8 of EDX in CPUID leaf 0x80000007.
+ */
+static int invariantTsc()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+    
+    if (__get_cpuid_max(0x80000000, 0) < 0x80000007)
+    {
+        return 0;
+    }
+    __cpuid(0x80000007, eax, ebx, ecx, edx);
+    
+    return (edx & (1 << 8)) != 0;
+#else
+    return 0;
+#endif
+}
+
+/*
+ -- FUNCTION: readTicks
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static unsigned long long readTicks();
+ --
+ -- RETURNS: the TSC, or 0 on processors without one
+ */
+static unsigned long long readTicks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/*
+ -- FUNCTION: monotonicNow
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static unsigned long long monotonicNow();
+ --
+ -- RETURNS: CLOCK_MONOTONIC in nanoseconds
+ */
+static unsigned long long monotonicNow()
+{
+    struct timespec now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/*
+ -- FUNCTION: calibrate
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static unsigned long long calibrate();
+ --
+ -- RETURNS: the nanoseconds per tick as a 32.32 fixed point number, 0 if the
+ --          TSC did not move
+ --
+ -- NOTES:
+ -- Spins for TIMING_CALIBRATE_NS and counts the ticks. Each end takes the
+ -- middle of two TSC readings either side of the clock read, so the cost of
+ -- clock_gettime does not end up in the rate.
+ */
+static unsigned long long calibrate()
+{
+    unsigned long long before = 0;
+    unsigned long long startTicks = 0;
+    unsigned long long startTime = 0;
+    unsigned long long endTicks = 0;
+    unsigned long long endTime = 0;
+    
+    before = readTicks();
+    startTime = monotonicNow();
+    startTicks = before + (readTicks() - before) / 2;
+    
+    do
+    {
+        before = readTicks();
+        endTime = monotonicNow();
+        endTicks = before + (readTicks() - before) / 2;
+    }
+    while (endTime - startTime < TIMING_CALIBRATE_NS);
+    
+    if (endTicks <= startTicks)
+    {
+        return 0;
+    }
+    
+    return ((endTime - startTime) << 32) / (endTicks - startTicks);
+}
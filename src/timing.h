@@ -0,0 +1,18 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+/* Defines */
+#define TIMING_CALIBRATE_NS 10000000ULL
+#define TIMING_TOLERANCE_PPM 500
+
+/* Function Prototypes */
+#ifdef __cplusplus
+extern "C" {
+#endif
+    int timingInit();
+    unsigned long long timingNow();
+    const char *timingSource();
+#ifdef __cplusplus
+}
+#endif
+#endif
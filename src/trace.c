@@ -0,0 +1,512 @@
+/*
+ -- SOURCE FILE: trace.c
+ --
+ -- PROGRAM: Web Client Emulator
+ --
+ -- FUNCTIONS:
+ -- int traceStart(const char *path, unsigned int every);
+ -- unsigned int traceConnection();
+ -- void traceEvent(unsigned int id, unsigned int event);
+ -- const char *traceEventName(unsigned int event);
+ -- static traceRing *joinTrace();
+ -- static void leaveTrace(void *data);
+ -- static void makeRingKey();
+ -- static void *flusher(void *data);
+ -- static int drainRing(traceRing *ring, FILE *file);
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - The ring of a thread that exits is given to
+ -- the next thread that traces once the flusher has drained it, so a server
+ -- that makes a thread per connection keeps as many rings as it has threads
+ -- at once rather than one for every thread it ever ran.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- NOTES:
+ -- Request tracing for the servers, for finding out where the time of a slow
+ -- request went. One connection in every N is sampled when it is accepted
+ -- and given a trace id, and the servers record the events of that
+ -- connection against the id:
+ --
+ --     accepted, readable, line parsed, reply queued, reply fully sent
+ --
+ -- Connections that are not sampled have an id of zero, and the TRACE macro
+ -- tests the id before calling in here, so with tracing off the servers pay
+ -- one test per event and nothing else.
+ --
+ -- Each thread records into a ring of its own that only it writes, with the
+ -- time from CLOCK_MONOTONIC_RAW, which is read in the vDSO and is not slewed
+ -- by NTP. A flusher thread wakes every TRACE_FLUSH_INTERVAL seconds and
+ -- appends what is new in each ring to the trace file. The thread publishes
+ -- its position in the ring after writing an entry, and the flusher checks
+ -- the position again after copying, so entries the thread lapped while they
+ -- were being copied are thrown away and counted as dropped rather than
+ -- written torn. Neither side ever takes a lock once the ring is set up.
+ --
+ -- Rings are never freed, since the flusher may be reading one at any time.
+ -- When a thread exits its ring is marked retired, the flusher marks it free
+ -- once it has written what was left in it, and the next thread to trace
+ -- takes it over along with its thread number. Thread numbers are therefore
+ -- those of the rings, and one may stand for several threads in turn.
+ --
+ -- The file is a traceHeader followed by traceEntry records, and traceDump
+ -- turns it into Chrome trace JSON. The last second of events is lost when a
+ -- server is killed.
+ */
+
+// Includes
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+/* Who a ring belongs to */
+#define RING_OWNED 0
+#define RING_RETIRED 1
+#define RING_FREE 2
+
+/* The events recorded by one thread */
+typedef struct traceRing
+{
+    unsigned int thread;
+    volatile int state;
+    volatile unsigned long long head;
+    unsigned long long tail;
+    struct traceRing *next;
+    traceEntry entries[TRACE_RING_SIZE];
+} traceRing;
+
+static traceRing *joinTrace();
+static void leaveTrace(void *data);
+static void makeRingKey();
+static void *flusher(void *data);
+static int drainRing(traceRing *ring, FILE *file);
+
+/* Sample one connection in this many, zero when tracing is off */
+static unsigned int sampleEvery = 0;
+static unsigned int connectionsSeen = 0;
+
+/* Every ring, rings are never freed so the flusher can always read them. The
+ key gives a thread's ring back when the thread exits */
+static traceRing *rings = 0;
+static unsigned int ringCount = 0;
+static pthread_mutex_t ringLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t ringKey;
+static pthread_once_t ringKeyOnce = PTHREAD_ONCE_INIT;
+static __thread traceRing *ownRing = 0;
+
+/* Entries thrown away because a ring was lapped before it was flushed */
+static unsigned long long dropped = 0;
+
+static const char *eventNames[] = {"unknown", "accepted", "readable",
+                                   "line parsed", "reply queued",
+                                   "reply sent"};
+
+/*
+ -- FUNCTION: traceStart
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int traceStart(const char *path, unsigned int every);
+ --
+ -- RETURNS: 0 on success, -1 on failure
+ --
+ -- NOTES:
+ -- Creates the trace file, starts the flusher and turns on sampling of one
+ -- connection in every. An every of 1 traces every connection.
+ */
+int traceStart(const char *path, unsigned int every)
+{
+    FILE *file = 0;
+    pthread_t thread = 0;
+    pthread_attr_t attr;
+    traceHeader header;
+    
+    if ((file = fopen(path, "wb")) == NULL)
+    {
+        return -1;
+    }
+    
+    header.magic = TRACE_MAGIC;
+    header.version = TRACE_VERSION;
+    if (fwrite(&header, sizeof(header), 1, file) != 1 || fflush(file) != 0)
+    {
+        fclose(file);
+        return -1;
+    }
+    
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, flusher, file) != 0)
+    {
+        pthread_attr_destroy(&attr);
+        fclose(file);
+        return -1;
+    }
+    pthread_attr_destroy(&attr);
+    
+    sampleEvery = (every == 0) ? 1 : every;
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: traceConnection
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: unsigned int traceConnection();
+ --
+ -- RETURNS: the trace id of a new connection, or 0 if it is not traced
+ --
+ -- NOTES:
+ -- Decides whether a newly accepted connection is sampled.
+ */
+unsigned int traceConnection()
+{
+    unsigned int count = 0;
+    
+    if (sampleEvery == 0)
+    {
+        return 0;
+    }
+    
+    count = __sync_add_and_fetch(&connectionsSeen, 1);
+    
+    return (count % sampleEvery == 0) ? count : 0;
+}
+
+/*
+ -- FUNCTION: traceEvent
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void traceEvent(unsigned int id, unsigned int event);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Records an event of a traced connection in the calling thread's ring,
+ -- setting the ring up on the thread's first event. Call it through TRACE.
+ */
+void traceEvent(unsigned int id, unsigned int event)
+{
+    struct timespec now;
+    traceEntry *entry = 0;
+    
+    if (ownRing == NULL && (ownRing = joinTrace()) == NULL)
+    {
+        return;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    
+    entry = &ownRing->entries[ownRing->head % TRACE_RING_SIZE];
+    entry->time = now.tv_sec * 1000000000ULL + now.tv_nsec;
+    entry->id = id;
+    entry->event = event;
+    entry->thread = ownRing->thread;
+    
+    /* Publish the entry only once it is complete */
+    __sync_synchronize();
+    ownRing->head++;
+}
+
+/*
+ -- FUNCTION: traceEventName
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: const char *traceEventName(unsigned int event);
+ --
+ -- RETURNS: the name of the event
+ --
+ -- NOTES:
+ -- Names an event for the dump tool.
+ */
+const char *traceEventName(unsigned int event)
+{
+    if (event > TRACE_SENT)
+    {
+        event = 0;
+    }
+    
+    return eventNames[event];
+}
+
+/*
+ -- FUNCTION: joinTrace
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Takes over a free ring before allocating
+ -- one, and registers the ring to be given back when the thread exits.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static traceRing *joinTrace();
+ --
+ -- RETURNS: a ring for the calling thread, or NULL if out of memory or out
+ --          of thread numbers
+ --
+ -- NOTES:
+ -- Finds the calling thread a ring, one left by a thread that has exited if
+ -- the flusher has drained it, otherwise a new one added to the list the
+ -- flusher reads. New rings stop once the thread numbers of the trace
+ -- entries run out, and the threads past that are not traced.
+ */
+static traceRing *joinTrace()
+{
+    traceRing *ring = 0;
+    
+    pthread_once(&ringKeyOnce, makeRingKey);
+    
+    pthread_mutex_lock(&ringLock);
+    for (ring = rings; ring != NULL; ring = ring->next)
+    {
+        if (ring->state == RING_FREE)
+        {
+            ring->state = RING_OWNED;
+            break;
+        }
+    }
+    if (ring == NULL && ringCount <= UINT16_MAX &&
+        (ring = calloc(1, sizeof(traceRing))) != NULL)
+    {
+        ring->thread = ringCount++;
+        ring->state = RING_OWNED;
+        ring->next = rings;
+        rings = ring;
+    }
+    pthread_mutex_unlock(&ringLock);
+    
+    if (ring != NULL)
+    {
+        pthread_setspecific(ringKey, ring);
+    }
+    
+    return ring;
+}
+
+/*
+ -- FUNCTION: leaveTrace
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void leaveTrace(void *data);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- The destructor of the ring key, run by a thread with a ring as it exits.
+ -- The ring is retired once its last entry is published, and the flusher
+ -- frees it for another thread after draining it.
+ */
+static void leaveTrace(void *data)
+{
+    traceRing *ring = (traceRing *)data;
+    
+    ownRing = NULL;
+    __sync_synchronize();
+    ring->state = RING_RETIRED;
+}
+
+/*
+ -- FUNCTION: makeRingKey
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void makeRingKey();
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Creates the key that retires a thread's ring when it exits. Run once,
+ -- by the first thread to trace.
+ */
+static void makeRingKey()
+{
+    pthread_key_create(&ringKey, leaveTrace);
+}
+
+/*
+ -- FUNCTION: flusher
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - Frees the rings of the threads that have
+ -- exited once they are drained.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static void *flusher(void *data);
+ --
+ -- RETURNS: NULL once the trace file cannot be written
+ --
+ -- NOTES:
+ -- The thread started by traceStart. Every interval it drains each ring into
+ -- the trace file and reports any entries it had to drop. A ring that was
+ -- retired before it was drained has nothing more coming, and is marked free
+ -- for joinTrace to hand out again.
+ */
+static void *flusher(void *data)
+{
+    FILE *file = (FILE *)data;
+    traceRing *ring = 0;
+    int retired = 0;
+    unsigned long long reported = 0;
+    
+    while (1)
+    {
+        sleep(TRACE_FLUSH_INTERVAL);
+        
+        pthread_mutex_lock(&ringLock);
+        ring = rings;
+        pthread_mutex_unlock(&ringLock);
+        
+        /* Rings are only ever added at the front, so the list from here on
+         does not change under us */
+        for (; ring != NULL; ring = ring->next)
+        {
+            retired = (ring->state == RING_RETIRED);
+            __sync_synchronize();
+            if (drainRing(ring, file) == -1)
+            {
+                perror("Unable to write the trace file");
+                fclose(file);
+                return NULL;
+            }
+            if (retired)
+            {
+                ring->state = RING_FREE;
+            }
+        }
+        if (fflush(file) != 0)
+        {
+            perror("Unable to write the trace file");
+            fclose(file);
+            return NULL;
+        }
+        
+        if (dropped != reported)
+        {
+            fprintf(stderr, "Trace: %llu events dropped, the rings filled "
+                    "between flushes\n", dropped - reported);
+            reported = dropped;
+        }
+    }
+    
+    return NULL;
+}
+
+/*
+ -- FUNCTION: drainRing
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int drainRing(traceRing *ring, FILE *file);
+ --
+ -- RETURNS: 0 on success, -1 if the file could not be written
+ --
+ -- NOTES:
+ -- Writes the entries added to the ring since the last drain. The entries are
+ -- copied out first, then the head is read again and any entry the thread may
+ -- have overwritten during the copy is dropped.
+ */
+static int drainRing(traceRing *ring, FILE *file)
+{
+    static traceEntry copy[TRACE_RING_SIZE];
+    unsigned long long head = ring->head;
+    unsigned long long first = ring->tail;
+    unsigned long long index = 0;
+    unsigned long long count = 0;
+    
+    __sync_synchronize();
+    
+    /* Anything more than a ring behind is gone already */
+    if (head - first > TRACE_RING_SIZE)
+    {
+        first = head - TRACE_RING_SIZE;
+    }
+    for (index = first; index < head; index++)
+    {
+        copy[count++] = ring->entries[index % TRACE_RING_SIZE];
+    }
+    
+    /* Entries the thread has come round to again may be torn, counting the
+     one it may be writing now */
+    __sync_synchronize();
+    if (ring->head + 1 - first > TRACE_RING_SIZE)
+    {
+        index = ring->head + 1 - TRACE_RING_SIZE - first;
+        index = (index > count) ? count : index;
+        first += index;
+    }
+    else
+    {
+        index = 0;
+    }
+    dropped += (first - ring->tail);
+    ring->tail = head;
+    
+    if (head > first && fwrite(copy + index, sizeof(traceEntry),
+                               head - first, file) != head - first)
+    {
+        return -1;
+    }
+    
+    return 0;
+}
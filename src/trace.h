@@ -0,0 +1,50 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+/* Defines */
+#define TRACE_MAGIC 0x45435254
+#define TRACE_VERSION 1
+#define TRACE_RING_SIZE 65536
+#define TRACE_FLUSH_INTERVAL 1
+
+/* Events in the life of a traced connection */
+#define TRACE_ACCEPTED 1
+#define TRACE_READABLE 2
+#define TRACE_PARSED 3
+#define TRACE_QUEUED 4
+#define TRACE_SENT 5
+
+/* Records the event if the connection is being traced, which costs a single
+ test of the trace id when tracing is off */
+#define TRACE(id, event) do { if (id) traceEvent(id, event); } while (0)
+
+/* Starts every trace file */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+} traceHeader;
+
+/* One event, as kept in the rings and written to the trace file */
+typedef struct
+{
+    uint64_t time;
+    uint32_t id;
+    uint16_t event;
+    uint16_t thread;
+} traceEntry;
+
+/* Function Prototypes */
+#ifdef __cplusplus
+extern "C" {
+#endif
+    int traceStart(const char *path, unsigned int every);
+    unsigned int traceConnection();
+    void traceEvent(unsigned int id, unsigned int event);
+    const char *traceEventName(unsigned int event);
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,183 @@
+/*-----------------------------------------------------------------------------
+ --	SOURCE FILE:    traceDump.c - Turns a server trace into Chrome trace JSON
+ --
+ --	PROGRAM:		Web Client Emulator
+ --
+ --	FUNCTIONS:
+ --                 int main(int argc, char **argv);
+ --                 static openRequest *findRequest(unsigned int id);
+ --
+ --	DATE:			October 18, 2026
+ --
+ --	REVISIONS:		(Date and Description)
+ --
+ --	DESIGNERS:      Luke Queenan
+ --
+ --	PROGRAMMERS:	Luke Queenan
+ --
+ --	NOTES:
+ -- Reads a trace file written by a server started with -t and prints it as
+ -- Chrome trace JSON, which chrome://tracing and Perfetto can open:
+ --
+ --     traceDump.out trace.bin > trace.json
+ --
+ -- Every event becomes an instant event on the thread that recorded it, with
+ -- the connection's trace id as an argument. On top of those, the time from
+ -- the first request parsed on a connection to the reply that answers it
+ -- being fully sent is shown as a "request" slice, so slow requests stand
+ -- out as long bars. A reply sent for several pipelined requests closes all
+ -- of them, and the slice covers the oldest.
+ ----------------------------------------------------------------------------*/
+
+/* System includes */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/* User includes */
+#include "trace.h"
+
+/* Slots in the table of connections with requests in flight */
+#define OPEN_REQUESTS (1 << 20)
+
+/* The oldest request waiting for its reply on a connection */
+typedef struct
+{
+    unsigned int id;
+    unsigned int waiting;
+    unsigned long long parsed;
+} openRequest;
+
+int main(int argc, char **argv);
+static openRequest *findRequest(unsigned int id);
+
+static openRequest *requests = 0;
+
+/*
+ -- FUNCTION: main
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int main(argc, char **argv)
+ --
+ -- RETURNS: 0 on success, 1 on failure
+ --
+ -- NOTES:
+ -- This is the main entry point for the trace dump tool
+ */
+int main(int argc, char **argv)
+{
+    FILE *file = 0;
+    const char *separator = "";
+    unsigned long long events = 0;
+    traceHeader header;
+    traceEntry entry;
+    openRequest *request = 0;
+    
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s trace\n", argv[0]);
+        return 1;
+    }
+    
+    if ((file = fopen(argv[1], "rb")) == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        header.magic != TRACE_MAGIC || header.version != TRACE_VERSION)
+    {
+        fprintf(stderr, "%s is not a trace file\n", argv[1]);
+        fclose(file);
+        return 1;
+    }
+    
+    if ((requests = calloc(OPEN_REQUESTS, sizeof(openRequest))) == NULL)
+    {
+        fprintf(stderr, "Could not allocate the request table\n");
+        fclose(file);
+        return 1;
+    }
+    
+    printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    while (fread(&entry, sizeof(entry), 1, file) == 1)
+    {
+        printf("%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,"
+               "\"pid\":1,\"tid\":%u,\"args\":{\"connection\":%u}}",
+               separator, traceEventName(entry.event), entry.time / 1000.0,
+               entry.thread, entry.id);
+        separator = ",\n";
+        events++;
+        
+        if ((request = findRequest(entry.id)) == NULL)
+        {
+            continue;
+        }
+        if (entry.event == TRACE_PARSED && request->waiting++ == 0)
+        {
+            request->parsed = entry.time;
+        }
+        else if (entry.event == TRACE_SENT && request->waiting != 0)
+        {
+            printf("%s{\"name\":\"request\",\"ph\":\"X\",\"ts\":%.3f,"
+                   "\"dur\":%.3f,\"pid\":1,\"tid\":%u,\"args\":"
+                   "{\"connection\":%u,\"requests\":%u}}", separator,
+                   request->parsed / 1000.0,
+                   (entry.time - request->parsed) / 1000.0, entry.thread,
+                   entry.id, request->waiting);
+            request->waiting = 0;
+        }
+    }
+    printf("\n]}\n");
+    
+    fprintf(stderr, "%llu events\n", events);
+    
+    free(requests);
+    fclose(file);
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: findRequest
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static openRequest *findRequest(unsigned int id)
+ --
+ -- RETURNS: the slot of the connection, or NULL if the table is full
+ --
+ -- NOTES:
+ -- Finds or adds the connection in an open addressed table keyed by its trace
+ -- id.
+ */
+static openRequest *findRequest(unsigned int id)
+{
+    unsigned int slot = (id * 2654435761U) % OPEN_REQUESTS;
+    unsigned int probes = 0;
+    
+    for (probes = 0; probes < OPEN_REQUESTS; probes++)
+    {
+        if (requests[slot].id == id || requests[slot].id == 0)
+        {
+            requests[slot].id = id;
+            return &requests[slot];
+        }
+        slot = (slot + 1) % OPEN_REQUESTS;
+    }
+    
+    return NULL;
+}
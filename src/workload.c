@@ -0,0 +1,701 @@
+/*
+ -- SOURCE FILE: workload.c
+ --
+ -- PROGRAM: Web Client Emulator
+ --
+ -- FUNCTIONS:
+ -- int loadWorkloadProfile(const char *path, workloadProfile *profile,
+ --                         unsigned int maxSize, char *error,
+ --                         size_t errorLength);
+ -- void freeWorkloadProfile(workloadProfile *profile);
+ -- unsigned long long nextRandom(unsigned long long *state);
+ -- unsigned int sampleDistribution(const distribution *table,
+ --                                 unsigned long long *state);
+ -- static int readProfile(FILE *file, workloadProfile *profile,
+ --                        char *error, size_t errorLength);
+ -- static int checkProfile(workloadProfile *profile, unsigned int maxSize,
+ --                         char *error, size_t errorLength);
+ -- static int parseDistribution(char *line, distribution *table,
+ --                              char *error, size_t errorLength);
+ -- static int parsePoints(const char *type, char *rest,
+ --                        unsigned int *values, double *weights,
+ --                        char *error, size_t errorLength);
+ -- static int buildDistribution(distribution *table, unsigned int *values,
+ --                              double *weights, unsigned int entries);
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 19, 2026 - Split the loading into functions that
+ -- return on the first error instead of jumping to a cleanup label.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- NOTES:
+ -- This file loads workload profiles for the client. A profile is a text file
+ -- made up of connection classes, each with a weight, a request size
+ -- distribution and a think time distribution:
+ --
+ --     # comment
+ --     class small 70
+ --     size zipf 1.2 16 512
+ --     think exponential 2000
+ --     class bulk 30
+ --     size histogram 512:20 1024:80
+ --     think uniform 0 10000
+ --
+ -- Sizes are in bytes and think times are in microseconds. The supported
+ -- distributions are "fixed V", "uniform MIN MAX", "zipf S MIN MAX",
+ -- "exponential MEAN" and "histogram V:W ...". Every distribution is turned
+ -- into a discrete alias table when the profile is loaded, so taking a sample
+ -- on the request path costs one random number and a table lookup no matter
+ -- what the shape of the distribution is.
+ */
+
+// Includes
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "workload.h"
+
+#define LINE_SIZE 1024
+
+static int readProfile(FILE *file, workloadProfile *profile, char *error,
+                       size_t errorLength);
+static int checkProfile(workloadProfile *profile, unsigned int maxSize,
+                        char *error, size_t errorLength);
+static int parseDistribution(char *line, distribution *table, char *error,
+                             size_t errorLength);
+static int parsePoints(const char *type, char *rest, unsigned int *values,
+                       double *weights, char *error, size_t errorLength);
+static int buildDistribution(distribution *table, unsigned int *values,
+                             double *weights, unsigned int entries);
+
+/*
+ -- FUNCTION: loadWorkloadProfile
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 18, 2026 - The default think table no longer overwrites
+ -- the first class's weight in the mix.
+ -- October 19, 2026 - The lines are read by readProfile and the classes
+ -- checked by checkProfile, each returning as soon as it fails.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: int loadWorkloadProfile(const char *path,
+ --                                    workloadProfile *profile,
+ --                                    unsigned int maxSize, char *error,
+ --                                    size_t errorLength);
+ --
+ -- RETURNS: 0 on success, -1 on failure with a message in error
+ --
+ -- NOTES:
+ -- Reads the profile file and builds the alias tables for every class and for
+ -- the class mix. Request sizes must be between 1 and maxSize. A class that
+ -- does not give a think time never pauses. A profile that fails to load is
+ -- left empty.
+ */
+int loadWorkloadProfile(const char *path, workloadProfile *profile,
+                        unsigned int maxSize, char *error, size_t errorLength)
+{
+    FILE *file = 0;
+    int result = 0;
+    
+    memset(profile, 0, sizeof(workloadProfile));
+    
+    if ((file = fopen(path, "r")) == NULL)
+    {
+        snprintf(error, errorLength, "Unable to open %s", path);
+        return -1;
+    }
+    
+    result = readProfile(file, profile, error, errorLength);
+    fclose(file);
+    
+    if (result == 0 && profile->classes == 0)
+    {
+        snprintf(error, errorLength, "%s has no classes", path);
+        result = -1;
+    }
+    if (result == 0)
+    {
+        result = checkProfile(profile, maxSize, error, errorLength);
+    }
+    
+    if (result == -1)
+    {
+        freeWorkloadProfile(profile);
+    }
+    
+    return result;
+}
+
+/*
+ -- FUNCTION: readProfile
+ --
+ -- DATE: October 19, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int readProfile(FILE *file, workloadProfile *profile,
+ --                                   char *error, size_t errorLength);
+ --
+ -- RETURNS: 0 on success, -1 on failure with a message in error
+ --
+ -- NOTES:
+ -- Reads the classes of a profile file and the distributions given for
+ -- them. The tables already built are left for the caller to free.
+ */
+static int readProfile(FILE *file, workloadProfile *profile, char *error,
+                       size_t errorLength)
+{
+    char line[LINE_SIZE];
+    char *keyword = 0;
+    char *rest = 0;
+    unsigned int lineNumber = 0;
+    workloadClass *current = 0;
+    distribution *table = 0;
+    
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        lineNumber++;
+        
+        /* Skip blank lines and comments */
+        if ((keyword = strtok_r(line, " \t\r\n", &rest)) == NULL ||
+            keyword[0] == '#')
+        {
+            continue;
+        }
+        
+        if (strcmp(keyword, "class") == 0)
+        {
+            if (profile->classes == WORKLOAD_MAX_CLASSES)
+            {
+                snprintf(error, errorLength, "Line %u: too many classes",
+                         lineNumber);
+                return -1;
+            }
+            current = &profile->classList[profile->classes++];
+            snprintf(current->name, sizeof(current->name), "%s",
+                     (keyword = strtok_r(NULL, " \t\r\n", &rest)) ?
+                     keyword : "default");
+            current->weight = (keyword = strtok_r(NULL, " \t\r\n", &rest)) ?
+                              strtoul(keyword, NULL, 10) : 1;
+            continue;
+        }
+        
+        if (strcmp(keyword, "size") == 0)
+        {
+            table = current ? &current->size : NULL;
+        }
+        else if (strcmp(keyword, "think") == 0)
+        {
+            table = current ? &current->think : NULL;
+        }
+        else
+        {
+            snprintf(error, errorLength, "Line %u: unknown keyword %s",
+                     lineNumber, keyword);
+            return -1;
+        }
+        
+        if (table == NULL)
+        {
+            snprintf(error, errorLength, "Line %u: %s outside of a class",
+                     lineNumber, keyword);
+            return -1;
+        }
+        
+        if (parseDistribution(rest, table, error, errorLength) == -1)
+        {
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: checkProfile
+ --
+ -- DATE: October 19, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int checkProfile(workloadProfile *profile,
+ --                                    unsigned int maxSize, char *error,
+ --                                    size_t errorLength);
+ --
+ -- RETURNS: 0 on success, -1 on failure with a message in error
+ --
+ -- NOTES:
+ -- Checks every class of a profile that has been read, gives the classes
+ -- without a think time one that never pauses and builds the mix table over
+ -- the class weights.
+ */
+static int checkProfile(workloadProfile *profile, unsigned int maxSize,
+                        char *error, size_t errorLength)
+{
+    unsigned int count = 0;
+    unsigned int noThink = 0;
+    double always = 1;
+    unsigned int values[WORKLOAD_MAX_CLASSES];
+    double weights[WORKLOAD_MAX_CLASSES];
+    workloadClass *current = 0;
+    
+    for (count = 0; count < profile->classes; count++)
+    {
+        current = &profile->classList[count];
+        if (current->size.entries == 0)
+        {
+            snprintf(error, errorLength, "Class %s has no size", current->name);
+            return -1;
+        }
+        if (current->size.values[0] < 1 ||
+            current->size.values[current->size.entries - 1] > maxSize)
+        {
+            snprintf(error, errorLength, "Class %s sizes must be 1 to %u",
+                     current->name, maxSize);
+            return -1;
+        }
+        if (current->think.entries == 0)
+        {
+            /* Not values and weights, which hold the mix built so far */
+            if (buildDistribution(&current->think, &noThink, &always, 1) == -1)
+            {
+                snprintf(error, errorLength, "Out of memory");
+                return -1;
+            }
+        }
+        values[count] = count;
+        weights[count] = current->weight;
+    }
+    
+    if (buildDistribution(&profile->mix, values, weights,
+                          profile->classes) == -1)
+    {
+        snprintf(error, errorLength, "Class weights must not all be zero");
+        return -1;
+    }
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: freeWorkloadProfile
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: void freeWorkloadProfile(workloadProfile *profile);
+ --
+ -- RETURNS: void
+ --
+ -- NOTES:
+ -- Releases the alias tables held by the profile.
+ */
+void freeWorkloadProfile(workloadProfile *profile)
+{
+    unsigned int count = 0;
+    distribution *tables[2];
+    unsigned int table = 0;
+    
+    for (count = 0; count <= profile->classes; count++)
+    {
+        if (count == profile->classes)
+        {
+            tables[0] = &profile->mix;
+            tables[1] = 0;
+        }
+        else
+        {
+            tables[0] = &profile->classList[count].size;
+            tables[1] = &profile->classList[count].think;
+        }
+        
+        for (table = 0; table < 2 && tables[table] != 0; table++)
+        {
+            free(tables[table]->values);
+            free(tables[table]->threshold);
+            free(tables[table]->alias);
+            memset(tables[table], 0, sizeof(distribution));
+        }
+    }
+    
+    profile->classes = 0;
+}
+
+/*
+ -- FUNCTION: nextRandom
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: unsigned long long nextRandom(unsigned long long *state);
+ --
+ -- RETURNS: the next 64 bit random number
+ --
+ -- NOTES:
+ -- A xorshift64* generator. Each thread keeps its own state, which must not be
+ -- zero, so sampling never takes a lock the way rand() does.
+ */
+unsigned long long nextRandom(unsigned long long *state)
+{
+    unsigned long long x = *state;
+    
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    
+    return x * 2685821657736338717ULL;
+}
+
+/*
+ -- FUNCTION: sampleDistribution
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: unsigned int sampleDistribution(const distribution *table,
+ --                                            unsigned long long *state);
+ --
+ -- RETURNS: a value drawn from the distribution
+ --
+ -- NOTES:
+ -- The low half of one random number picks a column of the alias table and
+ -- the high half decides between the column and its alias.
+ */
+unsigned int sampleDistribution(const distribution *table,
+                                unsigned long long *state)
+{
+    unsigned long long random = nextRandom(state);
+    unsigned int column = ((random & 0xFFFFFFFFULL) * table->entries) >> 32;
+    
+    if ((unsigned int)(random >> 32) < table->threshold[column])
+    {
+        return table->values[column];
+    }
+    
+    return table->values[table->alias[column]];
+}
+
+/*
+ -- FUNCTION: parseDistribution
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: October 19, 2026 - The points are kept on the stack, and the
+ -- description is read by parsePoints.
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int parseDistribution(char *line, distribution *table,
+ --                                         char *error, size_t errorLength);
+ --
+ -- RETURNS: 0 on success, -1 on failure with a message in error
+ --
+ -- NOTES:
+ -- Parses the distribution description that follows a size or think keyword
+ -- and builds the table's alias table from the points it gives, replacing
+ -- any table it had. The points are sorted first so the range can be checked
+ -- from the ends.
+ */
+static int parseDistribution(char *line, distribution *table, char *error,
+                             size_t errorLength)
+{
+    char *rest = 0;
+    char *type = 0;
+    int entries = 0;
+    int count = 0;
+    int index = 0;
+    unsigned int value = 0;
+    double weight = 0;
+    unsigned int values[WORKLOAD_MAX_POINTS];
+    double weights[WORKLOAD_MAX_POINTS];
+    
+    if ((type = strtok_r(line, " \t\r\n", &rest)) == NULL)
+    {
+        snprintf(error, errorLength, "Missing distribution type");
+        return -1;
+    }
+    
+    if ((entries = parsePoints(type, rest, values, weights, error,
+                               errorLength)) == -1)
+    {
+        return -1;
+    }
+    
+    /* Keep the values sorted so the range can be checked from the ends */
+    for (count = 1; count < entries; count++)
+    {
+        value = values[count];
+        weight = weights[count];
+        for (index = count; index > 0 && values[index - 1] > value; index--)
+        {
+            values[index] = values[index - 1];
+            weights[index] = weights[index - 1];
+        }
+        values[index] = value;
+        weights[index] = weight;
+    }
+    
+    free(table->values);
+    free(table->threshold);
+    free(table->alias);
+    memset(table, 0, sizeof(distribution));
+    
+    if (buildDistribution(table, values, weights, entries) == -1)
+    {
+        snprintf(error, errorLength, "Empty %s distribution", type);
+        return -1;
+    }
+    
+    return 0;
+}
+
+/*
+ -- FUNCTION: parsePoints
+ --
+ -- DATE: October 19, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int parsePoints(const char *type, char *rest,
+ --                                   unsigned int *values, double *weights,
+ --                                   char *error, size_t errorLength);
+ --
+ -- RETURNS: the number of points, or -1 on failure with a message in error
+ --
+ -- NOTES:
+ -- Turns a distribution of the given type, with its parameters in rest, into
+ -- up to WORKLOAD_MAX_POINTS weighted points. Ranges wider than that are
+ -- sampled at evenly spaced points and the exponential distribution is
+ -- represented by WORKLOAD_QUANTILES quantiles.
+ */
+static int parsePoints(const char *type, char *rest, unsigned int *values,
+                       double *weights, char *error, size_t errorLength)
+{
+    char *token = 0;
+    double first = 0;
+    double minimum = 0;
+    double maximum = 0;
+    double step = 1;
+    int entries = 0;
+    
+    if (strcmp(type, "fixed") == 0 &&
+        sscanf(rest, "%lf", &first) == 1)
+    {
+        values[0] = first;
+        weights[0] = 1;
+        return 1;
+    }
+    
+    if ((strcmp(type, "uniform") == 0 &&
+         sscanf(rest, "%lf %lf", &minimum, &maximum) == 2) ||
+        (strcmp(type, "zipf") == 0 &&
+         sscanf(rest, "%lf %lf %lf", &first, &minimum, &maximum) == 3))
+    {
+        if (minimum < 0 || maximum < minimum)
+        {
+            snprintf(error, errorLength, "Invalid range for %s", type);
+            return -1;
+        }
+        
+        /* Thin out ranges that are wider than the table allows */
+        if (maximum - minimum + 1 > WORKLOAD_MAX_POINTS)
+        {
+            step = (maximum - minimum) / (WORKLOAD_MAX_POINTS - 1);
+        }
+        
+        for (entries = 0; entries < WORKLOAD_MAX_POINTS &&
+             minimum + entries * step <= maximum; entries++)
+        {
+            values[entries] = minimum + entries * step;
+            
+            /* Zipf gives the smallest value rank one */
+            weights[entries] = (type[0] == 'z') ?
+                               1.0 / pow(entries + 1, first) : 1.0;
+        }
+        return entries;
+    }
+    
+    if (strcmp(type, "exponential") == 0 &&
+        sscanf(rest, "%lf", &first) == 1 && first >= 0)
+    {
+        for (entries = 0; entries < WORKLOAD_QUANTILES; entries++)
+        {
+            values[entries] = -first * log(1.0 - (entries + 0.5) /
+                                           WORKLOAD_QUANTILES);
+            weights[entries] = 1;
+        }
+        return entries;
+    }
+    
+    if (strcmp(type, "histogram") == 0)
+    {
+        while ((token = strtok_r(NULL, " \t\r\n", &rest)) != NULL &&
+               entries < WORKLOAD_MAX_POINTS)
+        {
+            if (sscanf(token, "%lf:%lf", &first, &weights[entries]) != 2 ||
+                first < 0 || weights[entries] < 0)
+            {
+                snprintf(error, errorLength, "Invalid histogram bucket %s",
+                         token);
+                return -1;
+            }
+            values[entries++] = first;
+        }
+        return entries;
+    }
+    
+    snprintf(error, errorLength, "Invalid %s distribution", type);
+    return -1;
+}
+
+/*
+ -- FUNCTION: buildDistribution
+ --
+ -- DATE: October 18, 2026
+ --
+ -- REVISIONS: (Date and Description)
+ --
+ -- DESIGNER: Luke Queenan
+ --
+ -- PROGRAMMER: Luke Queenan
+ --
+ -- INTERFACE: static int buildDistribution(distribution *table,
+ --                                         unsigned int *values,
+ --                                         double *weights,
+ --                                         unsigned int entries);
+ --
+ -- RETURNS: 0 on success, -1 if there is nothing to sample or no memory
+ --
+ -- NOTES:
+ -- Builds the alias table using Vose's method. Each column keeps its own value
+ -- with probability threshold / 2^32 and otherwise gives up its alias.
+ */
+static int buildDistribution(distribution *table, unsigned int *values,
+                             double *weights, unsigned int entries)
+{
+    double total = 0;
+    double *scaled = 0;
+    unsigned int *small = 0;
+    unsigned int *large = 0;
+    unsigned int smallCount = 0;
+    unsigned int largeCount = 0;
+    unsigned int count = 0;
+    unsigned int less = 0;
+    unsigned int more = 0;
+    
+    for (count = 0; count < entries; count++)
+    {
+        total += weights[count];
+    }
+    
+    if (entries == 0 || total <= 0)
+    {
+        return -1;
+    }
+    
+    table->entries = entries;
+    table->values = malloc(sizeof(unsigned int) * entries);
+    table->threshold = malloc(sizeof(unsigned int) * entries);
+    table->alias = malloc(sizeof(unsigned int) * entries);
+    scaled = malloc(sizeof(double) * entries);
+    small = malloc(sizeof(unsigned int) * entries);
+    large = malloc(sizeof(unsigned int) * entries);
+    
+    if (!table->values || !table->threshold || !table->alias || !scaled ||
+        !small || !large)
+    {
+        free(scaled);
+        free(small);
+        free(large);
+        return -1;
+    }
+    
+    /* Scale the weights so the average column holds exactly one */
+    for (count = 0; count < entries; count++)
+    {
+        table->values[count] = values[count];
+        table->alias[count] = count;
+        scaled[count] = weights[count] * entries / total;
+        if (scaled[count] < 1.0)
+        {
+            small[smallCount++] = count;
+        }
+        else
+        {
+            large[largeCount++] = count;
+        }
+    }
+    
+    /* Fill every short column from one of the tall ones */
+    while (smallCount > 0 && largeCount > 0)
+    {
+        less = small[--smallCount];
+        more = large[largeCount - 1];
+        
+        table->threshold[less] = scaled[less] * 4294967295.0;
+        table->alias[less] = more;
+        
+        scaled[more] -= 1.0 - scaled[less];
+        if (scaled[more] < 1.0)
+        {
+            largeCount--;
+            small[smallCount++] = more;
+        }
+    }
+    
+    /* Whatever is left is full, up to rounding error */
+    while (largeCount > 0)
+    {
+        table->threshold[large[--largeCount]] = 0xFFFFFFFF;
+    }
+    while (smallCount > 0)
+    {
+        table->threshold[small[--smallCount]] = 0xFFFFFFFF;
+    }
+    
+    free(scaled);
+    free(small);
+    free(large);
+    
+    return 0;
+}
@@ -0,0 +1,52 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <stddef.h>
+
+/* Defines */
+#define WORKLOAD_MAX_CLASSES 16
+#define WORKLOAD_NAME_SIZE 32
+#define WORKLOAD_MAX_POINTS 4096
+#define WORKLOAD_QUANTILES 1024
+
+/* A discrete distribution sampled through an alias table */
+typedef struct
+{
+    unsigned int entries;
+    unsigned int *values;
+    unsigned int *threshold;
+    unsigned int *alias;
+} distribution;
+
+/* A class of connection with its own request size and think time */
+typedef struct
+{
+    char name[WORKLOAD_NAME_SIZE];
+    unsigned int weight;
+    distribution size;
+    distribution think;
+} workloadClass;
+
+/* A full workload made up of a weighted mix of connection classes */
+typedef struct
+{
+    unsigned int classes;
+    workloadClass classList[WORKLOAD_MAX_CLASSES];
+    distribution mix;
+} workloadProfile;
+
+/* Function Prototypes */
+#ifdef __cplusplus
+extern "C" {
+#endif
+    int loadWorkloadProfile(const char *path, workloadProfile *profile,
+                            unsigned int maxSize, char *error,
+                            size_t errorLength);
+    void freeWorkloadProfile(workloadProfile *profile);
+    unsigned long long nextRandom(unsigned long long *state);
+    unsigned int sampleDistribution(const distribution *table,
+                                    unsigned long long *state);
+#ifdef __cplusplus
+}
+#endif
+#endif